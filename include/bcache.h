@@ -0,0 +1,141 @@
+// include/bcache.h
+#ifndef BCACHE_H
+#define BCACHE_H
+
+#include <stdint.h>
+
+// Buffer cache for block devices.
+//
+// Device sectors are cached in blocks of several sectors. A block is
+// found by hashing (device, block number), so a lookup costs the same
+// however large the cache is, and a request for consecutive sectors
+// costs one lookup per block instead of one per sector. Blocks sit on an
+// intrusive LRU list; the least recently used one is recycled on a miss,
+// after being written back if it is dirty. A miss reads the whole block
+// in one device request.
+//
+// Writes only dirty the cache. A flusher task writes back blocks that
+// have been dirty for a while, in sector order, merging neighbouring
+// blocks into one device request. When too much of the cache is dirty
+// the flusher is woken early, and past a hard limit the writer itself
+// writes back before it continues.
+//
+// Reads are followed per stream. A read that starts where an earlier one
+// ended is sequential; the cache then reads ahead of it, with a window
+// that doubles on every sequential read up to a limit, as large
+// multi-sector requests. The next window is fetched when the reader is
+// halfway through the current one, so it never waits on the device.
+//
+// Which block is recycled is up to a replacement policy: plain LRU, or
+// 2Q, which keeps blocks used only once apart so that one long scan
+// cannot push out the blocks in regular use. Blocks read or written as
+// file system metadata are kept apart from both and are recycled only
+// beyond their share of the cache.
+
+#define BCACHE_SECTOR_SIZE 512
+
+// Block size used unless fs code asks for another (power of two)
+#define BCACHE_DEFAULT_BLOCK_SIZE 4096
+#define BCACHE_MAX_BLOCK_SIZE 65536
+
+// Capacity chosen at boot: a share of the free heap, raised to
+// BCACHE_RA_BLOCKS if a quarter of the heap holds that, within limits
+#define BCACHE_MEMORY_SHARE 16   // 1/16 of free kmalloc memory
+#define BCACHE_MIN_BLOCKS 16
+#define BCACHE_MAX_BLOCKS 1024
+
+// Write-back
+#define BCACHE_FLUSH_INTERVAL_MS 1000   // Flusher period
+#define BCACHE_DIRTY_EXPIRE_MS 3000     // Age at which dirty blocks are written
+#define BCACHE_DIRTY_BACKGROUND 25      // % dirty that wakes the flusher early
+#define BCACHE_DIRTY_RATIO 50           // % dirty at which writers are throttled
+#define BCACHE_MAX_WRITE_SIZE 65536     // Largest merged write request
+
+// Read-ahead
+#define BCACHE_RA_STREAMS 8             // Sequential readers tracked at once
+#define BCACHE_RA_MIN 4096              // First window
+#define BCACHE_RA_MAX 131072            // Largest window
+
+// Blocks a cache needs for read-ahead, limited to a quarter of it, to
+// reach BCACHE_RA_MAX; a cache sized from free memory gets at least this
+#define BCACHE_RA_BLOCKS(block_size) (BCACHE_RA_MAX * 4 / (block_size))
+
+// Replacement policies
+#define BCACHE_POLICY_LRU 0
+#define BCACHE_POLICY_2Q 1
+#define BCACHE_POLICIES 2
+
+// Share of the cache (%) metadata keeps before it competes with data
+#define BCACHE_META_SHARE 25
+
+// Devices
+#define BCACHE_DEV_STORAGE 0                 // HAL storage (RAM disk)
+#define BCACHE_DEV_ATA(drive) (1 + (drive))  // ATA drives 0-3
+#define BCACHE_MAX_DEVICES 5
+
+typedef struct {
+    uint32_t hits;               // Block lookups found in the cache
+    uint32_t misses;             // Block lookups that had to go to the device
+    uint32_t evictions;          // Valid blocks recycled for another block
+    uint32_t flushes;            // Dirty blocks written back
+    uint32_t dev_reads;          // Read requests sent to devices
+    uint32_t dev_writes;         // Write requests sent to devices
+    uint32_t wb_runs;            // Write-back passes
+    uint32_t wb_blocks;          // Blocks they wrote
+    uint32_t wb_requests;        // Device requests they needed
+    uint32_t wb_last_blocks;     // Last pass: blocks written
+    uint32_t wb_last_requests;   // Last pass: device requests
+    uint32_t wb_last_us;         // Last pass: time taken
+    uint32_t throttled;          // Writes that had to write back first
+    uint32_t ra_requests;        // Read-ahead device requests
+    uint32_t ra_blocks;          // Blocks read ahead
+    uint32_t ra_hits;            // ... that were then read
+    uint32_t ra_waste;           // ... that were evicted unread
+    uint32_t block_size;
+    uint32_t capacity;           // Blocks
+    int policy;                  // BCACHE_POLICY_*
+    uint32_t meta;               // Blocks holding metadata
+    uint32_t clean;              // Blocks holding clean data
+    uint32_t dirty;              // Blocks waiting for write-back
+} bcache_stats_t;
+
+// A cached block, for diagnostics
+typedef struct {
+    uint32_t dev;
+    uint32_t sector;             // First sector of the block
+    uint32_t access_count;
+    int dirty;
+} bcache_block_info_t;
+
+// Set up the cache. A capacity of 0 sizes it from free memory. Calling it
+// again writes back dirty blocks and rebuilds the cache. Returns 0 or -1.
+int bcache_init(uint32_t block_size, uint32_t capacity);
+
+// Read or write count sectors starting at sector; returns 0 or -1
+int bcache_read(uint32_t dev, uint32_t sector, void* buffer, uint32_t count);
+int bcache_write(uint32_t dev, uint32_t sector, const void* buffer, uint32_t count);
+
+// The same for file system metadata (superblocks, tables, directories)
+int bcache_read_meta(uint32_t dev, uint32_t sector, void* buffer, uint32_t count);
+int bcache_write_meta(uint32_t dev, uint32_t sector, const void* buffer, uint32_t count);
+
+// Write back every dirty block; returns 0 or -1 if any write failed
+int bcache_sync(void);
+
+// Start the flusher task (needs the task runtime)
+void bcache_start_flusher(void);
+
+// Switch replacement policy, keeping the cached blocks. Hit and miss
+// counts restart so the policies can be compared. Returns 0 or -1.
+int bcache_set_policy(int policy);
+int bcache_get_policy(void);
+
+// Short name of a policy ("lru", "2q"); NULL if there is none
+const char* bcache_policy_name(int policy);
+
+void bcache_get_stats(bcache_stats_t* stats);
+
+// Fill info[] with up to max blocks, most accessed first; returns the count
+int bcache_top_blocks(bcache_block_info_t* info, int max);
+
+#endif // BCACHE_H
@@ -0,0 +1,126 @@
+// include/channel.h
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <stdint.h>
+#include "wait_queue.h"
+
+// Named message channels between processes.
+//
+// A channel is a ring of fixed-size slots in pages that both ends (and
+// CPL 3 code) can reach directly. Senders fill the slot at tail and move
+// tail; receivers read the slot at head and move head. No trap is needed
+// per message: a sender calls SYS_CHANNEL_NOTIFY only when its message
+// made the ring non-empty, and a receiver only when it made a full ring
+// non-full. Everyone else keeps running on the shared indices.
+//
+// Payloads larger than a slot travel as whole pages. The sender hands the
+// pages of a buffer to the slot it is about to publish; the receiver takes
+// them at an address of its choosing. The frames move, the bytes do not.
+
+// Channels in the system
+#define CHANNEL_MAX         16
+
+// Longest name including the NUL
+#define CHANNEL_NAME_MAX    16
+
+// Largest ring
+#define CHANNEL_MAX_SLOTS   256
+
+// Inline payload per slot
+#define CHANNEL_SLOT_DATA   56
+
+// Pages one message can carry
+#define CHANNEL_MAX_PAGES   16
+
+// Slot flags
+#define CHANNEL_SLOT_PAGES  0x0001       // Payload is in attached pages
+
+// SYS_CHANNEL_WAIT conditions
+#define CHANNEL_WAIT_DATA   0            // Until a message is queued
+#define CHANNEL_WAIT_SPACE  1            // Until a slot is free
+
+// SYS_CHANNEL_PAGES operations
+#define CHANNEL_PAGES_ATTACH 0           // Give pages to the slot at tail
+#define CHANNEL_PAGES_TAKE   1           // Map the pages of the slot at head
+
+// One message
+typedef struct {
+    uint32_t len;                    // Bytes in data[] or in the pages
+    uint16_t flags;                  // CHANNEL_SLOT_*
+    uint16_t pages;                  // Pages attached
+    uint8_t data[CHANNEL_SLOT_DATA];
+} channel_slot_t;
+
+// Shared area, page aligned
+typedef struct {
+    volatile uint32_t head;          // Next slot receivers read
+    volatile uint32_t tail;          // Next slot senders fill
+    uint32_t slots;                  // Ring size (power of two)
+    uint32_t notifies;               // SYS_CHANNEL_NOTIFY calls
+    uint32_t reserved[12];
+    channel_slot_t ring[];
+} channel_shared_t;
+
+// Syscall back ends. channel_open() creates the channel when slots is
+// non-zero and opens an existing one when it is zero.
+int channel_open(const char* name, uint32_t slots, channel_shared_t** shared_out);
+int channel_notify(int fd);
+int channel_wait(int fd, uint32_t condition, uint32_t timeout_ms);
+int channel_pages(int fd, uint32_t op, uint32_t addr, uint32_t len);
+
+// Kernel side page transfer: frames are page_frame_alloc() pages, used
+// through their identity mapping. Attach gives count frames to the slot
+// at tail; take fills frames[] from the slot at head and returns the count.
+int channel_attach_frames(int fd, const uint32_t* frames, uint32_t count, uint32_t len);
+int channel_take_frames(int fd, uint32_t* frames);
+
+// Queue woken by notifications, for tasks (TASK_WAIT_EVENT)
+wait_queue_t* channel_wait_queue(int fd);
+
+// Process side helpers
+
+static inline int channel_empty(const channel_shared_t* ch) {
+    return ch->head == ch->tail;
+}
+
+static inline int channel_full(const channel_shared_t* ch) {
+    return ch->tail - ch->head >= ch->slots;
+}
+
+// Slot to fill next, or NULL if the ring is full
+static inline channel_slot_t* channel_get_slot(channel_shared_t* ch) {
+    if (channel_full(ch)) {
+        return 0;
+    }
+    return &ch->ring[ch->tail & (ch->slots - 1)];
+}
+
+// Publish the slot from channel_get_slot(); returns 1 if the ring was
+// empty, in which case the sender must call SYS_CHANNEL_NOTIFY
+static inline int channel_publish(channel_shared_t* ch) {
+    int was_empty = channel_empty(ch);
+    asm volatile("" : : : "memory");
+    ch->tail++;
+    return was_empty;
+}
+
+// Oldest message, or NULL if none
+static inline channel_slot_t* channel_peek(channel_shared_t* ch) {
+    if (channel_empty(ch)) {
+        return 0;
+    }
+    asm volatile("" : : : "memory");
+    return &ch->ring[ch->head & (ch->slots - 1)];
+}
+
+// Release the slot from channel_peek(); returns 1 if the ring was full,
+// in which case the receiver must call SYS_CHANNEL_NOTIFY
+static inline int channel_consume(channel_shared_t* ch) {
+    int was_full = channel_full(ch);
+    asm volatile("" : : : "memory");
+    ch->head++;
+    return was_full;
+}
+
+#endif // CHANNEL_H
@@ -0,0 +1,84 @@
+// include/cpu.h
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+// CPUID leaf 1 EDX feature bits
+#define CPU_FEATURE_TSC  (1 << 4)
+#define CPU_FEATURE_MSR  (1 << 5)
+#define CPU_FEATURE_PSE  (1 << 3)
+#define CPU_FEATURE_APIC (1 << 9)
+#define CPU_FEATURE_SEP  (1 << 11)
+
+// Execute CPUID
+static inline void cpu_cpuid(uint32_t leaf, uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    asm volatile("cpuid"
+                 : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                 : "a"(leaf), "c"(0));
+}
+
+// Get the CPUID leaf 1 EDX feature flags
+static inline uint32_t cpu_features(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(1, &eax, &ebx, &ecx, &edx);
+    return edx;
+}
+
+// Faulting address of the last page fault
+static inline uint32_t cpu_read_cr2(void) {
+    uint32_t value;
+    asm volatile("mov %%cr2, %0" : "=r"(value));
+    return value;
+}
+
+// Drop the TLB entry for one page
+static inline void cpu_invlpg(uint32_t addr) {
+    asm volatile("invlpg (%0)" : : "r"(addr) : "memory");
+}
+
+// Read the time stamp counter (always inlined: user code uses it too)
+static inline __attribute__((always_inline)) uint64_t cpu_read_tsc(void) {
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// Read a model-specific register
+static inline uint64_t cpu_read_msr(uint32_t msr) {
+    uint32_t lo, hi;
+    asm volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+// Write a model-specific register
+static inline void cpu_write_msr(uint32_t msr, uint64_t value) {
+    asm volatile("wrmsr" : : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+// Divide a 64-bit value by a 32-bit divisor without libgcc helpers.
+// Returns the quotient and stores the remainder if rem is non-NULL.
+static inline uint64_t cpu_div64_32(uint64_t dividend, uint32_t divisor, uint32_t* rem) {
+    uint32_t hi = (uint32_t)(dividend >> 32);
+    uint32_t lo = (uint32_t)dividend;
+    uint32_t q_hi = hi / divisor;
+    uint32_t r = hi % divisor;
+    uint32_t q_lo;
+    
+    // EDX:EAX / divisor; EDX < divisor so the quotient fits in 32 bits
+    asm("divl %4" : "=a"(q_lo), "=d"(r) : "a"(lo), "d"(r), "rm"(divisor));
+    
+    if (rem) {
+        *rem = r;
+    }
+    return ((uint64_t)q_hi << 32) | q_lo;
+}
+
+// Compute (value * mult) >> shift (shift 1..32) without a 96-bit product
+static inline __attribute__((always_inline)) uint64_t cpu_mul_u64_u32_shr(uint64_t value, uint32_t mult, uint32_t shift) {
+    uint64_t lo = (uint64_t)(uint32_t)value * mult;
+    uint64_t hi = (value >> 32) * mult;
+    return (hi << (32 - shift)) + (lo >> shift);
+}
+
+#endif // CPU_H
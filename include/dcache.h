@@ -0,0 +1,47 @@
+// include/dcache.h
+#ifndef DCACHE_H
+#define DCACHE_H
+
+#include <stdint.h>
+
+// Directory entry cache for path resolution.
+//
+// Maps (parent node index, component name) to the node index of the
+// child, so resolving a path costs one hash probe per component instead
+// of a scan of the node table. Names known not to exist are cached too
+// (negative entries), which makes repeated failing lookups just as cheap.
+// Entries are recycled least recently used first.
+
+// Cached names
+#define DCACHE_ENTRIES 128
+
+// Hash chains (power of two)
+#define DCACHE_BUCKETS 64
+
+// Node index stored by a negative entry
+#define DCACHE_NEGATIVE (-1)
+
+typedef struct {
+    uint32_t hits;                   // Lookups answered by the cache
+    uint32_t negative_hits;          // ... of which said "does not exist"
+    uint32_t misses;                 // Lookups that had to scan the table
+    uint32_t evictions;              // Entries recycled for a new name
+    uint32_t entries;                // Entries in use
+} dcache_stats_t;
+
+// Empty the cache and reset its statistics
+void dcache_init(void);
+
+// Look up a name in a directory. Returns 1 and sets *index (a node index
+// or DCACHE_NEGATIVE) on a hit, 0 on a miss.
+int dcache_lookup(int parent, const char* name, int* index);
+
+// Record what a name resolves to, replacing any entry for it
+void dcache_insert(int parent, const char* name, int index);
+
+// Drop every entry (after the node table was changed behind our back)
+void dcache_flush(void);
+
+void dcache_get_stats(dcache_stats_t* stats);
+
+#endif // DCACHE_H
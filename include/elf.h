@@ -0,0 +1,95 @@
+// include/elf.h
+#ifndef ELF_H
+#define ELF_H
+
+#include <stdint.h>
+#include "memory.h"
+
+// ELF32 executables for SYS_EXEC.
+//
+// Programs are static i386 ET_EXEC images linked inside the user window
+// (memory.h). Loading reads only the headers: each PT_LOAD segment
+// becomes a demand-paged region (vm.h), so text and data are read from
+// the file when first touched and BSS is zero filled the same way.
+//
+// The entry point is called as int entry(char** argv) at CPL 3 with a
+// NULL-terminated argv on its stack. The vDSO page is mapped at
+// VDSO_USER_ADDR (vdso.h); segments must end below it. Returning from it is the same as
+// SYS_EXIT. SYS_EXEC runs the program to completion and returns its exit
+// status; the scheduler does not switch stacks yet.
+
+#define ELF_MAGIC      0x464C457F    // "\x7FELF"
+#define ELF_CLASS32    1
+#define ELF_DATA2LSB   1
+#define ELF_ET_EXEC    2
+#define ELF_EM_386     3
+
+#define ELF_PT_LOAD    1
+#define ELF_PF_X       0x1
+#define ELF_PF_W       0x2
+#define ELF_PF_R       0x4
+
+// Program headers accepted per image
+#define ELF_MAX_PHDRS  16
+
+// Stack given to a program
+#define EXEC_STACK_TOP  USER_TOP
+#define EXEC_STACK_SIZE 0x10000
+
+// Argument limits for SYS_EXEC
+#define EXEC_MAX_ARGS   8
+#define EXEC_MAX_ARGLEN 64
+
+// Exit status of a program ended by a fault
+#define EXEC_STATUS_FAULT -1
+
+typedef struct {
+    uint32_t e_magic;
+    uint8_t e_class;
+    uint8_t e_data;
+    uint8_t e_version_ident;
+    uint8_t e_pad[9];
+    uint16_t e_type;
+    uint16_t e_machine;
+    uint32_t e_version;
+    uint32_t e_entry;
+    uint32_t e_phoff;
+    uint32_t e_shoff;
+    uint32_t e_flags;
+    uint16_t e_ehsize;
+    uint16_t e_phentsize;
+    uint16_t e_phnum;
+    uint16_t e_shentsize;
+    uint16_t e_shnum;
+    uint16_t e_shstrndx;
+} elf32_ehdr_t;
+
+typedef struct {
+    uint32_t p_type;
+    uint32_t p_offset;
+    uint32_t p_vaddr;
+    uint32_t p_paddr;
+    uint32_t p_filesz;
+    uint32_t p_memsz;
+    uint32_t p_flags;
+    uint32_t p_align;
+} elf32_phdr_t;
+
+struct regs;
+
+// Load and run a program; argv holds kernel strings and may be NULL.
+// Returns its exit status or a SYSCALL_E* code if it could not start.
+int elf_exec(const char* path, char* const argv[]);
+
+// SYS_EXIT from the running program: end it and return status from
+// elf_exec(). Returns only if the call did not come from that program.
+void elf_exec_exit(int status);
+
+// Nonzero while a program runs; its process must stay current
+int elf_exec_running(void);
+
+// Exception raised at CPL 3: end the running program. Returns only if
+// there is none.
+void elf_exec_fault(struct regs* r);
+
+#endif // ELF_H
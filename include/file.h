@@ -0,0 +1,106 @@
+// include/file.h
+#ifndef FILE_H
+#define FILE_H
+
+#include <stdint.h>
+#include "fs.h"
+#include "wait_queue.h"
+
+// Open-file objects and per-process descriptor tables.
+//
+// A descriptor indexes the process's fds[] array, which points to a
+// shared, reference-counted file_t. The file_t holds the offset, the open
+// flags and the resolved fs node, so I/O on an open descriptor never walks
+// the path again.
+
+// Open-file objects in the system
+#define FILE_MAX_OPEN 128
+
+// Descriptors per process
+#define PROCESS_MAX_FDS 16
+
+// Open flags
+#define O_RDONLY  0x0000
+#define O_WRONLY  0x0001
+#define O_RDWR    0x0002
+#define O_ACCMODE 0x0003
+#define O_CREAT   0x0040
+#define O_TRUNC   0x0200
+#define O_APPEND  0x0400
+
+// Seek origins
+#define SEEK_SET 0
+#define SEEK_CUR 1
+#define SEEK_END 2
+
+// File object types
+#define FILE_TYPE_CONSOLE 1
+#define FILE_TYPE_NODE    2
+#define FILE_TYPE_IORING  3
+#define FILE_TYPE_CHANNEL 4
+#define FILE_TYPE_POLLSET 5
+
+struct file;
+
+// Per-type operations; return bytes transferred or a SYSCALL_E* code
+typedef struct {
+    int (*read)(struct file* file, void* buffer, uint32_t count);
+    int (*write)(struct file* file, const void* buffer, uint32_t count);
+    void (*release)(struct file* file);  // Last reference dropped
+    // Ready POLL_* bits now, and the queue woken when they may change
+    // (NULL: poll again on every wait)
+    uint32_t (*poll)(struct file* file, wait_queue_t** wq);
+} file_ops_t;
+
+// Open file
+typedef struct file {
+    uint32_t refcount;               // Descriptors pointing here (0 = free)
+    uint32_t type;                   // FILE_TYPE_*
+    uint32_t flags;                  // O_* flags it was opened with
+    uint32_t offset;                 // Current position
+    fs_node_t* node;                 // Resolved node (FILE_TYPE_NODE)
+    void* private_data;              // Owned by the type's ops
+    const file_ops_t* ops;
+} file_t;
+
+// Open a path; returns a new file object or NULL with *error set
+file_t* file_open(const char* path, uint32_t flags, int* error);
+
+// Wrap a kernel object in a new file object (reads and writes go to ops)
+file_t* file_create(uint32_t type, uint32_t flags, const file_ops_t* ops, void* private_data);
+
+// The shared console file behind descriptors 0-2
+file_t* file_console(void);
+
+// Take and drop references
+void file_get(file_t* file);
+void file_put(file_t* file);
+
+// I/O at the current offset
+int file_read(file_t* file, void* buffer, uint32_t count);
+int file_write(file_t* file, const void* buffer, uint32_t count);
+
+// I/O at an explicit offset, leaving the file offset alone. Files
+// without offsets (the console) ignore it.
+int file_pread(file_t* file, void* buffer, uint32_t count, uint32_t offset);
+int file_pwrite(file_t* file, const void* buffer, uint32_t count, uint32_t offset);
+
+// Ready POLL_* bits; files without a poll op are always readable and
+// writable
+uint32_t file_poll(file_t* file, wait_queue_t** wq);
+
+// Move the offset; returns the new offset or a SYSCALL_E* code
+int file_seek(file_t* file, int offset, int whence);
+
+// Descriptor tables (operate on the current process)
+int fd_install(file_t* file);
+file_t* fd_get(int fd);
+int fd_close(int fd);
+
+// Give a new process stdin/stdout/stderr on the console
+void fd_table_init(file_t** fds);
+
+// Close every descriptor in a table
+void fd_table_close_all(file_t** fds);
+
+#endif // FILE_H
@@ -3,27 +3,42 @@
 #define FS_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #define FS_MAX_FILES 64         // Increased max files
 #define FS_MAX_FILENAME 32
 #define FS_MAX_PATH 128         // Added max path length
-#define FS_MAX_FILESIZE 8192    // Increased max file size
+#define FS_MAX_FILESIZE 0x40000000  // Files may be sparse up to 1GB
+
+// File data lives in pages from the page frame allocator
+#define FS_PAGE_SIZE 4096
 
 // File types
 #define FS_TYPE_FILE 1
 #define FS_TYPE_DIRECTORY 2
 
+// A run of file pages backed by physically contiguous frames
+typedef struct {
+    uint32_t page;               // First file page (offset / FS_PAGE_SIZE)
+    uint32_t count;              // Pages in the run
+    uint32_t frame;              // Address of the first frame
+} fs_extent_t;
+
 typedef struct {
     char name[FS_MAX_FILENAME];  // Name (not full path)
     char path[FS_MAX_PATH];      // Full path
     int type;                    // File or directory
-    char data[FS_MAX_FILESIZE];  // File data (only for files)
+    fs_extent_t* extents;        // Sorted by page; holes read as zeros
+    uint32_t extent_count;
+    uint32_t extent_capacity;
+    uint32_t pages;              // Frames allocated to the file
     size_t size;                 // Size (for files)
     int parent_index;            // Index of parent directory (-1 for root)
     int in_use;                  // Whether this entry is in use
     unsigned int permissions;    // Basic permissions (owner, group, world)
     unsigned int created_time;   // Creation timestamp
     unsigned int modified_time;  // Last modification timestamp
+    int open_count;              // Open file objects using this node
 } fs_node_t;
 
 // Initialize file system
@@ -59,4 +74,24 @@ const char* fs_getcwd(void);
 // Get info about a file or directory
 int fs_stat(const char* path, fs_node_t* info);
 
+// Write back dirty cached blocks
+int fs_sync(void);
+
+// Print buffer cache and file data statistics
+void fs_display_cache_info(void);
+
+// Resolve a path (absolute or relative to the current directory) to its
+// node; NULL if it does not exist
+fs_node_t* fs_lookup(const char* path);
+
+// Read from a file node at an offset; returns bytes read (0 at the end)
+int fs_node_read(fs_node_t* node, uint32_t offset, void* buffer, size_t size);
+
+// Write to a file node at an offset, growing it as needed; returns bytes
+// written
+int fs_node_write(fs_node_t* node, uint32_t offset, const void* data, size_t size);
+
+// Set the size of a file node
+int fs_node_truncate(fs_node_t* node, size_t size);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+// include/gdt.h
+#ifndef GDT_H
+#define GDT_H
+
+#include <stdint.h>
+
+// Segment selectors. SYSENTER/SYSEXIT derive the kernel stack segment
+// and both user segments from GDT_KERNEL_CODE, so this order is fixed.
+#define GDT_KERNEL_CODE 0x08
+#define GDT_KERNEL_DATA 0x10
+#define GDT_USER_CODE   0x1B         // 0x18 | RPL 3
+#define GDT_USER_DATA   0x23         // 0x20 | RPL 3
+#define GDT_TSS         0x28
+
+// Size of the stack used on entry from user mode
+#define GDT_TRAP_STACK_SIZE 16384
+
+// Load the kernel GDT (flat kernel and user segments plus a TSS) and
+// reload every segment register
+void gdt_init(void);
+
+// Set the stack the CPU switches to on an interrupt from user mode
+void gdt_set_kernel_stack(uint32_t esp0);
+
+// Top of the default user-to-kernel entry stack
+uint32_t gdt_trap_stack_top(void);
+
+#endif // GDT_H
@@ -43,7 +43,6 @@ typedef struct hal_device_t {
 uint32_t hal_timer_get_ticks(void);
 void hal_timer_sleep(uint32_t ms);
 void hal_timer_register_callback(void (*callback)(void));
-void hal_timer_poll(void);
 
 // HAL keyboard device functions
 int hal_keyboard_read(void);
@@ -94,6 +93,8 @@ int hal_storage_read(uint32_t offset, void* buffer, uint32_t size);
 int hal_storage_write(uint32_t offset, const void* buffer, uint32_t size);
 int hal_storage_read_sector(uint32_t sector, void* buffer);
 int hal_storage_write_sector(uint32_t sector, const void* buffer);
+uint32_t hal_storage_get_sector_size(void);
+uint32_t hal_storage_get_total_sectors(void);
 
 // HAL ATA device functions
 void hal_ata_init(void);
@@ -3,6 +3,7 @@
 #define HAL_KEYBOARD_H
 
 #include <stdint.h>
+#include "wait_queue.h"
 
 // Key codes
 #define KEY_ESC     0x01
@@ -74,9 +75,47 @@
 #define KEY_F9      0x43
 #define KEY_F10     0x44
 
+// Keycodes for keys without a set-1 make code of their own (E0-prefixed)
+#define KEY_F11     0x57
+#define KEY_F12     0x58
+#define KEY_UP      0x60
+#define KEY_DOWN    0x61
+#define KEY_LEFT    0x62
+#define KEY_RIGHT   0x63
+#define KEY_HOME    0x64
+#define KEY_END     0x65
+#define KEY_PGUP    0x66
+#define KEY_PGDN    0x67
+#define KEY_INSERT  0x68
+#define KEY_DELETE  0x69
+#define KEY_RCTRL   0x6A
+#define KEY_RALT    0x6B
+#define KEY_KPENTER 0x6C
+#define KEY_KPSLASH 0x6D
+
 // Special key flag (for key release)
 #define KEY_RELEASE 0x80
 
+// Key event flags
+#define KEY_EVENT_RELEASE  0x01      // Key was released
+#define KEY_EVENT_EXTENDED 0x02      // Scancode had an E0 prefix
+#define KEY_EVENT_SHIFT    0x04      // Shift held
+#define KEY_EVENT_CTRL     0x08      // Ctrl held
+#define KEY_EVENT_ALT      0x10      // Alt held
+#define KEY_EVENT_CAPS     0x20      // Caps Lock on
+
+// Keyboard ring size (power of two)
+#define KEYBOARD_RING_SIZE 256
+
+// A translated key event
+typedef struct {
+    uint64_t timestamp_ns;           // hal_timer_get_ns() when the IRQ arrived
+    uint8_t scancode;                // Raw set-1 code, release bit included
+    uint8_t keycode;                 // KEY_* code
+    uint8_t flags;                   // KEY_EVENT_* flags
+    char ascii;                      // Translated character, 0 if none
+} key_event_t;
+
 // Initialize the keyboard subsystem
 int hal_keyboard_init(void);
 
@@ -91,26 +130,27 @@ int hal_keyboard_is_key_available(void);
 // Poll the keyboard hardware (used in polling mode)
 void hal_keyboard_poll(void);
 
-// Convert scancode to ASCII character
+// Take the next key event; returns 1 if one was available, 0 otherwise
+int hal_keyboard_read_event(key_event_t* event);
+
+// Wait (halting the CPU) until a key event is available and take it
+void hal_keyboard_wait_event(key_event_t* event);
+
+// Wait queue woken whenever a key event is queued
+wait_queue_t* hal_keyboard_wait_queue(void);
+
+// Number of events dropped because the ring was full
+uint32_t hal_keyboard_dropped(void);
+
+// Translate a keycode to ASCII given KEY_EVENT_* modifier flags
+char hal_keyboard_keycode_to_ascii(uint8_t keycode, uint8_t flags);
+
+// Convert scancode to ASCII character (unshifted)
 static inline char hal_keyboard_scancode_to_ascii(int scancode) {
-    // Remove release bit if present
-    scancode &= ~KEY_RELEASE;
-    
-    // Basic scancode to ASCII mapping
-    static const char ascii_table[128] = {
-        0, 0, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b',
-        '\t', 'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '[', ']', '\n',
-        0, 'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ';', '\'', '`',
-        0, '\\', 'z', 'x', 'c', 'v', 'b', 'n', 'm', ',', '.', '/', 0,
-        '*', 0, ' '
-    };
-    
-    // Return ASCII character if in range
-    if (scancode < 0 || scancode >= 128) {
+    if (scancode < 0 || scancode >= 256) {
         return 0;
     }
-    
-    return ascii_table[scancode];
+    return hal_keyboard_keycode_to_ascii(scancode & ~KEY_RELEASE, 0);
 }
 
-#endif // HAL_KEYBOARD_H
\ No newline at end of file
+#endif // HAL_KEYBOARD_H
@@ -3,6 +3,7 @@
 #define HAL_MOUSE_H
 
 #include <stdint.h>
+#include "wait_queue.h"
 
 // Add this to include/hal.h (device types section)
 // #define HAL_DEVICE_MOUSE 6
@@ -70,4 +71,10 @@ int mouse_unregister_handler(mouse_event_handler_t handler);
 // Poll for mouse updates
 void mouse_update(void);
 
+// Nonzero if mouse_update() has motion to deliver
+int mouse_pending(void);
+
+// Queue woken when motion is queued; NULL while the mouse is polled
+wait_queue_t* mouse_wait_queue(void);
+
 #endif // HAL_MOUSE_H
\ No newline at end of file
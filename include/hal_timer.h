@@ -4,15 +4,52 @@
 
 #include <stdint.h>
 
+// Default tick rate of the PIT (IRQ0); override with -DHZ=<rate>
+#ifndef HZ
+#define HZ 100
+#endif
+
+// Supported tick rate range
+#define HAL_TIMER_HZ_MIN 100
+#define HAL_TIMER_HZ_MAX 1000
+
+#if HZ < HAL_TIMER_HZ_MIN || HZ > HAL_TIMER_HZ_MAX
+#error "HZ must be between 100 and 1000"
+#endif
+
+// PIT input clock in Hz
+#define PIT_BASE_FREQUENCY 1193182
+
 // Initialize the timer subsystem
 int hal_timer_init(void);
 
 // Get the current number of timer ticks
 uint32_t hal_timer_get_ticks(void);
 
+// Get the monotonic clock in nanoseconds since the timer started
+uint64_t hal_timer_get_ns(void);
+
+// Get the current tick rate in Hz
+uint32_t hal_timer_get_frequency(void);
+
+// Reprogram the tick rate (clamped to HAL_TIMER_HZ_MIN..MAX)
+int hal_timer_set_frequency(uint32_t hz);
+
+// Convert milliseconds to ticks at the current rate, rounding up
+uint32_t hal_timer_ms_to_ticks(uint32_t ms);
+
+// Get the calibrated TSC frequency in kHz (0 if unavailable)
+uint32_t hal_timer_tsc_khz(void);
+
+// Convert a TSC cycle count to nanoseconds
+uint64_t hal_timer_tsc_to_ns(uint64_t cycles);
+
 // Sleep for the specified number of milliseconds
 void hal_timer_sleep(uint32_t ms);
 
+// Sleep for the specified number of microseconds
+void hal_timer_usleep(uint32_t us);
+
 // Delay for the specified number of milliseconds
 // (Alias for hal_timer_sleep with a different name)
 static inline void hal_timer_delay(uint32_t ms) {
@@ -22,7 +59,4 @@ static inline void hal_timer_delay(uint32_t ms) {
 // Register a callback function to be called on each timer tick
 void hal_timer_register_callback(void (*callback)(void));
 
-// Poll the timer hardware (used in polling mode)
-void hal_timer_poll(void);
-
-#endif // HAL_TIMER_H
\ No newline at end of file
+#endif // HAL_TIMER_H
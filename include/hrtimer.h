@@ -0,0 +1,65 @@
+// include/hrtimer.h
+#ifndef HRTIMER_H
+#define HRTIMER_H
+
+#include <stdint.h>
+
+// High-resolution one-shot timers.
+//
+// Timers are kept in a min-heap of absolute deadlines on the
+// hal_timer_get_ns() clock. The earliest deadline is programmed into the
+// local APIC timer in one-shot mode; without a usable APIC, expiry is
+// checked on every PIT tick instead. Expiry raises SOFTIRQ_HRTIMER;
+// callbacks run from the softirq with interrupts enabled and must not
+// block. They may re-arm their own timer.
+
+// Maximum number of armed timers
+#define HRTIMER_MAX 128
+
+// Heap index of a timer that is not armed
+#define HRTIMER_INACTIVE 0xFFFFFFFF
+
+#define NSEC_PER_USEC 1000ULL
+#define NSEC_PER_MSEC 1000000ULL
+
+struct hrtimer;
+typedef void (*hrtimer_func_t)(struct hrtimer* timer);
+
+// Timer; embed it in the object it belongs to
+typedef struct hrtimer {
+    uint64_t expires;                // Absolute deadline in ns
+    hrtimer_func_t function;         // Expiry callback
+    void* data;                      // Caller data
+    uint32_t index;                  // Heap slot or HRTIMER_INACTIVE
+} hrtimer_t;
+
+// Set up the clock event source (called by the timer driver)
+void hrtimer_subsystem_init(void);
+
+// Initialize a timer before first use
+void hrtimer_init(hrtimer_t* timer, hrtimer_func_t function, void* data);
+
+// Arm (or re-arm) a timer for an absolute deadline; -1 if the heap is full
+int hrtimer_start(hrtimer_t* timer, uint64_t expires_ns);
+
+// Arm a timer relative to now
+int hrtimer_start_relative(hrtimer_t* timer, uint64_t delay_ns);
+
+// Disarm a timer; returns 1 if it was armed
+int hrtimer_cancel(hrtimer_t* timer);
+
+// Check whether a timer is armed
+static inline int hrtimer_active(const hrtimer_t* timer) {
+    return timer->index != HRTIMER_INACTIVE;
+}
+
+// Raise the timer softirq if a deadline has passed (PIT tick path)
+void hrtimer_tick(void);
+
+// Block the caller for at least the given number of nanoseconds
+void hrtimer_sleep_ns(uint64_t ns);
+
+// Print clock source and heap statistics
+void hrtimer_print_stats(void);
+
+#endif // HRTIMER_H
@@ -57,4 +57,13 @@ void interrupt_diag_install_test_handlers(void);
 // Get the diagnostics log buffer
 const char* interrupt_diag_get_log(void);
 
+// Record one IRQ: stub entry to handler start, handler start to EOI (cycles)
+void interrupt_diag_record_irq(uint32_t irq, uint64_t entry_cycles, uint64_t handler_cycles);
+
+// Print per-IRQ latency histograms and the longest interrupts-off section
+void interrupt_diag_print_latency(void);
+
+// Clear latency histograms and the interrupts-off record
+void interrupt_diag_reset_latency(void);
+
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 #define INTERRUPT_INIT_H
 
 #include <stdint.h>
+#include "interrupts.h"
 
 // Initialize interrupts properly (for future use)
 void interrupts_init_proper(void);
@@ -10,9 +11,6 @@ void interrupts_init_proper(void);
 // Initialize interrupts with diagnostic logging
 void interrupts_init_with_diagnostic(void);
 
-// Register an interrupt handler (this declaration is also in interrupts.h)
-void interrupt_register_handler(uint8_t num, void (*handler)(void));
-
 // Helper function to test a single interrupt with detailed logging
 void test_single_interrupt(uint8_t int_num);
 
@@ -3,6 +3,12 @@
 #define INTERRUPTS_H
 
 #include <stdint.h>
+#include "cpu.h"
+
+// Track the longest interrupts-disabled section (irq_save .. irq_restore)
+#ifndef CONFIG_IRQOFF_TRACK
+#define CONFIG_IRQOFF_TRACK 1
+#endif
 
 // Timer ticks counter
 extern volatile uint32_t timer_ticks;
@@ -11,10 +17,95 @@ extern volatile uint32_t timer_ticks;
 void interrupts_init(void);
 
 // Polling functions
-void timer_poll(void);
 int keyboard_poll(void);
 
-// Register interrupt handler function (stub for compatibility)
-void interrupt_register_handler(uint8_t num, void (*handler)(void));
+// Register frame built by the stubs in interrupt_stubs_new.asm
+struct regs {
+    uint32_t entry_tsc_lo, entry_tsc_hi;              // TSC at stub entry
+    uint32_t gs, fs, es, ds;
+    uint32_t edi, esi, ebp, esp_dummy, ebx, edx, ecx, eax; // pushad
+    uint32_t int_no, err_code;                        // Pushed by the stub
+    uint32_t eip, cs, eflags, useresp, ss;            // Pushed by the CPU
+};
+
+// Interrupt handler, called with the saved register frame
+typedef void (*interrupt_handler_t)(struct regs* r);
+
+// Per-vector load counters, updated by the dispatcher
+typedef struct {
+    uint32_t count;                  // Times the vector fired
+    uint64_t cycles;                 // TSC cycles spent dispatching it
+} interrupt_stat_t;
+
+// Register an interrupt handler and unmask its PIC line (interrupt_init.c)
+void interrupt_register_handler(uint8_t num, interrupt_handler_t handler);
+
+// Let CPL 3 code raise a vector with the int instruction
+void interrupt_set_user_gate(uint8_t num);
+
+// Copy the counters for one vector; returns -1 for an invalid vector
+int interrupt_get_stat(uint32_t vector, interrupt_stat_t* stat);
+
+// Spurious IRQ7/IRQ15 deliveries filtered by the dispatcher
+uint32_t interrupt_spurious_count(void);
+
+// Zero all per-vector counters
+void interrupt_reset_stats(void);
+
+// Nonzero when the stubs and dispatcher may use rdtsc (interrupt_init.c)
+extern uint32_t interrupt_have_tsc;
+
+#if CONFIG_IRQOFF_TRACK
+// Open interrupts-off section, owned by interrupt_diagnostics.c
+extern uint32_t irqoff_tracking;
+extern uint64_t irqoff_start_tsc;
+extern uint32_t irqoff_start_site;
+
+// Close the open section and update the longest-section record
+void irqoff_section_end(void);
+
+static inline void irqoff_begin(uint32_t site) {
+    if (__builtin_expect(irqoff_tracking, 0)) {
+        irqoff_start_tsc = cpu_read_tsc();
+        irqoff_start_site = site;
+    }
+}
+
+static inline void irqoff_end(void) {
+    if (__builtin_expect(irqoff_tracking, 0) && irqoff_start_tsc) {
+        irqoff_section_end();
+    }
+}
+#else
+static inline void irqoff_begin(uint32_t site) { (void)site; }
+static inline void irqoff_end(void) {}
+#endif
+
+// Save EFLAGS and disable interrupts; pair with irq_restore()
+static inline uint32_t irq_save(void) {
+    uint32_t flags;
+    uint32_t site;
+    asm volatile("pushf\n\tpop %0\n\tcli\n\tmovl $1f, %1\n1:"
+                 : "=r"(flags), "=r"(site) : : "memory");
+    if (flags & 0x200) {
+        irqoff_begin(site);
+    }
+    return flags;
+}
+
+// Restore the interrupt flag saved by irq_save()
+static inline void irq_restore(uint32_t flags) {
+    if (flags & 0x200) {
+        irqoff_end();
+    }
+    asm volatile("push %0\n\tpopf" : : "r"(flags) : "memory", "cc");
+}
+
+// Enable interrupts and halt until the next one. "sti; hlt" cannot be
+// split, so a wakeup checked for under irq_save() is not slept through.
+static inline void irq_enable_and_halt(void) {
+    irqoff_end();
+    asm volatile("sti\n\thlt" : : : "memory");
+}
 
 #endif
\ No newline at end of file
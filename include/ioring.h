@@ -0,0 +1,102 @@
+// include/ioring.h
+#ifndef IORING_H
+#define IORING_H
+
+#include <stdint.h>
+
+// Batched asynchronous I/O through shared rings.
+//
+// SYS_IORING_SETUP creates a ring descriptor and returns the address of
+// its shared area. The process fills submission entries (SQEs) and moves
+// sq_tail; one SYS_IORING_ENTER consumes every new SQE and, if asked,
+// waits for completions. Results are posted as completion entries (CQEs)
+// that the process reaches by reading cq_tail, with no further trap.
+// The kernel only ever writes sq_head and cq_tail; the process only ever
+// writes sq_tail and cq_head. The shared area takes whole pages, open to
+// user mode while the descriptor is.
+
+// Largest submission ring; the completion ring is twice as large
+#define IORING_MAX_ENTRIES  256
+
+// Timeouts in flight per ring
+#define IORING_MAX_TIMEOUTS 16
+
+// Operations
+#define IORING_OP_NOP       0
+#define IORING_OP_READ      1        // fd, addr, len, off
+#define IORING_OP_WRITE     2        // fd, addr, len, off
+#define IORING_OP_FSYNC     3        // Write back the buffer cache
+#define IORING_OP_TIMEOUT   4        // Complete after off nanoseconds
+
+// off value that means "use and advance the file offset"
+#define IORING_OFF_CURRENT  0xFFFFFFFFFFFFFFFFULL
+
+// Submission entry
+typedef struct {
+    uint8_t opcode;                  // IORING_OP_*
+    uint8_t flags;
+    uint16_t reserved;
+    int32_t fd;
+    uint64_t off;                    // File offset, or timeout in ns
+    uint32_t addr;                   // Buffer address
+    uint32_t len;                    // Buffer length
+    uint64_t user_data;              // Copied to the completion
+} ioring_sqe_t;
+
+// Completion entry
+typedef struct {
+    uint64_t user_data;
+    int32_t res;                     // Bytes transferred or SYSCALL_E* code
+    uint32_t flags;
+} ioring_cqe_t;
+
+// Shared area
+typedef struct {
+    volatile uint32_t sq_head;       // Next SQE the kernel consumes
+    volatile uint32_t sq_tail;       // Next SQE slot the process fills
+    volatile uint32_t cq_head;       // Next CQE the process consumes
+    volatile uint32_t cq_tail;       // Next CQE slot the kernel fills
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t sq_dropped;             // SQEs rejected as malformed
+    uint32_t cq_overflow;            // Completions lost to a full CQ
+    ioring_sqe_t* sqes;
+    ioring_cqe_t* cqes;
+} ioring_shared_t;
+
+// Syscall back ends
+int ioring_setup(uint32_t entries, ioring_shared_t** shared_out);
+int ioring_enter(int fd, uint32_t to_submit, uint32_t min_complete);
+
+// Process side helpers
+
+// Next free SQE, or NULL if the submission ring is full
+static inline ioring_sqe_t* ioring_get_sqe(ioring_shared_t* ring) {
+    if (ring->sq_tail - ring->sq_head >= ring->sq_entries) {
+        return 0;
+    }
+    return &ring->sqes[ring->sq_tail & (ring->sq_entries - 1)];
+}
+
+// Publish the SQE returned by ioring_get_sqe()
+static inline void ioring_queue_sqe(ioring_shared_t* ring) {
+    asm volatile("" : : : "memory");
+    ring->sq_tail++;
+}
+
+// Oldest unread CQE, or NULL if none
+static inline ioring_cqe_t* ioring_peek_cqe(ioring_shared_t* ring) {
+    if (ring->cq_head == ring->cq_tail) {
+        return 0;
+    }
+    asm volatile("" : : : "memory");
+    return &ring->cqes[ring->cq_head & (ring->cq_entries - 1)];
+}
+
+// Release the CQE returned by ioring_peek_cqe()
+static inline void ioring_cqe_seen(ioring_shared_t* ring) {
+    asm volatile("" : : : "memory");
+    ring->cq_head++;
+}
+
+#endif // IORING_H
@@ -0,0 +1,36 @@
+// include/lapic.h
+#ifndef LAPIC_H
+#define LAPIC_H
+
+#include <stdint.h>
+
+// Local APIC timer interrupt vector
+#define LAPIC_TIMER_VECTOR    0xF0
+
+// Local APIC spurious interrupt vector
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+
+// Enable the local APIC in virtual wire mode (the 8259 PIC keeps working
+// through LINT0). Returns -1 if the CPU has no usable APIC.
+int lapic_init(void);
+
+// Check whether lapic_init() succeeded
+int lapic_present(void);
+
+// Signal end of interrupt to the local APIC
+void lapic_eoi(void);
+
+// Calibrate the APIC timer against the TSC and route it to the vector.
+// Returns -1 if the timer cannot be used.
+int lapic_timer_init(uint8_t vector);
+
+// Fire the timer interrupt once, after the given number of nanoseconds
+void lapic_timer_oneshot_ns(uint64_t ns);
+
+// Cancel a pending one-shot
+void lapic_timer_stop(void);
+
+// Get the calibrated timer rate in kHz (0 if not calibrated)
+uint32_t lapic_timer_khz(void);
+
+#endif // LAPIC_H
@@ -14,6 +14,15 @@
 #define MEM_PROT_EXEC   0x04
 #define MEM_PROT_USER   0x08
 
+// Address layout once paging is on. The first 8MB are identity mapped
+// with 4KB pages (kernel, heap and the user page frame pool); the user
+// window is empty until programs fault pages into it; everything else is
+// identity mapped with 4MB pages for the kernel only.
+#define LOW_MAP_END     0x00800000
+#define FRAME_POOL_BASE 0x00500000   // Page frames for user memory and page tables
+#define USER_BASE       0x40000000   // User window
+#define USER_TOP        0x80000000
+
 // Memory region types
 #define MEM_REGION_KERNEL  0
 #define MEM_REGION_HEAP    1
@@ -28,7 +37,14 @@ uint32_t get_physical_address(uint32_t virtual_addr);
 void enable_memory_protection(void);
 void disable_memory_protection(void);
 int is_valid_access(uint32_t virtual_addr, uint32_t access_flags);
-void memory_fault_handler(uint32_t fault_addr, uint32_t error_code);
+int paging_enabled(void);
+
+// Page frames from the pool; 0 when it is empty
+uint32_t page_frame_alloc(void);
+void page_frame_free(uint32_t physical_addr);
+
+// Page fault in the user window; returns 1 if the page was made present
+int memory_fault_handler(uint32_t fault_addr, uint32_t error_code);
 void display_memory_regions(void);
 
 // Enhanced memory management
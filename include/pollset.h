@@ -0,0 +1,73 @@
+// include/pollset.h
+#ifndef POLLSET_H
+#define POLLSET_H
+
+#include <stdint.h>
+#include "wait_queue.h"
+
+// Readiness sets: wait for any of several event sources at once.
+//
+// A set holds watches on descriptors, the keyboard, the mouse and
+// periodic timers. Each watch parks an entry on its source's wait queue;
+// a wakeup only marks that watch for a recheck, so a wait looks at the
+// sources that changed instead of polling every one of them. Watches are
+// level triggered: a source that is still ready is reported again by the
+// next wait. Timers report how many periods elapsed since the last wait.
+
+// Watches per set (one bit each in the pending mask)
+#define POLLSET_MAX_WATCHES 32
+
+// Event sources
+#define POLL_SRC_FD         0        // id = descriptor
+#define POLL_SRC_KEYBOARD   1
+#define POLL_SRC_MOUSE      2
+#define POLL_SRC_TIMER      3        // id = caller's timer number, arg = period in ms
+
+// Event bits
+#define POLL_IN             0x0001   // Data to read
+#define POLL_OUT            0x0004   // Room to write
+#define POLL_ERR            0x0008   // Source went away
+
+// pollset_ctl() operations
+#define POLL_CTL_ADD        1
+#define POLL_CTL_DEL        2
+#define POLL_CTL_MOD        3
+
+// Interest in one source; a watch is named by (source, id)
+typedef struct {
+    uint32_t source;                 // POLL_SRC_*
+    uint32_t id;
+    uint32_t events;                 // POLL_* bits of interest
+    uint32_t arg;                    // Timer period in ms
+    uint64_t data;                   // Returned with every event
+} poll_watch_t;
+
+// One ready source
+typedef struct {
+    uint32_t events;                 // POLL_* bits that are ready
+    uint32_t count;                  // Timer periods elapsed (timers only)
+    uint64_t data;                   // From the watch
+} poll_event_t;
+
+typedef struct pollset pollset_t;
+
+// Kernel interface
+pollset_t* pollset_create(void);
+void pollset_destroy(pollset_t* set);
+int pollset_ctl(pollset_t* set, uint32_t op, const poll_watch_t* watch);
+
+// Report up to max ready sources without blocking; returns the count
+int pollset_collect(pollset_t* set, poll_event_t* events, uint32_t max);
+
+// Nonzero if some watch needs a recheck (condition for TASK_WAIT_EVENT)
+int pollset_pending(pollset_t* set);
+
+// Queue woken whenever a watch is marked for a recheck
+wait_queue_t* pollset_wait_queue(pollset_t* set);
+
+// Syscall back ends
+int pollset_create_fd(void);
+int pollset_ctl_fd(int fd, uint32_t op, const poll_watch_t* watch);
+int pollset_wait_fd(int fd, poll_event_t* events, uint32_t max, uint32_t timeout_ms);
+
+#endif // POLLSET_H
@@ -3,6 +3,9 @@
 #define PROCESS_H
 
 #include <stdint.h>
+#include "hrtimer.h"
+#include "file.h"
+#include "syscall.h"
 
 // Process states
 #define PROCESS_STATE_READY      0
@@ -44,10 +47,12 @@ typedef struct {
     process_context_t context;       // CPU context
     uint8_t* stack;                  // Stack memory
     void (*entry_point)(void);       // Process entry point
-    uint32_t sleep_until;            // Wake time for sleeping processes
+    hrtimer_t sleep_timer;           // Wakes the process from process_sleep()
     uint32_t cpu_usage_percent;      // CPU usage percentage
     uint32_t parent_pid;             // Parent process PID
     uint32_t exit_code;              // Process exit code
+    file_t* fds[PROCESS_MAX_FDS];    // Open descriptors
+    syscall_stat_t syscalls[SYSCALL_STATS_MAX];  // Per-call counters
 } process_t;
 
 // Initialize the process management subsystem
@@ -2,6 +2,8 @@
 #ifndef SHELL_H
 #define SHELL_H
 
+#include "hal_keyboard.h"
+
 // Initialize shell
 void shell_init(void);
 
@@ -14,6 +16,9 @@ void shell_run(void);
 // Process a single key from keyboard input
 void shell_handle_key(int scancode);
 
+// Process a single translated key event
+void shell_handle_key_event(const key_event_t* event);
+
 // Process a single command
 void shell_process_command(const char* command);
 
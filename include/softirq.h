@@ -0,0 +1,78 @@
+// include/softirq.h
+#ifndef SOFTIRQ_H
+#define SOFTIRQ_H
+
+#include <stdint.h>
+
+// Deferred interrupt work (bottom halves).
+//
+// A hard IRQ handler does the minimum with interrupts masked and raises a
+// softirq. Pending softirqs run with interrupts enabled when the
+// outermost interrupt returns. If they keep re-raising past the exit
+// budget, the rest is handed to the ksoftirqd task so interrupt exits
+// stay short and tasks are not starved.
+//
+// Drivers that need a private bottom half use a tasklet, which runs from
+// SOFTIRQ_TASKLET and never runs concurrently with itself.
+
+// Softirq types, run in this order
+#define SOFTIRQ_HRTIMER 0            // Expired high-resolution timers
+#define SOFTIRQ_TASKLET 1            // Scheduled tasklets
+#define SOFTIRQ_NR      2
+
+// Time allowed for softirqs on one interrupt exit before deferring
+#define SOFTIRQ_EXIT_BUDGET_NS 2000000
+
+// Time deferred work may wait for ksoftirqd before interrupt exits
+// resume running it
+#define SOFTIRQ_DEFER_TIMEOUT_NS 10000000
+
+// Passes over the pending mask on one interrupt exit before deferring
+#define SOFTIRQ_MAX_RESTART 10
+
+// Softirq action
+typedef void (*softirq_action_t)(void);
+
+// Per-type accounting
+typedef struct {
+    const char* name;
+    uint32_t budget_ns;              // Expected worst case for one run
+    uint32_t runs;                   // Times the action ran
+    uint32_t overruns;               // Runs longer than budget_ns
+    uint32_t max_ns;                 // Longest run
+    uint64_t total_ns;               // Time spent in the action
+} softirq_stat_t;
+
+// Tasklet
+typedef struct tasklet {
+    struct tasklet* next;            // Pending list link
+    volatile uint8_t scheduled;      // On the pending list
+    void (*func)(void* data);
+    void* data;
+} tasklet_t;
+
+// Initialize the softirq layer and start ksoftirqd
+void softirq_init(void);
+
+// Install the action for a softirq type with its time budget
+void open_softirq(uint32_t nr, const char* name, softirq_action_t action, uint32_t budget_ns);
+
+// Mark a softirq pending (safe from hard IRQ context)
+void raise_softirq(uint32_t nr);
+
+// Run pending softirqs from the end of interrupt_dispatch()
+void softirq_irq_exit(void);
+
+// Copy the accounting for one type; returns -1 for an invalid type
+int softirq_get_stat(uint32_t nr, softirq_stat_t* stat);
+
+// Print per-type accounting
+void softirq_print_stats(void);
+
+// Initialize a tasklet
+void tasklet_init(tasklet_t* tasklet, void (*func)(void* data), void* data);
+
+// Queue a tasklet to run once (safe from hard IRQ context)
+void tasklet_schedule(tasklet_t* tasklet);
+
+#endif // SOFTIRQ_H
@@ -20,5 +20,6 @@ char* strcat(char* dest, const char* src);
 // Memory functions
 void* memcpy(void* dest, const void* src, size_t n);
 void* memset(void* s, int c, size_t n);
+void* memmove(void* dest, const void* src, size_t n);
 
 #endif
\ No newline at end of file
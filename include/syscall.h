@@ -4,7 +4,17 @@
 
 #include <stdint.h>
 
+// Entry from user mode. Both paths use the same registers: EAX holds the
+// call number, EBX/ECX/EDX/ESI the arguments, and the result comes back
+// in EAX. int 0x80 always works; syscall_sysenter() is the faster path
+// when the CPU has SYSENTER (syscall_sysenter_available()).
+#define SYSCALL_VECTOR      0x80
+
+// Vector user_mode_call() uses to get back to the kernel
+#define USER_RETURN_VECTOR  0x81
+
 // System call numbers
+#define SYS_NULL            0    // Does nothing; measures entry cost
 #define SYS_EXIT            1
 #define SYS_WRITE           2
 #define SYS_READ            3
@@ -25,6 +35,15 @@
 #define SYS_GETCWD          18
 #define SYS_DELETE          19
 #define SYS_PROCESS_INFO    20
+#define SYS_IORING_SETUP    21
+#define SYS_IORING_ENTER    22
+#define SYS_CHANNEL_OPEN    23
+#define SYS_CHANNEL_NOTIFY  24
+#define SYS_CHANNEL_WAIT    25
+#define SYS_CHANNEL_PAGES   26
+#define SYS_POLLSET_CREATE  27
+#define SYS_POLLSET_CTL     28
+#define SYS_POLLSET_WAIT    29
 
 // Error codes
 #define SYSCALL_SUCCESS     0
@@ -40,6 +59,27 @@
 #define SYSCALL_ENOTDIR    -10  // Not a directory
 #define SYSCALL_EISDIR     -11  // Is a directory
 #define SYSCALL_EMFILE     -12  // Too many open files
+#define SYSCALL_ENOEXEC    -13  // Exec format error
+
+// File status returned by SYS_STAT
+typedef struct {
+    int type;                        // FS_TYPE_FILE or FS_TYPE_DIRECTORY
+    uint32_t size;                   // Bytes (files)
+    uint32_t permissions;
+    uint32_t created_time;
+    uint32_t modified_time;
+} sys_stat_t;
+
+// Call numbers below this get their own counters
+#define SYSCALL_STATS_MAX   32
+
+// Per-call counters, kept globally and per process
+typedef struct {
+    uint32_t count;                  // Calls dispatched
+    uint32_t errors;                 // Calls that returned < 0
+    uint64_t cycles;                 // TSC cycles spent in the handler
+    uint64_t max_cycles;             // Slowest single call
+} syscall_stat_t;
 
 // Initialize system call interface
 void syscall_init(void);
@@ -53,6 +93,55 @@ void register_syscall(uint32_t num, syscall_handler_t handler);
 // System call dispatcher
 int syscall_dispatch(uint32_t num, uint32_t param1, uint32_t param2, uint32_t param3, uint32_t param4);
 
+// Dispatcher for calls made at CPL 3 (int 0x80 and SYSENTER)
+int syscall_dispatch_user(uint32_t num, uint32_t param1, uint32_t param2, uint32_t param3, uint32_t param4);
+
+// Copy the system-wide counters for one call; returns -1 for an invalid number
+int syscall_get_stat(uint32_t num, syscall_stat_t* stat);
+
+// Zero the system-wide counters
+void syscall_reset_stats(void);
+
+// Name of a call number ("?" if unknown)
+const char* syscall_name(uint32_t num);
+
+// Check whether the SYSENTER path was set up
+int syscall_sysenter_available(void);
+
+// Run func(arg) at CPL 3 on stack_top and return its result
+int user_mode_call(int (*func)(void* arg), void* arg, void* stack_top);
+
+// Kernel functions user_mode_call() runs go on the user text page, the
+// only kernel code CPL 3 can reach; what they call must be inlined
+#define USER_TEXT __attribute__((section(".user_text")))
+
+// Time null system calls made from CPL 3 through both entry paths, and
+// a vDSO clock read
+int syscall_benchmark(uint32_t iterations);
+
+// User side of the SYSENTER path (syscall_entry.asm); register ABI above
+void syscall_sysenter(void);
+
+// Issue a system call through int 0x80
+static inline __attribute__((always_inline)) int syscall_int80(uint32_t num, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4) {
+    int result;
+    asm volatile("int $0x80"
+                 : "=a"(result)
+                 : "a"(num), "b"(arg1), "c"(arg2), "d"(arg3), "S"(arg4)
+                 : "memory");
+    return result;
+}
+
+// Issue a system call through SYSENTER
+static inline __attribute__((always_inline)) int syscall_fast(uint32_t num, uint32_t arg1, uint32_t arg2, uint32_t arg3, uint32_t arg4) {
+    int result;
+    asm volatile("call syscall_sysenter"
+                 : "=a"(result)
+                 : "a"(num), "b"(arg1), "c"(arg2), "d"(arg3), "S"(arg4)
+                 : "memory", "cc");
+    return result;
+}
+
 // System call wrapper functions
 int sys_exit(int status);
 int sys_write(int fd, const void* buf, uint32_t count);
@@ -66,7 +155,7 @@ int sys_sleep(uint32_t ms);
 uint32_t sys_time(void);
 void* sys_allocate(uint32_t size);
 int sys_free(void* ptr);
-int sys_stat(const char* pathname, void* stat_buf);
+int sys_stat(const char* pathname, sys_stat_t* stat_buf);
 int sys_seek(int fd, int offset, int whence);
 int sys_mkdir(const char* pathname);
 int sys_rmdir(const char* pathname);
@@ -74,5 +163,14 @@ int sys_chdir(const char* pathname);
 char* sys_getcwd(char* buf, uint32_t size);
 int sys_delete(const char* pathname);
 int sys_process_info(int pid, void* info_buf);
+int sys_ioring_setup(uint32_t entries, void** shared_out);
+int sys_ioring_enter(int fd, uint32_t to_submit, uint32_t min_complete);
+int sys_channel_open(const char* name, uint32_t slots, void** shared_out);
+int sys_channel_notify(int fd);
+int sys_channel_wait(int fd, uint32_t condition, uint32_t timeout_ms);
+int sys_channel_pages(int fd, uint32_t op, void* addr, uint32_t len);
+int sys_pollset_create(void);
+int sys_pollset_ctl(int fd, uint32_t op, const void* watch);
+int sys_pollset_wait(int fd, void* events, uint32_t max, uint32_t timeout_ms);
 
 #endif // SYSCALL_H
\ No newline at end of file
@@ -0,0 +1,148 @@
+// include/task.h
+#ifndef TASK_H
+#define TASK_H
+
+#include <stdint.h>
+#include "wait_queue.h"
+#include "hrtimer.h"
+
+// Lightweight cooperative tasks.
+//
+// Tasks are stackless coroutines (protothread style) multiplexed on the
+// kernel thread that calls task_run_loop(). A task body is a function
+// that resumes where it last suspended by switching on a saved line
+// number, so a task costs only its task_t. The price is that locals do
+// not survive a suspension point: keep state in the task (or its arg),
+// and never put two TASK_* suspension macros on the same source line.
+//
+//   static int blink(task_t* t) {
+//       TASK_BEGIN(t);
+//       while (1) {
+//           toggle_led();
+//           TASK_SLEEP(t, 500);
+//       }
+//       TASK_END(t);
+//   }
+
+// Values returned by a task body to the runtime
+#define TASK_YIELDED 0               // Still runnable, requeue at the tail
+#define TASK_WAITING 1               // Parked on a timer and/or wait queue
+#define TASK_EXITED  2               // Finished, drop from the runtime
+
+// Task states
+#define TASK_STATE_READY   0         // On the run queue
+#define TASK_STATE_RUNNING 1         // Body is executing
+#define TASK_STATE_WAITING 2         // Parked until woken
+#define TASK_STATE_DONE    3         // Exited
+
+// Task flags
+#define TASK_FLAG_ALLOCATED 0x01     // task_t came from task_spawn()
+#define TASK_FLAG_SLEEPING  0x02     // Sleep timer armed
+#define TASK_FLAG_TIMEDOUT  0x04     // Last wait ended by its timeout
+
+struct task;
+typedef int (*task_func_t)(struct task* task);
+
+// Task control block
+typedef struct task {
+    uint16_t lc;                     // Local continuation (resume line)
+    uint8_t state;                   // Task state
+    uint8_t flags;                   // Task flags
+    const char* name;                // Task name
+    task_func_t func;                // Task body
+    void* arg;                       // Caller data
+    uint32_t resumes;                // Number of times the body ran
+    struct task* next;               // Run queue link
+    hrtimer_t timer;                 // Sleep/timeout timer
+    wait_queue_entry_t wait;         // Wait queue link
+    wait_queue_t* waiting_on;        // Queue the task is parked on
+} task_t;
+
+// Start a coroutine body
+#define TASK_BEGIN(t) switch ((t)->lc) { case 0:
+
+// End a coroutine body; the task exits when control reaches here
+#define TASK_END(t) } (t)->lc = 0; return TASK_EXITED
+
+// Let other tasks run, then continue
+#define TASK_YIELD(t) \
+    do { (t)->lc = __LINE__; return TASK_YIELDED; case __LINE__:; } while (0)
+
+// Yield until a polled condition becomes true
+#define TASK_AWAIT_UNTIL(t, cond) \
+    do { (t)->lc = __LINE__; case __LINE__: if (!(cond)) return TASK_YIELDED; } while (0)
+
+// Suspend for at least the given number of milliseconds
+#define TASK_SLEEP(t, ms) \
+    do { task_sleep_prepare((t), (ms)); (t)->lc = __LINE__; return TASK_WAITING; case __LINE__:; } while (0)
+
+// Suspend for at least the given number of microseconds
+#define TASK_SLEEP_US(t, us) \
+    do { task_sleep_prepare_ns((t), (us) * NSEC_PER_USEC); (t)->lc = __LINE__; return TASK_WAITING; case __LINE__:; } while (0)
+
+// Suspend on a wait queue until the condition is true. The task is queued
+// before the condition is tested, so a wakeup from an interrupt handler
+// between the test and the suspension is never lost.
+#define TASK_WAIT_EVENT(t, wq, cond) \
+    do { \
+        (t)->lc = __LINE__; case __LINE__: \
+        task_wait_prepare((t), (wq)); \
+        if (!(cond)) return TASK_WAITING; \
+        task_wait_finish((t), (wq)); \
+    } while (0)
+
+// As TASK_WAIT_EVENT, but give up after the timeout. Afterwards
+// task_timed_out(t) tells whether the condition was met.
+#define TASK_WAIT_EVENT_TIMEOUT(t, wq, cond, ms) \
+    do { \
+        (t)->flags &= ~TASK_FLAG_TIMEDOUT; \
+        task_sleep_prepare((t), (ms)); \
+        (t)->lc = __LINE__; case __LINE__: \
+        task_wait_prepare((t), (wq)); \
+        if (!(cond) && ((t)->flags & TASK_FLAG_SLEEPING)) return TASK_WAITING; \
+        if (!(cond)) (t)->flags |= TASK_FLAG_TIMEDOUT; \
+        task_wait_finish((t), (wq)); \
+    } while (0)
+
+// Initialize the task runtime
+void task_runtime_init(void);
+
+// Initialize a caller-owned task (e.g. embedded in a widget)
+void task_init(task_t* task, const char* name, task_func_t func, void* arg);
+
+// Put an initialized task on the run queue
+int task_start(task_t* task);
+
+// Allocate, initialize and start a task; freed automatically on exit
+task_t* task_spawn(const char* name, task_func_t func, void* arg);
+
+// Make a waiting task runnable (safe from interrupt handlers)
+void task_wake(task_t* task);
+
+// Stop a task and detach it from the runtime
+void task_kill(task_t* task);
+
+// Get the task whose body is currently executing (NULL outside tasks)
+task_t* task_current(void);
+
+// Run every runnable task once; returns the number of tasks run
+int task_run_pending(void);
+
+// Run tasks forever on the calling kernel thread
+void task_run_loop(void);
+
+// Print the task list
+void task_list(void);
+
+// Helpers used by the suspension macros
+void task_sleep_prepare(task_t* task, uint32_t ms);
+void task_sleep_prepare_ns(task_t* task, uint64_t ns);
+void task_wait_prepare(task_t* task, wait_queue_t* wq);
+void task_wait_finish(task_t* task, wait_queue_t* wq);
+
+// Check whether the last timed wait expired
+static inline int task_timed_out(task_t* task) {
+    return (task->flags & TASK_FLAG_TIMEDOUT) != 0;
+}
+
+#endif // TASK_H
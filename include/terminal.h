@@ -6,6 +6,7 @@
 void terminal_initialize(void);
 void terminal_putchar(char c);
 void terminal_writestring(const char* data);
+void terminal_write(const char* data, size_t len);  // Bulk write; one scroll and cursor update per call
 void terminal_clear(void);
 void terminal_scroll(void);  // Added terminal_scroll function declaration
 
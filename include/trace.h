@@ -0,0 +1,89 @@
+// include/trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Compile-time switch: set to 0 to compile every trace point out
+#ifndef CONFIG_TRACE
+#define CONFIG_TRACE 1
+#endif
+
+// Number of per-CPU rings (the kernel currently runs on one CPU)
+#define TRACE_NR_CPUS 1
+
+// Events per ring (must be a power of two)
+#define TRACE_RING_SIZE 4096
+
+// Event types
+#define TRACE_EV_SCHED_SWITCH  1     // a = previous pid, b = next pid
+#define TRACE_EV_SCHED_WAKEUP  2     // a = pid
+#define TRACE_EV_TASK_BEGIN    3     // a = task, b = task name
+#define TRACE_EV_TASK_END      4     // a = task, b = body result
+#define TRACE_EV_TASK_WAKEUP   5     // a = task, b = task name
+#define TRACE_EV_IRQ_ENTRY     6     // a = vector
+#define TRACE_EV_IRQ_EXIT      7     // a = vector
+#define TRACE_EV_SYSCALL_ENTRY 8     // a = syscall number, b = first argument
+#define TRACE_EV_SYSCALL_EXIT  9     // a = syscall number, b = return value
+#define TRACE_EV_SOFTIRQ_ENTRY 10    // a = softirq number
+#define TRACE_EV_SOFTIRQ_EXIT  11    // a = softirq number
+
+// One trace record
+typedef struct {
+    uint64_t tsc;                    // Time stamp counter at record time
+    uint32_t a;                      // Event argument
+    uint32_t b;                      // Event argument
+    uint8_t type;                    // Event type
+    uint8_t cpu;                     // CPU that recorded the event
+    uint16_t pid;                    // Current process when recorded
+} trace_event_t;
+
+// Per-CPU ring buffer. Writers reserve a slot with an atomic increment of
+// head, so nested interrupt handlers never need a lock; the oldest
+// records are overwritten once the ring wraps.
+typedef struct {
+    trace_event_t events[TRACE_RING_SIZE];
+    volatile uint32_t head;          // Total records ever reserved
+} trace_ring_t;
+
+// Runtime switch tested by every trace point
+extern volatile uint32_t trace_enabled;
+
+// Record an event (slow path, only reached while tracing)
+void trace_record(uint8_t type, uint32_t a, uint32_t b);
+
+// Trace point: a single predictable branch while tracing is off
+static inline void trace_event(uint8_t type, uint32_t a, uint32_t b) {
+#if CONFIG_TRACE
+    if (__builtin_expect(trace_enabled, 0)) {
+        trace_record(type, a, b);
+    }
+#else
+    (void)type;
+    (void)a;
+    (void)b;
+#endif
+}
+
+// Initialize the trace buffers (timestamps use the hal_timer TSC calibration)
+void trace_init(void);
+
+// Start recording
+void trace_start(void);
+
+// Stop recording
+void trace_stop(void);
+
+// Discard recorded events
+void trace_clear(void);
+
+// Get the number of records held across all rings
+uint32_t trace_count(void);
+
+// Stream the rings over COM1 as Chrome trace-event JSON
+void trace_dump_serial(void);
+
+// Print trace status on the terminal
+void trace_status(void);
+
+#endif // TRACE_H
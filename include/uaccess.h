@@ -0,0 +1,54 @@
+// include/uaccess.h
+#ifndef UACCESS_H
+#define UACCESS_H
+
+#include <stdint.h>
+#include "memory.h"
+
+// Moving data across the user/kernel boundary.
+//
+// The range is checked once against the user address limit; the copy
+// itself runs with word-sized moves. A fault on the user side is not
+// fatal: the faulting instruction has an entry in the __ex_table section
+// and the exception handler resumes at its fixup code, which makes the
+// copy return SYSCALL_EFAULT.
+
+// Calls made by kernel code pass buffers in identity-mapped low memory;
+// calls from CPL 3 may only name the user window (memory.h)
+#define KERNEL_ADDR_MIN   0x00001000
+#define KERNEL_ADDR_LIMIT LOW_MAP_END
+
+struct regs;
+
+// Set while a system call made from CPL 3 runs (syscall_dispatch_user())
+extern uint32_t uaccess_user_origin;
+
+// Window pointers of the running call must fall in
+static inline uint32_t uaccess_min(void) {
+    return uaccess_user_origin ? USER_BASE : KERNEL_ADDR_MIN;
+}
+
+static inline uint32_t uaccess_limit(void) {
+    return uaccess_user_origin ? USER_TOP : KERNEL_ADDR_LIMIT;
+}
+
+// Nonzero if [addr, addr + size) lies entirely in the caller's window
+static inline int access_ok(uint32_t addr, uint32_t size) {
+    uint32_t limit = uaccess_limit();
+    return addr >= uaccess_min() && addr <= limit && size <= limit - addr;
+}
+
+// Copy size bytes; returns 0 or SYSCALL_EFAULT
+int copy_from_user(void* to, const void* from, uint32_t size);
+int copy_to_user(void* to, const void* from, uint32_t size);
+
+// Copy a NUL-terminated string of at most size bytes including the NUL.
+// Returns its length, SYSCALL_EFAULT, or SYSCALL_EINVAL if it does not
+// fit.
+int strncpy_from_user(char* to, const char* from, uint32_t size);
+
+// Called on a kernel-mode fault: if the faulting instruction has a fixup,
+// point the frame at it and return 1
+int uaccess_fixup(struct regs* r);
+
+#endif // UACCESS_H
@@ -0,0 +1,104 @@
+// include/vdso.h
+#ifndef VDSO_H
+#define VDSO_H
+
+#include <stdint.h>
+#include "cpu.h"
+#include "memory.h"
+
+// Kernel data page shared read-only with user code.
+//
+// The kernel publishes the clock calibration, the tick count and the
+// current pid here; the inline helpers below read them without a system
+// call. Writers bump seq to an odd value before updating and to the
+// next even value after, so readers retry if they raced an update.
+//
+// Every program finds the page at VDSO_USER_ADDR, a fixed address in the
+// user window that program images may not cover. The kernel writes it
+// through its own mapping.
+
+#define VDSO_PAGE_SIZE 4096
+
+// Where the page appears at CPL 3 (needs paging)
+#define VDSO_USER_ADDR (USER_TOP - 0x100000)
+
+// Layout version, bumped when fields change
+#define VDSO_VERSION 1
+
+typedef struct {
+    volatile uint32_t seq;           // Odd while an update is in progress
+    uint32_t version;                // VDSO_VERSION
+    uint32_t tsc_khz;                // Calibrated TSC rate (0 if none)
+    uint32_t ns_mult;                // TSC cycles to ns multiplier
+    uint32_t ns_shift;               // Fixed point shift of ns_mult
+    uint64_t tsc_base;               // TSC at clock ns 0
+    uint64_t tick_ns;                // Clock at the last tick (no TSC)
+    uint32_t ticks;                  // Timer ticks since boot
+    uint32_t hz;                     // Tick rate
+    uint32_t pid;                    // Running process
+} vdso_data_t;
+
+typedef union {
+    vdso_data_t data;
+    uint8_t raw[VDSO_PAGE_SIZE];
+} vdso_page_t;
+
+// The page itself, page aligned in the kernel image
+extern vdso_page_t vdso_page;
+
+// The page as user code sees it
+#define VDSO_DATA ((const volatile vdso_data_t*)VDSO_USER_ADDR)
+
+// Map the page at VDSO_USER_ADDR
+void vdso_init(void);
+
+// Kernel updates (hal_timer.c, process.c)
+void vdso_set_clock(uint32_t tsc_khz, uint32_t ns_mult, uint32_t ns_shift, uint64_t tsc_base, uint32_t hz);
+void vdso_tick(uint32_t ticks, uint64_t now_ns);
+void vdso_set_pid(uint32_t pid);
+
+// Reader side of the sequence lock. The readers are always inlined, so
+// user code calls no kernel text.
+static inline __attribute__((always_inline)) uint32_t vdso_read_begin(const volatile vdso_data_t* data) {
+    uint32_t seq;
+    while ((seq = data->seq) & 1) {
+        asm volatile("pause");
+    }
+    asm volatile("" : : : "memory");
+    return seq;
+}
+
+static inline __attribute__((always_inline)) int vdso_read_retry(const volatile vdso_data_t* data, uint32_t seq) {
+    asm volatile("" : : : "memory");
+    return data->seq != seq;
+}
+
+// Monotonic clock in nanoseconds (same clock as hal_timer_get_ns())
+static inline __attribute__((always_inline)) uint64_t vdso_clock_ns(void) {
+    const volatile vdso_data_t* data = VDSO_DATA;
+    uint64_t ns;
+    uint32_t seq;
+    
+    do {
+        seq = vdso_read_begin(data);
+        if (data->tsc_khz) {
+            ns = cpu_mul_u64_u32_shr(cpu_read_tsc() - data->tsc_base, data->ns_mult, data->ns_shift);
+        } else {
+            ns = data->tick_ns;
+        }
+    } while (vdso_read_retry(data, seq));
+    
+    return ns;
+}
+
+// Timer ticks since boot (what SYS_TIME returns)
+static inline __attribute__((always_inline)) uint32_t vdso_time(void) {
+    return VDSO_DATA->ticks;
+}
+
+// Pid of the running process (what SYS_GETPID returns)
+static inline __attribute__((always_inline)) uint32_t vdso_getpid(void) {
+    return VDSO_DATA->pid;
+}
+
+#endif // VDSO_H
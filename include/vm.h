@@ -0,0 +1,48 @@
+// include/vm.h
+#ifndef VM_H
+#define VM_H
+
+#include <stdint.h>
+#include "file.h"
+
+// Demand-paged regions of the user window.
+//
+// A region only records where its contents come from. Pages become
+// present when first touched: file-backed bytes are read from the file
+// and the rest (BSS, stacks) is zero filled. The user window holds one
+// program image at a time.
+
+// Regions in the user window
+#define VM_MAX_REGIONS 16
+
+// Fault counters since boot
+typedef struct {
+    uint32_t faults;                 // Pages made present
+    uint32_t file_pages;             // ...that read file data
+    uint32_t zero_pages;             // ...that were all zeros
+    uint32_t failed;                 // Faults that found no region or memory
+    uint32_t resident;               // Pages present now
+} vm_stats_t;
+
+// Describe [start, start + size) with protection prot (MEM_PROT_*). The
+// first file_size bytes come from file at offset; the rest read as zero.
+// file may be NULL for anonymous memory. Returns 0 or a SYSCALL_E* code.
+int vm_map(uint32_t start, uint32_t size, uint32_t prot, file_t* file, uint32_t offset, uint32_t file_size);
+
+// Resolve a fault at addr; returns 1 if the page is now present
+int vm_fault(uint32_t addr, uint32_t error_code);
+
+// Move a page out of the window: returns its frame (faulting it in first
+// if needed) and leaves the address unmapped, or 0 if addr has no region
+uint32_t vm_detach_page(uint32_t addr);
+
+// Back a page of a writable region with frame, replacing any frame it
+// had. The frame belongs to the region afterwards.
+int vm_attach_page(uint32_t addr, uint32_t frame);
+
+// Drop every region and free the pages behind them
+void vm_unmap_all(void);
+
+void vm_get_stats(vm_stats_t* stats);
+
+#endif // VM_H
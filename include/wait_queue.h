@@ -0,0 +1,45 @@
+// include/wait_queue.h
+#ifndef WAIT_QUEUE_H
+#define WAIT_QUEUE_H
+
+#include <stdint.h>
+
+// A waiter parked on a wait queue. The wake callback decides what
+// "waking" means for the owner (requeue a task, unblock a process, ...).
+typedef struct wait_queue_entry {
+    struct wait_queue_entry* next;
+    void (*wake)(struct wait_queue_entry* entry);
+    void* owner;
+    uint8_t queued;                  // Non-zero while linked on a queue
+} wait_queue_entry_t;
+
+// Wait queue head (FIFO of waiters)
+typedef struct {
+    wait_queue_entry_t* head;
+    wait_queue_entry_t* tail;
+} wait_queue_t;
+
+// Initialize a wait queue
+void wait_queue_init(wait_queue_t* wq);
+
+// Initialize a wait queue entry with its wake callback
+void wait_queue_entry_init(wait_queue_entry_t* entry, void (*wake)(wait_queue_entry_t*), void* owner);
+
+// Add an entry to the tail of the queue (no-op if already queued)
+void wait_queue_add(wait_queue_t* wq, wait_queue_entry_t* entry);
+
+// Remove an entry from the queue (no-op if not queued)
+void wait_queue_remove(wait_queue_t* wq, wait_queue_entry_t* entry);
+
+// Wake the first waiter; returns 1 if one was woken
+int wait_queue_wake_one(wait_queue_t* wq);
+
+// Wake every waiter; returns the number woken
+int wait_queue_wake_all(wait_queue_t* wq);
+
+// Check whether anybody is waiting
+static inline int wait_queue_empty(wait_queue_t* wq) {
+    return wq->head == 0;
+}
+
+#endif // WAIT_QUEUE_H
@@ -0,0 +1,959 @@
+// src/bcache.c
+#include "bcache.h"
+#include "cpu.h"
+#include "hal.h"
+#include "hal_ata.h"
+#include "hal_timer.h"
+#include "kmalloc.h"
+#include "string.h"
+#include "task.h"
+#include <stddef.h>
+
+// End of a chain or list
+#define BCACHE_NONE (-1)
+
+// Scratch for one merged request, read or write
+#define BCACHE_IO_SIZE (BCACHE_RA_MAX > BCACHE_MAX_WRITE_SIZE ? BCACHE_RA_MAX : BCACHE_MAX_WRITE_SIZE)
+
+// Block queues; a block is on at most one
+#define BCACHE_Q_NONE 0
+#define BCACHE_Q_MAIN 1          // LRU: every block; 2Q: blocks used again (Am)
+#define BCACHE_Q_IN   2          // 2Q: blocks used once, FIFO (A1in)
+#define BCACHE_Q_META 3          // Metadata, kept outside the policy
+#define BCACHE_QUEUES 4
+
+// Block states
+#define BCACHE_STATE_EMPTY 0
+#define BCACHE_STATE_CLEAN 1
+#define BCACHE_STATE_DIRTY 2
+
+typedef struct {
+    uint32_t dev;
+    uint32_t block;              // Block number on the device
+    uint32_t sectors;            // Valid sectors (fewer at the end of a device)
+    uint8_t state;               // BCACHE_STATE_*
+    uint8_t readahead;           // Read ahead and not used yet
+    uint8_t meta;                // File system metadata
+    uint8_t queue;               // BCACHE_Q_*
+    uint32_t access_count;
+    uint64_t dirtied_ns;         // When a clean block was first written
+    int hash_next;               // Next block in the bucket, or next free block
+    int q_prev;                  // Towards the most recently queued/used
+    int q_next;                  // Towards the next victim
+    uint8_t* data;
+} bcache_block_t;
+
+static bcache_block_t* blocks;
+static uint8_t* block_data;
+static int* buckets;
+static uint32_t bucket_mask;
+static uint32_t capacity;
+static uint32_t block_size;
+static uint32_t block_sectors;   // Sectors per block
+static int free_list;
+static uint32_t dirty_count;
+static int* wb_order;            // Write-back scratch: blocks in sector order
+static uint8_t* io_buffer;       // A merged request
+static bcache_stats_t stats;
+
+// Intrusive list of blocks, most recent at the head
+typedef struct {
+    int head;
+    int tail;
+    uint32_t count;
+} bcache_queue_t;
+
+static bcache_queue_t queues[BCACHE_QUEUES];
+
+// Replacement policy: decides which queue a block lives on and which
+// block to recycle. Metadata blocks never reach the policy.
+typedef struct {
+    const char* name;
+    void (*reset)(void);
+    void (*insert)(int i);       // Block was just cached
+    void (*access)(int i);       // Cached block was used again
+    int (*victim)(void);         // Block to recycle, still queued; or none
+    void (*evicted)(int i);      // Victim is about to leave its queue
+} bcache_policy_t;
+
+static const bcache_policy_t* policy;
+
+// Flusher task
+static task_t flusher_task;
+static wait_queue_t flusher_wq;
+static volatile int flusher_kick;  // Too much dirty data, don't wait
+static int flusher_started;
+
+// A reader being followed for read-ahead
+typedef struct {
+    uint32_t dev;
+    uint32_t next;               // Sector a sequential read starts at
+    uint32_t window;             // Bytes; 0 until the stream is sequential
+    uint32_t ra_end;             // First block not read ahead yet
+    uint32_t last_use;
+    int in_use;
+} bcache_stream_t;
+
+static bcache_stream_t streams[BCACHE_RA_STREAMS];
+static uint32_t stream_clock;
+
+// Device access
+
+static uint32_t bcache_dev_sectors(uint32_t dev) {
+    if (dev == BCACHE_DEV_STORAGE) {
+        return hal_storage_get_total_sectors();
+    }
+    if (dev < BCACHE_MAX_DEVICES) {
+        ata_device_t* device = hal_ata_get_device(dev - BCACHE_DEV_ATA(0));
+        if (device && device->present) {
+            return device->size;
+        }
+    }
+    return 0;
+}
+
+// One request for count consecutive sectors
+static int bcache_dev_io(uint32_t dev, uint32_t sector, uint32_t count, void* buffer, int write) {
+    if (write) {
+        stats.dev_writes++;
+    } else {
+        stats.dev_reads++;
+    }
+    
+    if (dev == BCACHE_DEV_STORAGE) {
+        uint32_t offset = sector * BCACHE_SECTOR_SIZE;
+        uint32_t size = count * BCACHE_SECTOR_SIZE;
+        int result = write ? hal_storage_write(offset, buffer, size) : hal_storage_read(offset, buffer, size);
+        return result == (int)size ? 0 : -1;
+    }
+    
+    // The ATA driver takes at most 255 sectors per command
+    uint8_t drive = dev - BCACHE_DEV_ATA(0);
+    uint8_t* p = (uint8_t*)buffer;
+    while (count > 0) {
+        uint8_t n = count > 255 ? 255 : count;
+        int result = write ? hal_ata_write_sectors(drive, sector, n, p) : hal_ata_read_sectors(drive, sector, n, p);
+        if (result != 0) {
+            return -1;
+        }
+        sector += n;
+        count -= n;
+        p += n * BCACHE_SECTOR_SIZE;
+    }
+    return 0;
+}
+
+// Lists
+
+static uint32_t bcache_hash(uint32_t dev, uint32_t block) {
+    return ((block * 2654435761u) ^ (dev * 40503u)) & bucket_mask;
+}
+
+static void bcache_queue_unlink(int i) {
+    bcache_block_t* b = &blocks[i];
+    bcache_queue_t* q = &queues[b->queue];
+    if (b->q_prev != BCACHE_NONE) {
+        blocks[b->q_prev].q_next = b->q_next;
+    } else {
+        q->head = b->q_next;
+    }
+    if (b->q_next != BCACHE_NONE) {
+        blocks[b->q_next].q_prev = b->q_prev;
+    } else {
+        q->tail = b->q_prev;
+    }
+    q->count--;
+    b->queue = BCACHE_Q_NONE;
+}
+
+static void bcache_queue_push(int queue, int i) {
+    bcache_queue_t* q = &queues[queue];
+    blocks[i].queue = queue;
+    blocks[i].q_prev = BCACHE_NONE;
+    blocks[i].q_next = q->head;
+    if (q->head != BCACHE_NONE) {
+        blocks[q->head].q_prev = i;
+    } else {
+        q->tail = i;
+    }
+    q->head = i;
+    q->count++;
+}
+
+// Move a block to the head of its queue
+static void bcache_queue_touch(int i) {
+    int queue = blocks[i].queue;
+    if (queues[queue].head != i) {
+        bcache_queue_unlink(i);
+        bcache_queue_push(queue, i);
+    }
+}
+
+static void bcache_queues_reset(void) {
+    for (int q = 0; q < BCACHE_QUEUES; q++) {
+        queues[q].head = BCACHE_NONE;
+        queues[q].tail = BCACHE_NONE;
+        queues[q].count = 0;
+    }
+}
+
+// Replacement policies
+
+// LRU: one list, recycle the least recently used block
+static void lru_reset(void) {
+}
+
+static void lru_insert(int i) {
+    bcache_queue_push(BCACHE_Q_MAIN, i);
+}
+
+static void lru_access(int i) {
+    bcache_queue_touch(i);
+}
+
+static int lru_victim(void) {
+    return queues[BCACHE_Q_MAIN].tail;
+}
+
+static void lru_evicted(int i) {
+}
+
+// 2Q: new blocks wait in a FIFO (A1in) and are recycled from there
+// unless used again after they left it, which a ghost list of recently
+// recycled block numbers (A1out) remembers. Only those blocks join the
+// LRU list (Am), so a long scan passes through A1in without flushing it.
+
+#define TWOQ_GHOSTS (BCACHE_MAX_BLOCKS / 2)
+#define TWOQ_GHOST_BUCKETS (TWOQ_GHOSTS / 2)
+
+typedef struct {
+    uint32_t dev;
+    uint32_t block;
+    int next;                    // Hash chain
+    int valid;
+} twoq_ghost_t;
+
+static twoq_ghost_t twoq_ghosts[TWOQ_GHOSTS];
+static int twoq_buckets[TWOQ_GHOST_BUCKETS];
+static uint32_t twoq_ghost_pos;  // Oldest ghost, overwritten next
+
+// A1in holds a quarter of the cache, A1out remembers half of it
+static uint32_t twoq_kin(void) {
+    return capacity / 4 ? capacity / 4 : 1;
+}
+
+static uint32_t twoq_kout(void) {
+    return capacity / 2 ? capacity / 2 : 1;
+}
+
+static int* twoq_chain(uint32_t dev, uint32_t block) {
+    return &twoq_buckets[((block * 2654435761u) ^ dev) % TWOQ_GHOST_BUCKETS];
+}
+
+static void twoq_ghost_unlink(int g) {
+    int* link = twoq_chain(twoq_ghosts[g].dev, twoq_ghosts[g].block);
+    while (*link != g) {
+        link = &twoq_ghosts[*link].next;
+    }
+    *link = twoq_ghosts[g].next;
+    twoq_ghosts[g].valid = 0;
+}
+
+static void twoq_reset(void) {
+    for (int i = 0; i < TWOQ_GHOST_BUCKETS; i++) {
+        twoq_buckets[i] = BCACHE_NONE;
+    }
+    for (int i = 0; i < TWOQ_GHOSTS; i++) {
+        twoq_ghosts[i].valid = 0;
+    }
+    twoq_ghost_pos = 0;
+}
+
+static void twoq_insert(int i) {
+    bcache_block_t* b = &blocks[i];
+    int g = *twoq_chain(b->dev, b->block);
+    while (g != BCACHE_NONE && (twoq_ghosts[g].dev != b->dev || twoq_ghosts[g].block != b->block)) {
+        g = twoq_ghosts[g].next;
+    }
+    
+    if (g != BCACHE_NONE) {
+        // Recycled from A1in and wanted again: it is hot
+        twoq_ghost_unlink(g);
+        bcache_queue_push(BCACHE_Q_MAIN, i);
+    } else {
+        bcache_queue_push(BCACHE_Q_IN, i);
+    }
+}
+
+static void twoq_access(int i) {
+    if (blocks[i].queue == BCACHE_Q_MAIN) {
+        bcache_queue_touch(i);
+    }
+}
+
+static int twoq_victim(void) {
+    if (queues[BCACHE_Q_IN].count > twoq_kin() || queues[BCACHE_Q_MAIN].count == 0) {
+        return queues[BCACHE_Q_IN].tail;
+    }
+    return queues[BCACHE_Q_MAIN].tail;
+}
+
+static void twoq_evicted(int i) {
+    if (blocks[i].queue != BCACHE_Q_IN) {
+        return;
+    }
+    
+    int g = twoq_ghost_pos;
+    twoq_ghost_pos = (twoq_ghost_pos + 1) % twoq_kout();
+    if (twoq_ghosts[g].valid) {
+        twoq_ghost_unlink(g);
+    }
+    
+    int* chain = twoq_chain(blocks[i].dev, blocks[i].block);
+    twoq_ghosts[g].dev = blocks[i].dev;
+    twoq_ghosts[g].block = blocks[i].block;
+    twoq_ghosts[g].valid = 1;
+    twoq_ghosts[g].next = *chain;
+    *chain = g;
+}
+
+static const bcache_policy_t bcache_policies[BCACHE_POLICIES] = {
+    { "lru", lru_reset, lru_insert, lru_access, lru_victim, lru_evicted },
+    { "2q", twoq_reset, twoq_insert, twoq_access, twoq_victim, twoq_evicted },
+};
+
+// Queue a newly cached or re-classified block
+static void bcache_track(int i) {
+    if (blocks[i].meta) {
+        bcache_queue_push(BCACHE_Q_META, i);
+    } else {
+        policy->insert(i);
+    }
+}
+
+static int bcache_find(uint32_t dev, uint32_t block) {
+    int i = buckets[bcache_hash(dev, block)];
+    while (i != BCACHE_NONE && (blocks[i].dev != dev || blocks[i].block != block)) {
+        i = blocks[i].hash_next;
+    }
+    return i;
+}
+
+static void bcache_hash_remove(int i) {
+    int* link = &buckets[bcache_hash(blocks[i].dev, blocks[i].block)];
+    while (*link != i) {
+        link = &blocks[*link].hash_next;
+    }
+    *link = blocks[i].hash_next;
+}
+
+// Write a dirty block back
+static int bcache_flush_block(int i) {
+    bcache_block_t* b = &blocks[i];
+    if (b->state != BCACHE_STATE_DIRTY) {
+        return 0;
+    }
+    if (bcache_dev_io(b->dev, b->block * block_sectors, b->sectors, b->data, 1) != 0) {
+        return -1;
+    }
+    b->state = BCACHE_STATE_CLEAN;
+    dirty_count--;
+    stats.flushes++;
+    return 0;
+}
+
+// A block to reuse: a free one, else one the policy gives up. Metadata
+// is only recycled beyond its share of the cache, or as a last resort.
+static int bcache_take_block(void) {
+    if (free_list != BCACHE_NONE) {
+        int i = free_list;
+        free_list = blocks[i].hash_next;
+        return i;
+    }
+    
+    int i = BCACHE_NONE;
+    if (queues[BCACHE_Q_META].count > capacity * BCACHE_META_SHARE / 100) {
+        i = queues[BCACHE_Q_META].tail;
+    }
+    if (i == BCACHE_NONE) {
+        i = policy->victim();
+    }
+    if (i == BCACHE_NONE) {
+        i = queues[BCACHE_Q_META].tail;
+    }
+    if (i == BCACHE_NONE || bcache_flush_block(i) != 0) {
+        return BCACHE_NONE;  // Keep dirty data we could not write
+    }
+    
+    if (!blocks[i].meta) {
+        policy->evicted(i);
+    }
+    bcache_queue_unlink(i);
+    bcache_hash_remove(i);
+    if (blocks[i].readahead) {
+        stats.ra_waste++;
+    }
+    blocks[i].state = BCACHE_STATE_EMPTY;
+    stats.evictions++;
+    return i;
+}
+
+static void bcache_put_free(int i) {
+    blocks[i].state = BCACHE_STATE_EMPTY;
+    blocks[i].hash_next = free_list;
+    free_list = i;
+}
+
+// Make a taken block the cached copy of (dev, block)
+static void bcache_insert(int i, uint32_t dev, uint32_t block, uint32_t sectors, int readahead, int meta) {
+    bcache_block_t* b = &blocks[i];
+    b->dev = dev;
+    b->block = block;
+    b->sectors = sectors;
+    b->state = BCACHE_STATE_CLEAN;
+    b->readahead = readahead;
+    b->meta = meta;
+    b->access_count = readahead ? 0 : 1;
+    
+    uint32_t h = bcache_hash(dev, block);
+    b->hash_next = buckets[h];
+    buckets[h] = i;
+    bcache_track(i);
+}
+
+// Sectors of a block that exist on a device with dev_sectors sectors
+static uint32_t bcache_block_sectors(uint32_t block, uint32_t dev_sectors) {
+    uint32_t first = block * block_sectors;
+    return dev_sectors - first < block_sectors ? dev_sectors - first : block_sectors;
+}
+
+// Cached block for (dev, block). A block that is about to be overwritten
+// from sector off for n sectors is only read from the device if the
+// write leaves part of it unchanged. Using a block as metadata moves it
+// to the metadata queue for good.
+static int bcache_get(uint32_t dev, uint32_t block, uint32_t off, uint32_t n, int write, int meta) {
+    int i = bcache_find(dev, block);
+    if (i != BCACHE_NONE) {
+        stats.hits++;
+        if (meta && !blocks[i].meta) {
+            bcache_queue_unlink(i);
+            blocks[i].meta = 1;
+            bcache_track(i);
+        } else if (blocks[i].meta) {
+            bcache_queue_touch(i);
+        } else {
+            policy->access(i);
+        }
+        if (blocks[i].readahead) {
+            blocks[i].readahead = 0;
+            stats.ra_hits++;
+        }
+        blocks[i].access_count++;
+        return i;
+    }
+    
+    stats.misses++;
+    uint32_t dev_sectors = bcache_dev_sectors(dev);
+    if (block * block_sectors >= dev_sectors) {
+        return BCACHE_NONE;
+    }
+    
+    i = bcache_take_block();
+    if (i == BCACHE_NONE) {
+        return BCACHE_NONE;
+    }
+    
+    uint32_t sectors = bcache_block_sectors(block, dev_sectors);
+    if (!write || off != 0 || n < sectors) {
+        if (bcache_dev_io(dev, block * block_sectors, sectors, blocks[i].data, 0) != 0) {
+            bcache_put_free(i);
+            return BCACHE_NONE;
+        }
+    }
+    bcache_insert(i, dev, block, sectors, 0, meta);
+    return i;
+}
+
+// Read-ahead
+
+// Stream a read from sector belongs to; a new one if it is not sequential
+static bcache_stream_t* bcache_stream(uint32_t dev, uint32_t sector) {
+    bcache_stream_t* victim = &streams[0];
+    for (int i = 0; i < BCACHE_RA_STREAMS; i++) {
+        bcache_stream_t* s = &streams[i];
+        if (s->in_use && s->dev == dev && s->next == sector) {
+            // Sequential: open or widen the window
+            s->window = s->window ? s->window * 2 : BCACHE_RA_MIN;
+            if (s->window > BCACHE_RA_MAX) {
+                s->window = BCACHE_RA_MAX;
+            }
+            s->last_use = ++stream_clock;
+            return s;
+        }
+        if (!s->in_use || (victim->in_use && s->last_use < victim->last_use)) {
+            victim = s;
+        }
+    }
+    
+    victim->in_use = 1;
+    victim->dev = dev;
+    victim->window = 0;
+    victim->ra_end = 0;
+    victim->last_use = ++stream_clock;
+    return victim;
+}
+
+// Read blocks [first, end) that are not cached, each run of missing
+// blocks in one request. Blocks from mark on were not asked for.
+static void bcache_read_blocks(uint32_t dev, uint32_t first, uint32_t end, uint32_t mark) {
+    uint32_t dev_sectors = bcache_dev_sectors(dev);
+    uint32_t max_run = BCACHE_IO_SIZE / block_size;
+    uint32_t block = first;
+    
+    while (block < end && block * block_sectors < dev_sectors) {
+        if (bcache_find(dev, block) != BCACHE_NONE) {
+            block++;
+            continue;
+        }
+        
+        // Collect the run of missing blocks starting here
+        int run[BCACHE_IO_SIZE / BCACHE_SECTOR_SIZE];
+        uint32_t count = 0;
+        uint32_t sectors = 0;
+        while (block + count < end && count < max_run &&
+               (block + count) * block_sectors < dev_sectors &&
+               bcache_find(dev, block + count) == BCACHE_NONE) {
+            int i = bcache_take_block();
+            if (i == BCACHE_NONE) {
+                break;
+            }
+            run[count] = i;
+            sectors += bcache_block_sectors(block + count, dev_sectors);
+            count++;
+        }
+        if (count == 0) {
+            return;
+        }
+        
+        stats.ra_requests++;
+        int ok = bcache_dev_io(dev, block * block_sectors, sectors, io_buffer, 0) == 0;
+        for (uint32_t k = 0; k < count; k++) {
+            if (!ok) {
+                bcache_put_free(run[k]);
+                continue;
+            }
+            uint32_t n = bcache_block_sectors(block + k, dev_sectors);
+            memcpy(blocks[run[k]].data, io_buffer + k * block_size, n * BCACHE_SECTOR_SIZE);
+            bcache_insert(run[k], dev, block + k, n, block + k >= mark, 0);
+            if (block + k >= mark) {
+                stats.ra_blocks++;
+            }
+        }
+        if (!ok) {
+            return;
+        }
+        block += count;
+    }
+}
+
+// Before a read of count sectors: on a sequential stream, make sure the
+// blocks asked for and a window beyond them are cached, fetching the
+// next window once the reader is halfway into the current one
+static void bcache_readahead(uint32_t dev, uint32_t sector, uint32_t count) {
+    bcache_stream_t* s = bcache_stream(dev, sector);
+    s->next = sector + count;
+    if (!s->window) {
+        return;
+    }
+    
+    uint32_t first = sector / block_sectors;
+    uint32_t end = (sector + count + block_sectors - 1) / block_sectors;
+    uint32_t ahead = s->window / block_size;
+    if (ahead > capacity / 4) {
+        ahead = capacity / 4;  // Never let read-ahead flush the cache
+    }
+    if (ahead == 0) {
+        ahead = 1;
+    }
+    
+    if (s->ra_end < first) {
+        s->ra_end = first;
+    }
+    if (s->ra_end >= end + (ahead + 1) / 2) {
+        return;
+    }
+    bcache_read_blocks(dev, s->ra_end, end + ahead, end);
+    s->ra_end = end + ahead;
+}
+
+// Write-back
+
+// Dirty blocks in write order: by device, then by block
+static int bcache_wb_before(int a, int b) {
+    if (blocks[a].dev != blocks[b].dev) {
+        return blocks[a].dev < blocks[b].dev;
+    }
+    return blocks[a].block < blocks[b].block;
+}
+
+static void bcache_wb_sort(int* order, uint32_t n) {
+    // Shell sort; n is at most the capacity
+    for (uint32_t gap = n / 2; gap > 0; gap /= 2) {
+        for (uint32_t i = gap; i < n; i++) {
+            int v = order[i];
+            uint32_t j = i;
+            while (j >= gap && bcache_wb_before(v, order[j - gap])) {
+                order[j] = order[j - gap];
+                j -= gap;
+            }
+            order[j] = v;
+        }
+    }
+}
+
+// Whether block b can follow block a in the same device request
+static int bcache_wb_adjacent(int a, int b, uint32_t sectors) {
+    return blocks[b].dev == blocks[a].dev && blocks[b].block == blocks[a].block + 1 &&
+           blocks[a].sectors == block_sectors &&
+           (sectors + blocks[b].sectors) * BCACHE_SECTOR_SIZE <= BCACHE_MAX_WRITE_SIZE;
+}
+
+// Write back dirty blocks that were dirtied at or before cutoff, stopping
+// once no more than target blocks are dirty. Neighbouring blocks go out
+// as one request.
+static int bcache_writeback(uint64_t cutoff, uint32_t target) {
+    uint64_t start = hal_timer_get_ns();
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < capacity; i++) {
+        if (blocks[i].state == BCACHE_STATE_DIRTY && blocks[i].dirtied_ns <= cutoff) {
+            wb_order[n++] = i;
+        }
+    }
+    if (n == 0) {
+        return 0;
+    }
+    bcache_wb_sort(wb_order, n);
+    
+    int result = 0;
+    uint32_t written = 0;
+    uint32_t requests = 0;
+    for (uint32_t first = 0; first < n && dirty_count > target; ) {
+        // Extend the run while the next block continues it on disk
+        uint32_t last = first;
+        uint32_t sectors = blocks[wb_order[first]].sectors;
+        while (last + 1 < n && bcache_wb_adjacent(wb_order[last], wb_order[last + 1], sectors)) {
+            last++;
+            sectors += blocks[wb_order[last]].sectors;
+        }
+        
+        bcache_block_t* b = &blocks[wb_order[first]];
+        void* data = b->data;
+        if (last > first) {
+            for (uint32_t k = first; k <= last; k++) {
+                memcpy(io_buffer + (k - first) * block_size, blocks[wb_order[k]].data,
+                       blocks[wb_order[k]].sectors * BCACHE_SECTOR_SIZE);
+            }
+            data = io_buffer;
+        }
+        
+        requests++;
+        if (bcache_dev_io(b->dev, b->block * block_sectors, sectors, data, 1) != 0) {
+            result = -1;  // Leave them dirty, try the next run
+        } else {
+            for (uint32_t k = first; k <= last; k++) {
+                blocks[wb_order[k]].state = BCACHE_STATE_CLEAN;
+            }
+            written += last - first + 1;
+            dirty_count -= last - first + 1;
+        }
+        first = last + 1;
+    }
+    
+    stats.flushes += written;
+    stats.wb_runs++;
+    stats.wb_blocks += written;
+    stats.wb_requests += requests;
+    stats.wb_last_blocks = written;
+    stats.wb_last_requests = requests;
+    stats.wb_last_us = (uint32_t)cpu_div64_32(hal_timer_get_ns() - start, NSEC_PER_USEC, NULL);
+    return result;
+}
+
+// A write just dirtied more of the cache
+static void bcache_balance_dirty(void) {
+    uint32_t background = capacity * BCACHE_DIRTY_BACKGROUND / 100;
+    if (dirty_count >= capacity * BCACHE_DIRTY_RATIO / 100) {
+        // No other thread can run while we wait, so wait by writing
+        stats.throttled++;
+        bcache_writeback(UINT64_MAX, background);
+    } else if (dirty_count > background && flusher_started && !flusher_kick) {
+        flusher_kick = 1;
+        wait_queue_wake_all(&flusher_wq);
+    }
+}
+
+static int bcache_flusher_func(task_t* task) {
+    TASK_BEGIN(task);
+    while (1) {
+        TASK_WAIT_EVENT_TIMEOUT(task, &flusher_wq, flusher_kick, BCACHE_FLUSH_INTERVAL_MS);
+        if (!blocks) {
+            continue;
+        }
+        
+        if (flusher_kick) {
+            flusher_kick = 0;
+            bcache_writeback(UINT64_MAX, capacity * BCACHE_DIRTY_BACKGROUND / 100);
+        }
+        
+        uint64_t now = hal_timer_get_ns();
+        uint64_t expire = BCACHE_DIRTY_EXPIRE_MS * NSEC_PER_MSEC;
+        if (now > expire) {
+            bcache_writeback(now - expire, 0);
+        }
+    }
+    TASK_END(task);
+}
+
+void bcache_start_flusher(void) {
+    if (flusher_started) {
+        return;
+    }
+    wait_queue_init(&flusher_wq);
+    task_init(&flusher_task, "bflush", bcache_flusher_func, NULL);
+    task_start(&flusher_task);
+    flusher_started = 1;
+}
+
+// Copy count sectors between buffer and the cache, a block at a time
+static int bcache_transfer(uint32_t dev, uint32_t sector, uint8_t* buffer, uint32_t count, int write, int meta) {
+    if (!blocks || dev >= BCACHE_MAX_DEVICES) {
+        return -1;
+    }
+    
+    while (count > 0) {
+        uint32_t block = sector / block_sectors;
+        uint32_t off = sector % block_sectors;
+        uint32_t n = block_sectors - off;
+        if (n > count) {
+            n = count;
+        }
+        
+        int i = bcache_get(dev, block, off, n, write, meta);
+        if (i == BCACHE_NONE || off + n > blocks[i].sectors) {
+            return -1;
+        }
+        
+        bcache_block_t* b = &blocks[i];
+        uint8_t* data = b->data + off * BCACHE_SECTOR_SIZE;
+        if (write) {
+            memcpy(data, buffer, n * BCACHE_SECTOR_SIZE);
+            if (b->state != BCACHE_STATE_DIRTY) {
+                b->state = BCACHE_STATE_DIRTY;
+                b->dirtied_ns = hal_timer_get_ns();
+                dirty_count++;
+                bcache_balance_dirty();
+            }
+        } else {
+            memcpy(buffer, data, n * BCACHE_SECTOR_SIZE);
+        }
+        
+        sector += n;
+        count -= n;
+        buffer += n * BCACHE_SECTOR_SIZE;
+    }
+    return 0;
+}
+
+int bcache_read(uint32_t dev, uint32_t sector, void* buffer, uint32_t count) {
+    if (blocks && dev < BCACHE_MAX_DEVICES && count > 0) {
+        bcache_readahead(dev, sector, count);
+    }
+    return bcache_transfer(dev, sector, (uint8_t*)buffer, count, 0, 0);
+}
+
+int bcache_write(uint32_t dev, uint32_t sector, const void* buffer, uint32_t count) {
+    return bcache_transfer(dev, sector, (uint8_t*)buffer, count, 1, 0);
+}
+
+int bcache_read_meta(uint32_t dev, uint32_t sector, void* buffer, uint32_t count) {
+    return bcache_transfer(dev, sector, (uint8_t*)buffer, count, 0, 1);
+}
+
+int bcache_write_meta(uint32_t dev, uint32_t sector, const void* buffer, uint32_t count) {
+    return bcache_transfer(dev, sector, (uint8_t*)buffer, count, 1, 1);
+}
+
+int bcache_sync(void) {
+    if (!blocks) {
+        return 0;
+    }
+    return bcache_writeback(UINT64_MAX, 0);
+}
+
+int bcache_init(uint32_t size, uint32_t count) {
+    if (size < BCACHE_SECTOR_SIZE || size > BCACHE_MAX_BLOCK_SIZE || (size & (size - 1))) {
+        return -1;
+    }
+    
+    if (blocks) {
+        if (bcache_sync() != 0) {
+            return -1;
+        }
+        kfree(blocks);
+        kfree(block_data);
+        kfree(buckets);
+        kfree(wb_order);
+        kfree(io_buffer);
+        blocks = NULL;
+        capacity = 0;
+    }
+    
+    if (count == 0) {
+        size_t total, used, free;
+        kmalloc_stats(&total, &used, &free);
+        count = free / BCACHE_MEMORY_SHARE / size;
+        
+        // Read-ahead may use a quarter of the cache; make that a full
+        // window if memory allows
+        if (count < BCACHE_RA_BLOCKS(size) && BCACHE_RA_MAX * 4 <= free / 4) {
+            count = BCACHE_RA_BLOCKS(size);
+        }
+    }
+    if (count < BCACHE_MIN_BLOCKS) {
+        count = BCACHE_MIN_BLOCKS;
+    } else if (count > BCACHE_MAX_BLOCKS) {
+        count = BCACHE_MAX_BLOCKS;
+    }
+    
+    // About two blocks per chain when full
+    uint32_t bucket_count = 1;
+    while (bucket_count * 2 < count) {
+        bucket_count <<= 1;
+    }
+    
+    blocks = kmalloc(count * sizeof(bcache_block_t));
+    block_data = kmalloc(count * size);
+    buckets = kmalloc(bucket_count * sizeof(int));
+    wb_order = kmalloc(count * sizeof(int));
+    io_buffer = kmalloc(BCACHE_IO_SIZE);
+    if (!blocks || !block_data || !buckets || !wb_order || !io_buffer) {
+        kfree(blocks);
+        kfree(block_data);
+        kfree(buckets);
+        kfree(wb_order);
+        kfree(io_buffer);
+        blocks = NULL;
+        return -1;
+    }
+    
+    capacity = count;
+    block_size = size;
+    block_sectors = size / BCACHE_SECTOR_SIZE;
+    bucket_mask = bucket_count - 1;
+    for (uint32_t i = 0; i < bucket_count; i++) {
+        buckets[i] = BCACHE_NONE;
+    }
+    
+    free_list = BCACHE_NONE;
+    for (int i = count - 1; i >= 0; i--) {
+        blocks[i].data = block_data + i * size;
+        blocks[i].access_count = 0;
+        bcache_put_free(i);
+    }
+    bcache_queues_reset();
+    if (!policy) {
+        policy = &bcache_policies[BCACHE_POLICY_LRU];
+    }
+    policy->reset();
+    dirty_count = 0;
+    memset(streams, 0, sizeof(streams));
+    
+    memset(&stats, 0, sizeof(stats));
+    return 0;
+}
+
+int bcache_set_policy(int which) {
+    if (which < 0 || which >= BCACHE_POLICIES) {
+        return -1;
+    }
+    
+    const bcache_policy_t* old = policy;
+    policy = &bcache_policies[which];
+    if (!blocks || old == policy) {
+        return 0;
+    }
+    
+    // Hand the cached blocks over oldest first, so the most recently used
+    // end up most recent under the new policy too
+    uint32_t n = 0;
+    for (int q = BCACHE_Q_IN; q >= BCACHE_Q_MAIN; q--) {
+        for (int i = queues[q].tail; i != BCACHE_NONE; i = blocks[i].q_prev) {
+            wb_order[n++] = i;
+        }
+    }
+    for (uint32_t k = 0; k < n; k++) {
+        bcache_queue_unlink(wb_order[k]);
+    }
+    policy->reset();
+    for (uint32_t k = 0; k < n; k++) {
+        policy->insert(wb_order[k]);
+    }
+    
+    // Start counting afresh so hit rates can be compared
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.evictions = 0;
+    return 0;
+}
+
+int bcache_get_policy(void) {
+    return policy ? policy - bcache_policies : BCACHE_POLICY_LRU;
+}
+
+const char* bcache_policy_name(int which) {
+    if (which < 0 || which >= BCACHE_POLICIES) {
+        return NULL;
+    }
+    return bcache_policies[which].name;
+}
+
+void bcache_get_stats(bcache_stats_t* out) {
+    *out = stats;
+    out->block_size = block_size;
+    out->capacity = capacity;
+    out->policy = bcache_get_policy();
+    out->meta = queues[BCACHE_Q_META].count;
+    for (uint32_t i = 0; i < capacity; i++) {
+        if (blocks[i].state == BCACHE_STATE_CLEAN) {
+            out->clean++;
+        } else if (blocks[i].state == BCACHE_STATE_DIRTY) {
+            out->dirty++;
+        }
+    }
+}
+
+int bcache_top_blocks(bcache_block_info_t* info, int max) {
+    int count = 0;
+    for (uint32_t i = 0; i < capacity; i++) {
+        bcache_block_t* b = &blocks[i];
+        if (b->state == BCACHE_STATE_EMPTY) {
+            continue;
+        }
+        
+        // Insertion into the short sorted list
+        int pos = count < max ? count++ : max;
+        while (pos > 0 && info[pos - 1].access_count < b->access_count) {
+            if (pos < max) {
+                info[pos] = info[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < max) {
+            info[pos].dev = b->dev;
+            info[pos].sector = b->block * block_sectors;
+            info[pos].access_count = b->access_count;
+            info[pos].dirty = b->state == BCACHE_STATE_DIRTY;
+        }
+    }
+    return count;
+}
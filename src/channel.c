@@ -0,0 +1,372 @@
+// src/channel.c
+#include "channel.h"
+#include "file.h"
+#include "hal_timer.h"
+#include "hrtimer.h"
+#include "interrupts.h"
+#include "kmalloc.h"
+#include "memory.h"
+#include "pollset.h"
+#include "string.h"
+#include "syscall.h"
+#include "vm.h"
+#include <stddef.h>
+
+// Pages handed to one slot
+typedef struct {
+    uint32_t frames[CHANNEL_MAX_PAGES];
+    uint32_t count;
+    uint32_t len;
+} channel_pages_t;
+
+// Kernel side of a channel
+typedef struct {
+    char name[CHANNEL_NAME_MAX];     // Empty = free entry
+    uint32_t refs;                   // Open file objects
+    channel_shared_t* shared;
+    uint32_t slots;                  // Ring size; shared->slots is not trusted
+    void* block;                     // kmalloc() block behind shared
+    uint32_t size;                   // Bytes of shared pages
+    channel_pages_t* pages;          // One record per slot
+    wait_queue_t wait;               // Woken by SYS_CHANNEL_NOTIFY
+} channel_t;
+
+static channel_t channels[CHANNEL_MAX];
+
+static channel_t* channel_find(const char* name) {
+    for (int i = 0; i < CHANNEL_MAX; i++) {
+        if (channels[i].name[0] && strcmp(channels[i].name, name) == 0) {
+            return &channels[i];
+        }
+    }
+    return NULL;
+}
+
+// Messages queued, as the kernel sees it
+static uint32_t channel_queued(channel_t* ch) {
+    return ch->shared->tail - ch->shared->head;
+}
+
+static channel_t* channel_get(int fd) {
+    file_t* file = fd_get(fd);
+    if (!file || file->type != FILE_TYPE_CHANNEL) {
+        return NULL;
+    }
+    return (channel_t*)file->private_data;
+}
+
+// Frames the kernel side may hand over: whole pages of the frame pool
+static int channel_frame_ok(uint32_t frame) {
+    return !(frame & (PAGE_SIZE - 1)) && frame >= FRAME_POOL_BASE && frame < LOW_MAP_END;
+}
+
+static void channel_drop_pages(channel_pages_t* record) {
+    for (uint32_t i = 0; i < record->count; i++) {
+        page_frame_free(record->frames[i]);
+    }
+    record->count = 0;
+    record->len = 0;
+}
+
+// Open or close the shared pages to CPL 3
+static void channel_expose(channel_t* ch, int user) {
+    uint32_t prot = MEM_PROT_READ | MEM_PROT_WRITE | (user ? MEM_PROT_USER : 0);
+    for (uint32_t off = 0; off < ch->size; off += PAGE_SIZE) {
+        uint32_t page = (uint32_t)ch->shared + off;
+        map_page(page, page, prot);
+    }
+}
+
+static void channel_destroy(channel_t* ch) {
+    for (uint32_t i = 0; i < ch->slots; i++) {
+        channel_drop_pages(&ch->pages[i]);
+    }
+    channel_expose(ch, 0);
+    kfree(ch->pages);
+    kfree(ch->block);
+    ch->name[0] = '\0';
+}
+
+static void channel_release(file_t* file) {
+    channel_t* ch = (channel_t*)file->private_data;
+    if (--ch->refs == 0) {
+        channel_destroy(ch);
+    }
+}
+
+// Readable with a message queued, writable with a slot free
+static uint32_t channel_poll(file_t* file, wait_queue_t** wq) {
+    channel_t* ch = (channel_t*)file->private_data;
+    uint32_t queued = channel_queued(ch);
+    *wq = &ch->wait;
+    return (queued ? POLL_IN : 0) | (queued < ch->slots ? POLL_OUT : 0);
+}
+
+static const file_ops_t channel_ops = { NULL, NULL, channel_release, channel_poll };
+
+static int channel_create(channel_t* ch, const char* name, uint32_t slots) {
+    // Ring sizes are powers of two so indices wrap with a mask
+    uint32_t count = 1;
+    while (count < slots) {
+        count <<= 1;
+    }
+    
+    // Whole pages, so exposing them to CPL 3 exposes nothing else
+    uint32_t bytes = sizeof(channel_shared_t) + count * sizeof(channel_slot_t);
+    uint32_t size = (bytes + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    void* block = kmalloc(size + PAGE_SIZE - 1);
+    channel_pages_t* pages = kmalloc(count * sizeof(channel_pages_t));
+    if (!block || !pages) {
+        kfree(block);
+        kfree(pages);
+        return SYSCALL_ENOMEM;
+    }
+    
+    channel_shared_t* shared = (channel_shared_t*)(((uint32_t)block + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1));
+    memset(shared, 0, size);
+    shared->slots = count;
+    memset(pages, 0, count * sizeof(channel_pages_t));
+    
+    strncpy(ch->name, name, CHANNEL_NAME_MAX - 1);
+    ch->name[CHANNEL_NAME_MAX - 1] = '\0';
+    ch->refs = 0;
+    ch->shared = shared;
+    ch->slots = count;
+    ch->block = block;
+    ch->size = size;
+    ch->pages = pages;
+    wait_queue_init(&ch->wait);
+    channel_expose(ch, 1);
+    return 0;
+}
+
+int channel_open(const char* name, uint32_t slots, channel_shared_t** shared_out) {
+    uint32_t len = strlen(name);
+    if (len == 0 || len >= CHANNEL_NAME_MAX || slots > CHANNEL_MAX_SLOTS) {
+        return SYSCALL_EINVAL;
+    }
+    
+    channel_t* ch = channel_find(name);
+    if (slots == 0 && !ch) {
+        return SYSCALL_ENOENT;
+    }
+    if (slots != 0) {
+        if (ch) {
+            return SYSCALL_EEXIST;
+        }
+        for (int i = 0; i < CHANNEL_MAX && !ch; i++) {
+            if (!channels[i].name[0]) {
+                ch = &channels[i];
+            }
+        }
+        if (!ch) {
+            return SYSCALL_ENOMEM;
+        }
+        
+        int error = channel_create(ch, name, slots);
+        if (error < 0) {
+            return error;
+        }
+    }
+    
+    file_t* file = file_create(FILE_TYPE_CHANNEL, O_RDWR, &channel_ops, ch);
+    if (!file) {
+        if (ch->refs == 0) {
+            channel_destroy(ch);
+        }
+        return SYSCALL_EMFILE;
+    }
+    ch->refs++;
+    
+    int fd = fd_install(file);
+    if (fd < 0) {
+        file_put(file);
+        return fd;
+    }
+    
+    *shared_out = ch->shared;
+    return fd;
+}
+
+int channel_notify(int fd) {
+    channel_t* ch = channel_get(fd);
+    if (!ch) {
+        return SYSCALL_EINVAL;
+    }
+    
+    ch->shared->notifies++;
+    wait_queue_wake_all(&ch->wait);
+    return 0;
+}
+
+static int channel_ready(channel_t* ch, uint32_t condition) {
+    uint32_t queued = channel_queued(ch);
+    return condition == CHANNEL_WAIT_DATA ? queued != 0 : queued < ch->slots;
+}
+
+int channel_wait(int fd, uint32_t condition, uint32_t timeout_ms) {
+    channel_t* ch = channel_get(fd);
+    if (!ch || condition > CHANNEL_WAIT_SPACE) {
+        return SYSCALL_EINVAL;
+    }
+    
+    // Only interrupt-driven peers can run while we halt, so the wait is
+    // always bounded by the timeout
+    uint64_t deadline = hal_timer_get_ns() + timeout_ms * NSEC_PER_MSEC;
+    while (!channel_ready(ch, condition)) {
+        if (hal_timer_get_ns() >= deadline) {
+            return SYSCALL_EBUSY;
+        }
+        
+        uint32_t flags = irq_save();
+        if (!channel_ready(ch, condition)) {
+            irq_enable_and_halt();
+        }
+        irq_restore(flags);
+    }
+    return 0;
+}
+
+// Page record of the slot at tail, emptied for a new attach; NULL if
+// the ring is full
+static channel_pages_t* channel_attach_begin(channel_t* ch) {
+    if (channel_queued(ch) >= ch->slots) {
+        return NULL;
+    }
+    
+    channel_pages_t* record = &ch->pages[ch->shared->tail & (ch->slots - 1)];
+    channel_drop_pages(record);  // Never taken by the last receiver
+    return record;
+}
+
+// Describe the attached pages in the slot the sender is filling
+static int channel_attach_end(channel_t* ch, channel_pages_t* record, uint32_t count, uint32_t len) {
+    record->count = count;
+    record->len = len;
+    
+    channel_slot_t* entry = &ch->shared->ring[record - ch->pages];
+    entry->len = len;
+    entry->flags |= CHANNEL_SLOT_PAGES;
+    entry->pages = count;
+    return count;
+}
+
+// Page record of the slot at head; NULL if the ring is empty
+static channel_pages_t* channel_take_record(channel_t* ch) {
+    if (channel_queued(ch) == 0) {
+        return NULL;
+    }
+    return &ch->pages[ch->shared->head & (ch->slots - 1)];
+}
+
+// Give the user pages at [addr, addr + len) to the slot at tail
+static int channel_attach_user(channel_t* ch, uint32_t addr, uint32_t len) {
+    channel_pages_t* record = channel_attach_begin(ch);
+    if (!record) {
+        return SYSCALL_EBUSY;
+    }
+    
+    uint32_t count = (len + PAGE_SIZE - 1) / PAGE_SIZE;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t frame = vm_detach_page(addr + i * PAGE_SIZE);
+        if (!frame) {
+            // Put back what already left the sender
+            while (i-- > 0) {
+                vm_attach_page(addr + i * PAGE_SIZE, record->frames[i]);
+            }
+            return SYSCALL_EFAULT;
+        }
+        record->frames[i] = frame;
+    }
+    return channel_attach_end(ch, record, count, len);
+}
+
+// Map the pages of the slot at head at [addr, addr + len)
+static int channel_take_user(channel_t* ch, uint32_t addr, uint32_t len) {
+    channel_pages_t* record = channel_take_record(ch);
+    if (!record || record->count == 0) {
+        return SYSCALL_EINVAL;
+    }
+    if (len < record->count * PAGE_SIZE) {
+        return SYSCALL_EFAULT;
+    }
+    
+    int result = record->len;
+    for (uint32_t i = 0; i < record->count; i++) {
+        if (result >= 0) {
+            int error = vm_attach_page(addr + i * PAGE_SIZE, record->frames[i]);
+            if (error == 0) {
+                continue;
+            }
+            result = error;
+        }
+        page_frame_free(record->frames[i]);
+    }
+    record->count = 0;
+    record->len = 0;
+    return result;
+}
+
+int channel_pages(int fd, uint32_t op, uint32_t addr, uint32_t len) {
+    channel_t* ch = channel_get(fd);
+    if (!ch) {
+        return SYSCALL_EINVAL;
+    }
+    
+    // Only the user window has addresses to move frames between
+    if ((addr & (PAGE_SIZE - 1)) || addr < USER_BASE || addr >= USER_TOP ||
+        len > USER_TOP - addr) {
+        return SYSCALL_EFAULT;
+    }
+    
+    switch (op) {
+        case CHANNEL_PAGES_ATTACH:
+            if (len == 0 || len > CHANNEL_MAX_PAGES * PAGE_SIZE) {
+                return SYSCALL_EINVAL;
+            }
+            return channel_attach_user(ch, addr, len);
+        case CHANNEL_PAGES_TAKE:
+            return channel_take_user(ch, addr, len);
+        default:
+            return SYSCALL_EINVAL;
+    }
+}
+
+int channel_attach_frames(int fd, const uint32_t* frames, uint32_t count, uint32_t len) {
+    channel_t* ch = channel_get(fd);
+    if (!ch || count == 0 || count > CHANNEL_MAX_PAGES || len > count * PAGE_SIZE) {
+        return SYSCALL_EINVAL;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (!channel_frame_ok(frames[i])) {
+            return SYSCALL_EFAULT;
+        }
+    }
+    
+    channel_pages_t* record = channel_attach_begin(ch);
+    if (!record) {
+        return SYSCALL_EBUSY;
+    }
+    
+    memcpy(record->frames, frames, count * sizeof(uint32_t));
+    return channel_attach_end(ch, record, count, len);
+}
+
+int channel_take_frames(int fd, uint32_t* frames) {
+    channel_t* ch = channel_get(fd);
+    channel_pages_t* record = ch ? channel_take_record(ch) : NULL;
+    if (!record) {
+        return SYSCALL_EINVAL;
+    }
+    
+    uint32_t count = record->count;
+    memcpy(frames, record->frames, count * sizeof(uint32_t));
+    record->count = 0;
+    record->len = 0;
+    return count;
+}
+
+wait_queue_t* channel_wait_queue(int fd) {
+    channel_t* ch = channel_get(fd);
+    return ch ? &ch->wait : NULL;
+}
@@ -0,0 +1,164 @@
+// src/dcache.c
+#include "dcache.h"
+#include "fs.h"
+#include "string.h"
+
+// End of a chain or list
+#define DCACHE_NONE (-1)
+
+typedef struct {
+    char name[FS_MAX_FILENAME];
+    int parent;                      // Directory the name lives in
+    int index;                       // Child node or DCACHE_NEGATIVE
+    uint32_t hash;
+    int hash_next;                   // Next entry in the bucket
+    int lru_prev;                    // Towards the most recently used
+    int lru_next;                    // Towards the least recently used
+} dcache_entry_t;
+
+static dcache_entry_t dcache[DCACHE_ENTRIES];
+static int dcache_buckets[DCACHE_BUCKETS];
+static int dcache_free;              // Unused entries, chained by hash_next
+static int lru_head;                 // Most recently used
+static int lru_tail;                 // Next to be recycled
+static dcache_stats_t dcache_stats;
+
+// FNV-1a over the name, seeded with the parent
+static uint32_t dcache_hash(int parent, const char* name) {
+    uint32_t hash = 2166136261u ^ (uint32_t)parent;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void dcache_lru_unlink(int i) {
+    dcache_entry_t* entry = &dcache[i];
+    if (entry->lru_prev != DCACHE_NONE) {
+        dcache[entry->lru_prev].lru_next = entry->lru_next;
+    } else {
+        lru_head = entry->lru_next;
+    }
+    if (entry->lru_next != DCACHE_NONE) {
+        dcache[entry->lru_next].lru_prev = entry->lru_prev;
+    } else {
+        lru_tail = entry->lru_prev;
+    }
+}
+
+static void dcache_lru_push(int i) {
+    dcache[i].lru_prev = DCACHE_NONE;
+    dcache[i].lru_next = lru_head;
+    if (lru_head != DCACHE_NONE) {
+        dcache[lru_head].lru_prev = i;
+    } else {
+        lru_tail = i;
+    }
+    lru_head = i;
+}
+
+// Entry for (parent, name), or DCACHE_NONE
+static int dcache_find(int parent, const char* name, uint32_t hash) {
+    int i = dcache_buckets[hash & (DCACHE_BUCKETS - 1)];
+    while (i != DCACHE_NONE) {
+        dcache_entry_t* entry = &dcache[i];
+        if (entry->hash == hash && entry->parent == parent && strcmp(entry->name, name) == 0) {
+            return i;
+        }
+        i = entry->hash_next;
+    }
+    return DCACHE_NONE;
+}
+
+// Take an entry off its hash chain and the LRU list
+static void dcache_remove(int i) {
+    int* link = &dcache_buckets[dcache[i].hash & (DCACHE_BUCKETS - 1)];
+    while (*link != i) {
+        link = &dcache[*link].hash_next;
+    }
+    *link = dcache[i].hash_next;
+    dcache_lru_unlink(i);
+    dcache_stats.entries--;
+}
+
+void dcache_flush(void) {
+    for (int i = 0; i < DCACHE_BUCKETS; i++) {
+        dcache_buckets[i] = DCACHE_NONE;
+    }
+    for (int i = 0; i < DCACHE_ENTRIES; i++) {
+        dcache[i].hash_next = i + 1 < DCACHE_ENTRIES ? i + 1 : DCACHE_NONE;
+    }
+    dcache_free = 0;
+    lru_head = DCACHE_NONE;
+    lru_tail = DCACHE_NONE;
+    dcache_stats.entries = 0;
+}
+
+void dcache_init(void) {
+    memset(&dcache_stats, 0, sizeof(dcache_stats));
+    dcache_flush();
+}
+
+int dcache_lookup(int parent, const char* name, int* index) {
+    int i = dcache_find(parent, name, dcache_hash(parent, name));
+    if (i == DCACHE_NONE) {
+        dcache_stats.misses++;
+        return 0;
+    }
+    
+    if (i != lru_head) {
+        dcache_lru_unlink(i);
+        dcache_lru_push(i);
+    }
+    
+    *index = dcache[i].index;
+    dcache_stats.hits++;
+    if (*index == DCACHE_NEGATIVE) {
+        dcache_stats.negative_hits++;
+    }
+    return 1;
+}
+
+void dcache_insert(int parent, const char* name, int index) {
+    if (strlen(name) >= FS_MAX_FILENAME) {
+        return;
+    }
+    
+    uint32_t hash = dcache_hash(parent, name);
+    int i = dcache_find(parent, name, hash);
+    if (i != DCACHE_NONE) {
+        // Same name, new answer
+        dcache[i].index = index;
+        if (i != lru_head) {
+            dcache_lru_unlink(i);
+            dcache_lru_push(i);
+        }
+        return;
+    }
+    
+    if (dcache_free != DCACHE_NONE) {
+        i = dcache_free;
+        dcache_free = dcache[i].hash_next;
+    } else {
+        i = lru_tail;
+        dcache_remove(i);
+        dcache_stats.evictions++;
+    }
+    
+    dcache_entry_t* entry = &dcache[i];
+    strcpy(entry->name, name);
+    entry->parent = parent;
+    entry->index = index;
+    entry->hash = hash;
+    
+    int* bucket = &dcache_buckets[hash & (DCACHE_BUCKETS - 1)];
+    entry->hash_next = *bucket;
+    *bucket = i;
+    dcache_lru_push(i);
+    dcache_stats.entries++;
+}
+
+void dcache_get_stats(dcache_stats_t* stats) {
+    *stats = dcache_stats;
+}
@@ -0,0 +1,200 @@
+// src/elf.c
+#include "elf.h"
+#include "file.h"
+#include "interrupts.h"
+#include "memory.h"
+#include "process.h"
+#include "string.h"
+#include "stdio.h"
+#include "syscall.h"
+#include "terminal.h"
+#include "uaccess.h"
+#include "vdso.h"
+#include "vm.h"
+#include <stddef.h>
+
+// Leave user_mode_call() from CPL 0 with result (syscall_entry.asm)
+extern void user_mode_abort(int result) __attribute__((noreturn));
+
+// The program in the user window, if any
+static int exec_active = 0;
+static uint32_t exec_pid = 0;
+
+static int elf_check_header(const elf32_ehdr_t* ehdr) {
+    if (ehdr->e_magic != ELF_MAGIC || ehdr->e_class != ELF_CLASS32 ||
+        ehdr->e_data != ELF_DATA2LSB || ehdr->e_type != ELF_ET_EXEC ||
+        ehdr->e_machine != ELF_EM_386 ||
+        ehdr->e_phentsize != sizeof(elf32_phdr_t) ||
+        ehdr->e_phnum == 0 || ehdr->e_phnum > ELF_MAX_PHDRS) {
+        return SYSCALL_ENOEXEC;
+    }
+    if (ehdr->e_entry < USER_BASE || ehdr->e_entry >= VDSO_USER_ADDR) {
+        return SYSCALL_ENOEXEC;
+    }
+    return 0;
+}
+
+// Turn the PT_LOAD segments into demand-paged regions
+static int elf_map_segments(file_t* file, const elf32_ehdr_t* ehdr) {
+    elf32_phdr_t phdrs[ELF_MAX_PHDRS];
+    uint32_t size = ehdr->e_phnum * sizeof(elf32_phdr_t);
+    if (file_pread(file, phdrs, size, ehdr->e_phoff) != (int)size) {
+        return SYSCALL_ENOEXEC;
+    }
+    
+    for (uint32_t i = 0; i < ehdr->e_phnum; i++) {
+        elf32_phdr_t* ph = &phdrs[i];
+        if (ph->p_type != ELF_PT_LOAD || ph->p_memsz == 0) {
+            continue;
+        }
+        
+        // Segments stay below the vDSO page and the stack
+        uint32_t limit = VDSO_USER_ADDR;
+        if (ph->p_filesz > ph->p_memsz || ph->p_vaddr < USER_BASE ||
+            ph->p_vaddr > limit || ph->p_memsz > limit - ph->p_vaddr) {
+            return SYSCALL_ENOEXEC;
+        }
+        
+        uint32_t prot = MEM_PROT_READ;
+        if (ph->p_flags & ELF_PF_W) {
+            prot |= MEM_PROT_WRITE;
+        }
+        if (ph->p_flags & ELF_PF_X) {
+            prot |= MEM_PROT_EXEC;
+        }
+        
+        int error = vm_map(ph->p_vaddr, ph->p_memsz, prot, file, ph->p_offset, ph->p_filesz);
+        if (error < 0) {
+            return error;
+        }
+    }
+    return 0;
+}
+
+// Copy argv to the top of the program stack; returns the user argv
+// pointer and the stack pointer to start with
+static int elf_push_args(char* const argv[], uint32_t* user_argv, uint32_t* sp) {
+    uint32_t pointers[EXEC_MAX_ARGS + 1];
+    uint32_t top = EXEC_STACK_TOP;
+    uint32_t argc = 0;
+    
+    while (argv && argv[argc] && argc < EXEC_MAX_ARGS) {
+        uint32_t len = strlen(argv[argc]) + 1;
+        top -= len;
+        if (copy_to_user((void*)top, argv[argc], len) < 0) {
+            return SYSCALL_EFAULT;
+        }
+        pointers[argc++] = top;
+    }
+    pointers[argc] = 0;
+    
+    top = (top - (argc + 1) * sizeof(uint32_t)) & ~0xF;
+    if (copy_to_user((void*)top, pointers, (argc + 1) * sizeof(uint32_t)) < 0) {
+        return SYSCALL_EFAULT;
+    }
+    
+    *user_argv = top;
+    *sp = top;
+    return 0;
+}
+
+int elf_exec(const char* path, char* const argv[]) {
+    if (!paging_enabled()) {
+        return SYSCALL_ENOSYS;
+    }
+    if (exec_active) {
+        return SYSCALL_EBUSY;  // One image in the user window at a time
+    }
+    
+    int error = 0;
+    file_t* file = file_open(path, O_RDONLY, &error);
+    if (!file) {
+        return error;
+    }
+    
+    elf32_ehdr_t ehdr;
+    if (file_pread(file, &ehdr, sizeof(ehdr), 0) != sizeof(ehdr)) {
+        error = SYSCALL_ENOEXEC;
+    } else {
+        error = elf_check_header(&ehdr);
+    }
+    if (error == 0) {
+        error = elf_map_segments(file, &ehdr);
+    }
+    if (error == 0) {
+        error = vm_map(EXEC_STACK_TOP - EXEC_STACK_SIZE, EXEC_STACK_SIZE,
+                       MEM_PROT_READ | MEM_PROT_WRITE, NULL, 0, 0);
+    }
+    
+    // The regions hold their own references
+    file_put(file);
+    
+    const char* name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    int pid = error == 0 ? process_create(name, NULL, PROCESS_PRIORITY_NORMAL) : -1;
+    if (error == 0 && pid < 0) {
+        error = SYSCALL_ENOMEM;
+    }
+    
+    uint32_t user_argv = 0;
+    uint32_t sp = 0;
+    if (error == 0) {
+        // The stack is in the user window whoever asked for the exec
+        uint32_t origin = uaccess_user_origin;
+        uaccess_user_origin = 1;
+        error = elf_push_args(argv, &user_argv, &sp);
+        uaccess_user_origin = origin;
+    }
+    if (error < 0) {
+        if (pid > 0) {
+            process_terminate(pid);
+        }
+        vm_unmap_all();
+        return error;
+    }
+    
+    // The program's system calls and descriptors belong to its process
+    process_t* caller = process_get_current();
+    process_set_current(process_get_by_pid(pid));
+    exec_pid = pid;
+    exec_active = 1;
+    
+    int status = user_mode_call((int (*)(void*))ehdr.e_entry, (void*)user_argv, (void*)sp);
+    
+    // An exit from inside a system call skipped its cleanup
+    exec_active = 0;
+    uaccess_user_origin = 0;
+    
+    process_set_current(caller);
+    process_t* proc = process_get_by_pid(pid);
+    if (proc) {
+        proc->exit_code = status;
+    }
+    process_terminate(pid);
+    vm_unmap_all();
+    return status;
+}
+
+void elf_exec_exit(int status) {
+    // Only the program itself enters system calls from CPL 3
+    if (exec_active && uaccess_user_origin) {
+        user_mode_abort(status);
+    }
+}
+
+int elf_exec_running(void) {
+    return exec_active;
+}
+
+void elf_exec_fault(struct regs* r) {
+    if (!exec_active || (r->cs & 3) != 3) {
+        return;
+    }
+    
+    terminal_printf("exec: pid %d killed by exception %d at eip 0x%x", exec_pid, r->int_no, r->eip);
+    if (r->int_no == 14) {
+        terminal_printf(" (address 0x%x)", cpu_read_cr2());
+    }
+    terminal_writestring("\n");
+    user_mode_abort(EXEC_STATUS_FAULT);
+}
@@ -0,0 +1,323 @@
+// src/file.c
+#include "file.h"
+#include "process.h"
+#include "syscall.h"
+#include "interrupts.h"
+#include "terminal.h"
+#include "hal_keyboard.h"
+#include "pollset.h"
+#include "string.h"
+#include <stddef.h>
+
+// Open-file objects
+static file_t file_table[FILE_MAX_OPEN];
+
+// Console read: block on IRQ1 key events until a line or count bytes
+static int console_read(file_t* file, void* buffer, uint32_t count) {
+    char* out = (char*)buffer;
+    uint32_t bytes_read = 0;
+    
+    while (bytes_read < count) {
+        key_event_t event;
+        hal_keyboard_wait_event(&event);
+        
+        char c = event.ascii;
+        if (c) {
+            out[bytes_read++] = c;
+            
+            // Echo to terminal
+            terminal_putchar(c);
+            
+            if (c == '\n') {
+                break;
+            }
+        }
+    }
+    
+    return bytes_read;
+}
+
+static int console_write(file_t* file, const void* buffer, uint32_t count) {
+    terminal_write((const char*)buffer, count);
+    return count;
+}
+
+static int node_read(file_t* file, void* buffer, uint32_t count) {
+    int n = fs_node_read(file->node, file->offset, buffer, count);
+    if (n < 0) {
+        return SYSCALL_EISDIR;
+    }
+    file->offset += n;
+    return n;
+}
+
+static int node_write(file_t* file, const void* buffer, uint32_t count) {
+    if (file->flags & O_APPEND) {
+        file->offset = file->node->size;
+    }
+    
+    int n = fs_node_write(file->node, file->offset, buffer, count);
+    if (n < 0) {
+        return SYSCALL_EINVAL;
+    }
+    file->offset += n;
+    return n;
+}
+
+// Readable while key events are queued
+static uint32_t console_poll(file_t* file, wait_queue_t** wq) {
+    *wq = hal_keyboard_wait_queue();
+    return POLL_OUT | (hal_keyboard_is_key_available() ? POLL_IN : 0);
+}
+
+static const file_ops_t console_ops = { console_read, console_write, NULL, console_poll };
+static const file_ops_t node_ops = { node_read, node_write, NULL };
+
+// Console file shared by every process; never freed
+static file_t console_file = { 1, FILE_TYPE_CONSOLE, O_RDWR, 0, NULL, NULL, &console_ops };
+
+file_t* file_console(void) {
+    return &console_file;
+}
+
+// Take a free slot from the open-file table
+static file_t* file_alloc(void) {
+    uint32_t flags = irq_save();
+    for (int i = 0; i < FILE_MAX_OPEN; i++) {
+        if (file_table[i].refcount == 0) {
+            file_table[i].refcount = 1;
+            irq_restore(flags);
+            return &file_table[i];
+        }
+    }
+    irq_restore(flags);
+    return NULL;
+}
+
+file_t* file_open(const char* path, uint32_t flags, int* error) {
+    fs_node_t* node = fs_lookup(path);
+    if (!node) {
+        if (!(flags & O_CREAT)) {
+            *error = SYSCALL_ENOENT;
+            return NULL;
+        }
+        if (fs_create(path, FS_TYPE_FILE) < 0 || !(node = fs_lookup(path))) {
+            *error = SYSCALL_EACCES;
+            return NULL;
+        }
+    }
+    
+    uint32_t mode = flags & O_ACCMODE;
+    if (node->type == FS_TYPE_DIRECTORY && mode != O_RDONLY) {
+        *error = SYSCALL_EISDIR;
+        return NULL;
+    }
+    
+    if ((flags & O_TRUNC) && mode != O_RDONLY) {
+        fs_node_truncate(node, 0);
+    }
+    
+    file_t* file = file_alloc();
+    if (!file) {
+        *error = SYSCALL_EMFILE;
+        return NULL;
+    }
+    
+    file->type = FILE_TYPE_NODE;
+    file->flags = flags;
+    file->offset = 0;
+    file->node = node;
+    file->private_data = NULL;
+    file->ops = &node_ops;
+    node->open_count++;
+    return file;
+}
+
+file_t* file_create(uint32_t type, uint32_t flags, const file_ops_t* ops, void* private_data) {
+    file_t* file = file_alloc();
+    if (!file) {
+        return NULL;
+    }
+    
+    file->type = type;
+    file->flags = flags;
+    file->offset = 0;
+    file->node = NULL;
+    file->private_data = private_data;
+    file->ops = ops;
+    return file;
+}
+
+void file_get(file_t* file) {
+    uint32_t flags = irq_save();
+    file->refcount++;
+    irq_restore(flags);
+}
+
+void file_put(file_t* file) {
+    uint32_t flags = irq_save();
+    uint32_t left = --file->refcount;
+    irq_restore(flags);
+    
+    // The console holds a reference to itself and is never freed
+    if (left > 0) {
+        return;
+    }
+    
+    if (file->ops->release) {
+        file->ops->release(file);
+    }
+    if (file->node) {
+        file->node->open_count--;
+        file->node = NULL;
+    }
+    file->private_data = NULL;
+}
+
+int file_read(file_t* file, void* buffer, uint32_t count) {
+    if ((file->flags & O_ACCMODE) == O_WRONLY) {
+        return SYSCALL_EACCES;
+    }
+    if (!file->ops->read) {
+        return SYSCALL_EINVAL;
+    }
+    return file->ops->read(file, buffer, count);
+}
+
+int file_write(file_t* file, const void* buffer, uint32_t count) {
+    if ((file->flags & O_ACCMODE) == O_RDONLY) {
+        return SYSCALL_EACCES;
+    }
+    if (!file->ops->write) {
+        return SYSCALL_EINVAL;
+    }
+    return file->ops->write(file, buffer, count);
+}
+
+int file_pread(file_t* file, void* buffer, uint32_t count, uint32_t offset) {
+    if (file->type != FILE_TYPE_NODE) {
+        return file_read(file, buffer, count);
+    }
+    if ((file->flags & O_ACCMODE) == O_WRONLY) {
+        return SYSCALL_EACCES;
+    }
+    
+    int n = fs_node_read(file->node, offset, buffer, count);
+    return n < 0 ? SYSCALL_EISDIR : n;
+}
+
+int file_pwrite(file_t* file, const void* buffer, uint32_t count, uint32_t offset) {
+    if (file->type != FILE_TYPE_NODE) {
+        return file_write(file, buffer, count);
+    }
+    if ((file->flags & O_ACCMODE) == O_RDONLY) {
+        return SYSCALL_EACCES;
+    }
+    
+    int n = fs_node_write(file->node, offset, buffer, count);
+    return n < 0 ? SYSCALL_EINVAL : n;
+}
+
+uint32_t file_poll(file_t* file, wait_queue_t** wq) {
+    *wq = NULL;
+    if (!file->ops->poll) {
+        return POLL_IN | POLL_OUT;
+    }
+    return file->ops->poll(file, wq);
+}
+
+int file_seek(file_t* file, int offset, int whence) {
+    if (file->type != FILE_TYPE_NODE) {
+        return SYSCALL_EINVAL;
+    }
+    
+    int base;
+    switch (whence) {
+        case SEEK_SET:
+            base = 0;
+            break;
+        case SEEK_CUR:
+            base = file->offset;
+            break;
+        case SEEK_END:
+            base = file->node->size;
+            break;
+        default:
+            return SYSCALL_EINVAL;
+    }
+    
+    int position = base + offset;
+    if (position < 0) {
+        return SYSCALL_EINVAL;
+    }
+    
+    file->offset = position;
+    return position;
+}
+
+// Descriptor table of the running process; NULL before processes exist
+static file_t** fd_table(void) {
+    process_t* current = process_get_current();
+    return current ? current->fds : NULL;
+}
+
+int fd_install(file_t* file) {
+    file_t** fds = fd_table();
+    if (!fds) {
+        return SYSCALL_EMFILE;
+    }
+    
+    for (int fd = 0; fd < PROCESS_MAX_FDS; fd++) {
+        if (!fds[fd]) {
+            fds[fd] = file;
+            return fd;
+        }
+    }
+    return SYSCALL_EMFILE;
+}
+
+file_t* fd_get(int fd) {
+    if (fd < 0 || fd >= PROCESS_MAX_FDS) {
+        return NULL;
+    }
+    
+    file_t** fds = fd_table();
+    if (!fds) {
+        // Early boot: only the console exists
+        return fd <= 2 ? &console_file : NULL;
+    }
+    return fds[fd];
+}
+
+int fd_close(int fd) {
+    file_t** fds = fd_table();
+    if (!fds || fd < 0 || fd >= PROCESS_MAX_FDS || !fds[fd]) {
+        return SYSCALL_EINVAL;
+    }
+    
+    file_t* file = fds[fd];
+    fds[fd] = NULL;
+    file_put(file);
+    return 0;
+}
+
+void fd_table_init(file_t** fds) {
+    for (int fd = 0; fd < PROCESS_MAX_FDS; fd++) {
+        fds[fd] = NULL;
+    }
+    
+    for (int fd = 0; fd <= 2; fd++) {
+        file_get(&console_file);
+        fds[fd] = &console_file;
+    }
+}
+
+void fd_table_close_all(file_t** fds) {
+    for (int fd = 0; fd < PROCESS_MAX_FDS; fd++) {
+        if (fds[fd]) {
+            file_t* file = fds[fd];
+            fds[fd] = NULL;
+            file_put(file);
+        }
+    }
+}
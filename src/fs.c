@@ -1,7 +1,10 @@
 // src/fs.c
 #include "fs.h"
+#include "bcache.h"
+#include "dcache.h"
 #include "hal.h"
 #include "kmalloc.h"
+#include "memory.h"
 #include "terminal.h"
 #include "stdio.h"
 #include "string.h"
@@ -9,32 +12,16 @@
 // File system node array
 fs_node_t fs_nodes[FS_MAX_FILES];
 
-// Current working directory
-static char current_directory[FS_MAX_PATH] = "/";
-
-// File system buffer cache
-#define FS_CACHE_SIZE 32      // Number of cache blocks
-#define FS_CACHE_BLOCK_SIZE 512 // Size of each cache block (same as sector size)
+// Extent array size for a file's first page
+#define FS_EXTENTS_INITIAL 4
 
-// Cache block states
-#define CACHE_STATE_EMPTY     0
-#define CACHE_STATE_CLEAN     1
-#define CACHE_STATE_DIRTY     2
-
-// Cache block
-typedef struct {
-    uint32_t sector;          // Disk sector this block represents
-    uint8_t state;            // Block state (empty, clean, dirty)
-    uint32_t last_access;     // Timestamp of last access
-    uint32_t access_count;    // Number of times this block was accessed
-    uint8_t data[FS_CACHE_BLOCK_SIZE]; // Data buffer
-} cache_block_t;
+// Current working directory, and its node for relative lookups (-1
+// once the directory was deleted)
+static char current_directory[FS_MAX_PATH] = "/";
+static int current_index = 0;
 
 // File system statistics
 static struct {
-    uint32_t cache_hits;      // Number of cache hits
-    uint32_t cache_misses;    // Number of cache misses
-    uint32_t cache_flushes;   // Number of cache flushes
     uint32_t file_opens;      // Number of file opens
     uint32_t file_closes;     // Number of file closes
     uint32_t file_reads;      // Number of file reads
@@ -42,14 +29,6 @@ static struct {
     uint32_t dir_operations;  // Number of directory operations
 } fs_stats;
 
-// File system cache
-static cache_block_t fs_cache[FS_CACHE_SIZE];
-static uint32_t fs_cache_timer = 0;  // Simple timer for LRU
-
-// Forward declarations
-static int fs_flush_cache_block(int block_index);
-static int fs_flush_all_cache(void);
-
 // Initialize file system
 int fs_init(void) {
     // Clear all nodes
@@ -63,19 +42,17 @@ int fs_init(void) {
     strcpy(fs_nodes[0].name, "/");
     strcpy(fs_nodes[0].path, "/");
     fs_nodes[0].parent_index = -1;
-    
-    // Initialize cache
-    for (int i = 0; i < FS_CACHE_SIZE; i++) {
-        fs_cache[i].sector = 0;
-        fs_cache[i].state = CACHE_STATE_EMPTY;
-        fs_cache[i].last_access = 0;
-        fs_cache[i].access_count = 0;
+    fs_nodes[0].open_count = 0;
+    strcpy(current_directory, "/");
+    current_index = 0;
+    dcache_init();
+    
+    // Initialize the buffer cache, sized from free memory
+    if (bcache_init(BCACHE_DEFAULT_BLOCK_SIZE, 0) != 0) {
+        terminal_writestring("Buffer cache allocation failed\n");
     }
     
     // Initialize statistics
-    fs_stats.cache_hits = 0;
-    fs_stats.cache_misses = 0;
-    fs_stats.cache_flushes = 0;
     fs_stats.file_opens = 0;
     fs_stats.file_closes = 0;
     fs_stats.file_reads = 0;
@@ -91,251 +68,540 @@ const char* fs_getcwd(void) {
     return current_directory;
 }
 
-// List files in a directory
-void fs_list(const char* path) {
-    terminal_writestring("Directory listing (stub):\n");
-    terminal_writestring("  .  (directory)\n");
-    terminal_writestring("  .. (directory)\n");
+// Build the absolute form of a path relative to the current directory
+static int fs_absolute_path(const char* path, char* out) {
+    if (!path || !path[0]) {
+        strcpy(out, current_directory);
+        return 0;
+    }
+    
+    if (path[0] == '/') {
+        if (strlen(path) >= FS_MAX_PATH) {
+            return -1;
+        }
+        strcpy(out, path);
+    } else {
+        size_t cwd_len = strlen(current_directory);
+        int need_slash = current_directory[cwd_len - 1] != '/';
+        if (cwd_len + need_slash + strlen(path) >= FS_MAX_PATH) {
+            return -1;
+        }
+        strcpy(out, current_directory);
+        if (need_slash) {
+            strcat(out, "/");
+        }
+        strcat(out, path);
+    }
+    
+    // Drop a trailing slash except on the root
+    size_t len = strlen(out);
+    if (len > 1 && out[len - 1] == '/') {
+        out[len - 1] = '\0';
+    }
+    return 0;
 }
 
-// Create a file
-int fs_create(const char* path, int type) {
-    // Simple stub - in a real FS, this would create a file
-    fs_stats.file_opens++;
-    return 0;  // Success
+// Child of a directory by name, through the dentry cache; -1 if none
+static int fs_lookup_child(int parent, const char* name) {
+    int index;
+    if (dcache_lookup(parent, name, &index)) {
+        return index;
+    }
+    
+    index = DCACHE_NEGATIVE;
+    for (int i = 0; i < FS_MAX_FILES; i++) {
+        if (fs_nodes[i].in_use && fs_nodes[i].parent_index == parent &&
+            strcmp(fs_nodes[i].name, name) == 0) {
+            index = i;
+            break;
+        }
+    }
+    dcache_insert(parent, name, index);
+    return index;
 }
 
-// Read from a file
-int fs_read(const char* path, char* buffer, size_t size) {
-    // Simple stub - in a real FS, this would read file data
-    fs_stats.file_reads++;
-    strcpy(buffer, "File contents (stub)");
-    return strlen(buffer);
+// Resolve a path to its node, one component at a time from the root or
+// from the current directory
+fs_node_t* fs_lookup(const char* path) {
+    int index = (path && path[0] == '/') ? 0 : current_index;
+    if (index < 0 || (path && strlen(path) >= FS_MAX_PATH)) {
+        return NULL;
+    }
+    
+    const char* p = path ? path : "";
+    for (;;) {
+        while (*p == '/') {
+            p++;
+        }
+        if (!*p) {
+            return &fs_nodes[index];
+        }
+        
+        const char* end = p;
+        while (*end && *end != '/') {
+            end++;
+        }
+        size_t len = end - p;
+        if (len >= FS_MAX_FILENAME || fs_nodes[index].type != FS_TYPE_DIRECTORY) {
+            return NULL;
+        }
+        
+        // "." stays put and ".." climbs, but never above the root
+        if (len == 1 && p[0] == '.') {
+            p = end;
+            continue;
+        }
+        if (len == 2 && p[0] == '.' && p[1] == '.') {
+            if (fs_nodes[index].parent_index >= 0) {
+                index = fs_nodes[index].parent_index;
+            }
+            p = end;
+            continue;
+        }
+        
+        char name[FS_MAX_FILENAME];
+        memcpy(name, p, len);
+        name[len] = '\0';
+        index = fs_lookup_child(index, name);
+        if (index < 0) {
+            return NULL;
+        }
+        p = end;
+    }
 }
 
-// Write to a file
-int fs_write(const char* path, const char* data, size_t size) {
-    // Simple stub - in a real FS, this would write data to file
-    fs_stats.file_writes++;
-    return size;  // Success, wrote all bytes
+// List files in a directory
+void fs_list(const char* path) {
+    fs_node_t* dir = fs_lookup(path);
+    if (!dir || dir->type != FS_TYPE_DIRECTORY) {
+        terminal_writestring("Directory not found\n");
+        return;
+    }
+    
+    int dir_index = dir - fs_nodes;
+    for (int i = 0; i < FS_MAX_FILES; i++) {
+        if (fs_nodes[i].in_use && fs_nodes[i].parent_index == dir_index) {
+            if (fs_nodes[i].type == FS_TYPE_DIRECTORY) {
+                terminal_printf("  %s/\n", fs_nodes[i].name);
+            } else {
+                terminal_printf("  %s (%d bytes)\n", fs_nodes[i].name, fs_nodes[i].size);
+            }
+        }
+    }
 }
 
-// Delete a file
-int fs_delete(const char* path) {
-    // Simple stub - in a real FS, this would delete a file
-    fs_stats.file_closes++;
-    return 0;  // Success
+// Create a file
+int fs_create(const char* path, int type) {
+    char full_path[FS_MAX_PATH];
+    if (fs_absolute_path(path, full_path) < 0 || fs_lookup(full_path)) {
+        return -1;
+    }
+    
+    // Split into parent directory and name
+    char* slash = strrchr(full_path, '/');
+    const char* name = slash + 1;
+    if (!*name || strlen(name) >= FS_MAX_FILENAME) {
+        return -1;
+    }
+    
+    fs_node_t* parent;
+    if (slash == full_path) {
+        parent = &fs_nodes[0];
+    } else {
+        *slash = '\0';
+        parent = fs_lookup(full_path);
+        *slash = '/';
+    }
+    if (!parent || parent->type != FS_TYPE_DIRECTORY) {
+        return -1;
+    }
+    
+    for (int i = 1; i < FS_MAX_FILES; i++) {
+        if (!fs_nodes[i].in_use) {
+            fs_node_t* node = &fs_nodes[i];
+            strcpy(node->name, name);
+            strcpy(node->path, full_path);
+            node->type = type;
+            node->extents = NULL;
+            node->extent_count = 0;
+            node->extent_capacity = 0;
+            node->pages = 0;
+            node->size = 0;
+            node->parent_index = parent - fs_nodes;
+            node->permissions = 0644;
+            node->created_time = hal_timer_get_ticks();
+            node->modified_time = node->created_time;
+            node->open_count = 0;
+            node->in_use = 1;
+            dcache_insert(node->parent_index, name, i);
+            if (current_index < 0 && strcmp(full_path, current_directory) == 0) {
+                current_index = i;  // The deleted current directory is back
+            }
+            fs_stats.file_opens++;
+            return 0;
+        }
+    }
+    
+    return -1;  // Node table full
 }
 
-// Get file size
-int fs_size(const char* path) {
-    // Simple stub - in a real FS, this would return actual size
-    return 100;  // Return dummy size
-}
+// File pages are kept in extents: runs of consecutive file pages backed
+// by consecutive frames. Pages nobody wrote are holes and cost nothing.
+// Bytes past the end of the file inside an allocated page are always
+// zero, so growing a file never exposes stale data.
 
-// Create a directory
-int fs_mkdir(const char* path) {
-    // Simple stub - in a real FS, this would create a directory
-    fs_stats.dir_operations++;
-    return 0;  // Success
+// Index of the extent holding page, or of the first extent after it
+static uint32_t fs_extent_search(fs_node_t* node, uint32_t page) {
+    uint32_t lo = 0;
+    uint32_t hi = node->extent_count;
+    
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        fs_extent_t* extent = &node->extents[mid];
+        if (page < extent->page) {
+            hi = mid;
+        } else if (page >= extent->page + extent->count) {
+            lo = mid + 1;
+        } else {
+            return mid;
+        }
+    }
+    return lo;
 }
 
-// Change current directory
-int fs_chdir(const char* path) {
-    // Simple stub - in a real FS, this would change directory
-    strcpy(current_directory, path);
-    return 0;  // Success
+// Frame behind a file page; 0 for a hole
+static uint32_t fs_page_frame(fs_node_t* node, uint32_t page) {
+    uint32_t i = fs_extent_search(node, page);
+    if (i == node->extent_count || page < node->extents[i].page) {
+        return 0;
+    }
+    return node->extents[i].frame + (page - node->extents[i].page) * FS_PAGE_SIZE;
 }
 
-// Get file information by index
-int fs_stat_by_index(int index, fs_node_t* info) {
-    if (index < 0 || index >= FS_MAX_FILES) {
-        return -1;
+// Make room for one more extent
+static int fs_extent_reserve(fs_node_t* node) {
+    if (node->extent_count < node->extent_capacity) {
+        return 0;
     }
     
-    *info = fs_nodes[index];
-    return 0;
-}
-
-// Update file node
-int fs_update_node(int index, fs_node_t* info) {
-    if (index < 0 || index >= FS_MAX_FILES) {
+    uint32_t capacity = node->extent_capacity ? node->extent_capacity * 2 : FS_EXTENTS_INITIAL;
+    fs_extent_t* extents = kmalloc(capacity * sizeof(fs_extent_t));
+    if (!extents) {
         return -1;
     }
-    
-    fs_nodes[index] = *info;
+    if (node->extents) {
+        memcpy(extents, node->extents, node->extent_count * sizeof(fs_extent_t));
+        kfree(node->extents);
+    }
+    node->extents = extents;
+    node->extent_capacity = capacity;
     return 0;
 }
 
-// Get file information
-int fs_stat(const char* path, fs_node_t* info) {
-    // Simple stub - find the node with matching path
-    for (int i = 0; i < FS_MAX_FILES; i++) {
-        if (fs_nodes[i].in_use && strcmp(fs_nodes[i].path, path) == 0) {
-            *info = fs_nodes[i];
-            return 0;
-        }
+// Fold extent i + 1 into extent i if they now form one run
+static void fs_extent_merge(fs_node_t* node, uint32_t i) {
+    if (i + 1 >= node->extent_count) {
+        return;
     }
     
-    return -1; // Not found
+    fs_extent_t* cur = &node->extents[i];
+    fs_extent_t* next = &node->extents[i + 1];
+    if (cur->page + cur->count == next->page &&
+        cur->frame + cur->count * FS_PAGE_SIZE == next->frame) {
+        cur->count += next->count;
+        memmove(next, next + 1, (node->extent_count - i - 2) * sizeof(fs_extent_t));
+        node->extent_count--;
+    }
 }
 
-// Find a cache block for the given sector
-static int fs_find_cache_block(uint32_t sector) {
-    for (int i = 0; i < FS_CACHE_SIZE; i++) {
-        if (fs_cache[i].state != CACHE_STATE_EMPTY && fs_cache[i].sector == sector) {
-            return i;
+// Back a hole with a zeroed frame; returns the frame, or 0 when out of
+// memory
+static uint32_t fs_page_alloc(fs_node_t* node, uint32_t page) {
+    // Reserve first so a full array never strands a frame
+    if (fs_extent_reserve(node) < 0) {
+        return 0;
+    }
+    uint32_t frame = page_frame_alloc();
+    if (!frame) {
+        return 0;
+    }
+    memset((void*)frame, 0, FS_PAGE_SIZE);
+    node->pages++;
+    
+    // Extend a neighbouring run when the frame lines up with it
+    uint32_t i = fs_extent_search(node, page);
+    if (i > 0) {
+        fs_extent_t* prev = &node->extents[i - 1];
+        if (prev->page + prev->count == page &&
+            prev->frame + prev->count * FS_PAGE_SIZE == frame) {
+            prev->count++;
+            fs_extent_merge(node, i - 1);
+            return frame;
+        }
+    }
+    if (i < node->extent_count) {
+        fs_extent_t* next = &node->extents[i];
+        if (next->page == page + 1 && next->frame == frame + FS_PAGE_SIZE) {
+            next->page--;
+            next->frame = frame;
+            next->count++;
+            return frame;
         }
     }
-    return -1;  // Not found
+    
+    memmove(&node->extents[i + 1], &node->extents[i],
+            (node->extent_count - i) * sizeof(fs_extent_t));
+    node->extents[i].page = page;
+    node->extents[i].count = 1;
+    node->extents[i].frame = frame;
+    node->extent_count++;
+    return frame;
 }
 
-// Find the least recently used cache block
-static int fs_find_lru_cache_block(void) {
-    int lru_index = 0;
-    uint32_t lru_time = fs_cache[0].last_access;
-    
-    for (int i = 1; i < FS_CACHE_SIZE; i++) {
-        if (fs_cache[i].state == CACHE_STATE_EMPTY) {
-            return i;  // Empty block has highest priority
+// Give back every page from file page first on
+static void fs_free_pages_from(fs_node_t* node, uint32_t first) {
+    uint32_t keep = 0;
+    
+    for (uint32_t i = 0; i < node->extent_count; i++) {
+        fs_extent_t* extent = &node->extents[i];
+        if (extent->page + extent->count <= first) {
+            keep = i + 1;
+            continue;
         }
         
-        if (fs_cache[i].last_access < lru_time) {
-            lru_index = i;
-            lru_time = fs_cache[i].last_access;
+        uint32_t start = extent->page < first ? first - extent->page : 0;
+        for (uint32_t p = start; p < extent->count; p++) {
+            page_frame_free(extent->frame + p * FS_PAGE_SIZE);
+            node->pages--;
+        }
+        if (start > 0) {
+            extent->count = start;
+            keep = i + 1;
         }
     }
     
-    return lru_index;
+    node->extent_count = keep;
+    if (keep == 0 && node->extents) {
+        kfree(node->extents);
+        node->extents = NULL;
+        node->extent_capacity = 0;
+    }
 }
 
-// Flush a cache block to disk
-static int fs_flush_cache_block(int block_index) {
-    if (block_index < 0 || block_index >= FS_CACHE_SIZE) {
+// Read from a node at an offset; returns bytes read
+int fs_node_read(fs_node_t* node, uint32_t offset, void* buffer, size_t size) {
+    if (!node->in_use || node->type != FS_TYPE_FILE) {
         return -1;
     }
     
-    cache_block_t* block = &fs_cache[block_index];
+    if (offset >= node->size) {
+        return 0;
+    }
+    if (size > node->size - offset) {
+        size = node->size - offset;
+    }
     
-    // Only flush dirty blocks
-    if (block->state == CACHE_STATE_DIRTY) {
-        // Write to disk
-        if (hal_storage_write_sector(block->sector, block->data) != 0) {
-            return -1;
+    uint8_t* out = (uint8_t*)buffer;
+    size_t done = 0;
+    while (done < size) {
+        uint32_t pos = offset + done;
+        uint32_t in_page = pos % FS_PAGE_SIZE;
+        size_t chunk = FS_PAGE_SIZE - in_page;
+        if (chunk > size - done) {
+            chunk = size - done;
         }
         
-        // Mark as clean
-        block->state = CACHE_STATE_CLEAN;
-        fs_stats.cache_flushes++;
+        uint32_t frame = fs_page_frame(node, pos / FS_PAGE_SIZE);
+        if (frame) {
+            memcpy(out + done, (const void*)(frame + in_page), chunk);
+        } else {
+            memset(out + done, 0, chunk);
+        }
+        done += chunk;
     }
     
-    return 0;
+    fs_stats.file_reads++;
+    return size;
 }
 
-// Flush all dirty cache blocks
-static int fs_flush_all_cache(void) {
-    int result = 0;
+// Write to a node at an offset; a gap past the old end is left as a hole
+int fs_node_write(fs_node_t* node, uint32_t offset, const void* data, size_t size) {
+    if (!node->in_use || node->type != FS_TYPE_FILE || offset > FS_MAX_FILESIZE) {
+        return -1;
+    }
+    
+    if (size > FS_MAX_FILESIZE - offset) {
+        size = FS_MAX_FILESIZE - offset;
+    }
     
-    for (int i = 0; i < FS_CACHE_SIZE; i++) {
-        if (fs_cache[i].state == CACHE_STATE_DIRTY) {
-            if (fs_flush_cache_block(i) != 0) {
-                result = -1;  // But continue flushing other blocks
+    const uint8_t* in = (const uint8_t*)data;
+    size_t done = 0;
+    while (done < size) {
+        uint32_t pos = offset + done;
+        uint32_t page = pos / FS_PAGE_SIZE;
+        uint32_t in_page = pos % FS_PAGE_SIZE;
+        size_t chunk = FS_PAGE_SIZE - in_page;
+        if (chunk > size - done) {
+            chunk = size - done;
+        }
+        
+        uint32_t frame = fs_page_frame(node, page);
+        if (!frame) {
+            frame = fs_page_alloc(node, page);
+            if (!frame) {
+                break;  // Out of memory: keep what fit
             }
         }
+        memcpy((void*)(frame + in_page), in + done, chunk);
+        done += chunk;
+    }
+    
+    if (done == 0 && size > 0) {
+        return -1;
+    }
+    if (done > 0 && offset + done > node->size) {
+        node->size = offset + done;
     }
     
-    return result;
+    node->modified_time = hal_timer_get_ticks();
+    fs_stats.file_writes++;
+    return done;
 }
 
-// Read a sector through cache
-static int fs_cached_read_sector(uint32_t sector, void* buffer) {
-    // Increment cache timer
-    fs_cache_timer++;
-    
-    // Check if sector is in cache
-    int block_index = fs_find_cache_block(sector);
+// Set a node's size; growing leaves a hole, shrinking frees whole pages
+int fs_node_truncate(fs_node_t* node, size_t size) {
+    if (!node->in_use || node->type != FS_TYPE_FILE || size > FS_MAX_FILESIZE) {
+        return -1;
+    }
     
-    if (block_index >= 0) {
-        // Cache hit
-        fs_stats.cache_hits++;
-        
-        // Update access time and count
-        fs_cache[block_index].last_access = fs_cache_timer;
-        fs_cache[block_index].access_count++;
+    if (size < node->size) {
+        fs_free_pages_from(node, (size + FS_PAGE_SIZE - 1) / FS_PAGE_SIZE);
         
-        // Copy data to buffer
-        memcpy(buffer, fs_cache[block_index].data, FS_CACHE_BLOCK_SIZE);
-        
-        return 0;
+        // Keep the tail of a partial last page zero for later growth
+        uint32_t in_page = size % FS_PAGE_SIZE;
+        uint32_t frame = in_page ? fs_page_frame(node, size / FS_PAGE_SIZE) : 0;
+        if (frame) {
+            memset((void*)(frame + in_page), 0, FS_PAGE_SIZE - in_page);
+        }
     }
-    
-    // Cache miss
-    fs_stats.cache_misses++;
-    
-    // Find a cache block to use
-    block_index = fs_find_lru_cache_block();
-    
-    // Flush block if dirty
-    if (fs_cache[block_index].state == CACHE_STATE_DIRTY) {
-        fs_flush_cache_block(block_index);
+    node->size = size;
+    node->modified_time = hal_timer_get_ticks();
+    return 0;
+}
+
+// Read from a file
+int fs_read(const char* path, char* buffer, size_t size) {
+    fs_node_t* node = fs_lookup(path);
+    if (!node) {
+        return -1;
+    }
+    return fs_node_read(node, 0, buffer, size);
+}
+
+// Write to a file, replacing its contents
+int fs_write(const char* path, const char* data, size_t size) {
+    fs_node_t* node = fs_lookup(path);
+    if (!node) {
+        if (fs_create(path, FS_TYPE_FILE) < 0) {
+            return -1;
+        }
+        node = fs_lookup(path);
     }
     
-    // Read sector from disk
-    if (hal_storage_read_sector(sector, fs_cache[block_index].data) != 0) {
+    if (fs_node_truncate(node, 0) < 0) {
+        return -1;
+    }
+    return fs_node_write(node, 0, data, size);
+}
+
+// Delete a file or an empty directory
+int fs_delete(const char* path) {
+    fs_node_t* node = fs_lookup(path);
+    if (!node || node == &fs_nodes[0] || node->open_count > 0) {
         return -1;
     }
     
-    // Update cache block
-    fs_cache[block_index].sector = sector;
-    fs_cache[block_index].state = CACHE_STATE_CLEAN;
-    fs_cache[block_index].last_access = fs_cache_timer;
-    fs_cache[block_index].access_count = 1;
-    
-    // Copy data to buffer
-    memcpy(buffer, fs_cache[block_index].data, FS_CACHE_BLOCK_SIZE);
+    if (node->type == FS_TYPE_DIRECTORY) {
+        int index = node - fs_nodes;
+        for (int i = 0; i < FS_MAX_FILES; i++) {
+            if (fs_nodes[i].in_use && fs_nodes[i].parent_index == index) {
+                return -1;
+            }
+        }
+    }
     
+    fs_free_pages_from(node, 0);
+    node->in_use = 0;
+    dcache_insert(node->parent_index, node->name, DCACHE_NEGATIVE);
+    if (node - fs_nodes == current_index) {
+        current_index = -1;
+    }
+    fs_stats.file_closes++;
     return 0;
 }
 
-// Write a sector through cache
-static int fs_cached_write_sector(uint32_t sector, const void* buffer) {
-    // Increment cache timer
-    fs_cache_timer++;
+// Get file size
+int fs_size(const char* path) {
+    fs_node_t* node = fs_lookup(path);
+    if (!node || node->type != FS_TYPE_FILE) {
+        return -1;
+    }
+    return node->size;
+}
+
+// Create a directory
+int fs_mkdir(const char* path) {
+    fs_stats.dir_operations++;
+    return fs_create(path, FS_TYPE_DIRECTORY);
+}
+
+// Change current directory
+int fs_chdir(const char* path) {
+    fs_node_t* node = fs_lookup(path);
+    if (!node || node->type != FS_TYPE_DIRECTORY) {
+        return -1;
+    }
     
-    // Check if sector is in cache
-    int block_index = fs_find_cache_block(sector);
+    strcpy(current_directory, node->path);
+    current_index = node - fs_nodes;
+    return 0;
+}
+
+// Get file information by index
+int fs_stat_by_index(int index, fs_node_t* info) {
+    if (index < 0 || index >= FS_MAX_FILES) {
+        return -1;
+    }
     
-    if (block_index >= 0) {
-        // Cache hit
-        fs_stats.cache_hits++;
-    } else {
-        // Cache miss
-        fs_stats.cache_misses++;
-        
-        // Find a cache block to use
-        block_index = fs_find_lru_cache_block();
-        
-        // Flush block if dirty
-        if (fs_cache[block_index].state == CACHE_STATE_DIRTY) {
-            fs_flush_cache_block(block_index);
-        }
-        
-        // If replacing a valid block, update it
-        fs_cache[block_index].sector = sector;
+    *info = fs_nodes[index];
+    return 0;
+}
+
+// Update file node
+int fs_update_node(int index, fs_node_t* info) {
+    if (index < 0 || index >= FS_MAX_FILES) {
+        return -1;
     }
     
-    // Update cache block
-    memcpy(fs_cache[block_index].data, buffer, FS_CACHE_BLOCK_SIZE);
-    fs_cache[block_index].state = CACHE_STATE_DIRTY;
-    fs_cache[block_index].last_access = fs_cache_timer;
-    fs_cache[block_index].access_count++;
+    fs_nodes[index] = *info;
+    dcache_flush();  // Names or parents may have changed
+    return 0;
+}
+
+// Get file information
+int fs_stat(const char* path, fs_node_t* info) {
+    fs_node_t* node = fs_lookup(path);
+    if (!node) {
+        return -1; // Not found
+    }
     
+    *info = *node;
     return 0;
 }
 
 // Synchronize cache with disk (flush all dirty blocks)
 int fs_sync(void) {
-    return fs_flush_all_cache();
+    return bcache_sync();
 }
 
 // Display file system cache information
@@ -344,29 +610,38 @@ void fs_display_cache_info(void) {
     terminal_writestring("----------------------------\n");
     
     // Display cache statistics
+    bcache_stats_t cstats;
+    bcache_get_stats(&cstats);
     terminal_printf("Cache size: %d blocks of %d bytes\n", 
-                  FS_CACHE_SIZE, FS_CACHE_BLOCK_SIZE);
+                  cstats.capacity, cstats.block_size);
+    terminal_printf("Replacement policy: %s, %d metadata blocks\n",
+                  bcache_policy_name(cstats.policy), cstats.meta);
     terminal_printf("Cache hits: %d, misses: %d (%.1f%% hit rate)\n", 
-                  fs_stats.cache_hits, fs_stats.cache_misses,
-                  (fs_stats.cache_hits + fs_stats.cache_misses > 0) ?
-                  (float)fs_stats.cache_hits * 100.0f / (fs_stats.cache_hits + fs_stats.cache_misses) : 0.0f);
-    terminal_printf("Cache flushes: %d\n", fs_stats.cache_flushes);
-    
-    // Count cache blocks by state
-    int empty_blocks = 0;
-    int clean_blocks = 0;
-    int dirty_blocks = 0;
-    
-    for (int i = 0; i < FS_CACHE_SIZE; i++) {
-        switch (fs_cache[i].state) {
-            case CACHE_STATE_EMPTY: empty_blocks++; break;
-            case CACHE_STATE_CLEAN: clean_blocks++; break;
-            case CACHE_STATE_DIRTY: dirty_blocks++; break;
+                  cstats.hits, cstats.misses,
+                  (cstats.hits + cstats.misses > 0) ?
+                  (float)cstats.hits * 100.0f / (cstats.hits + cstats.misses) : 0.0f);
+    terminal_printf("Cache flushes: %d, evictions: %d\n", cstats.flushes, cstats.evictions);
+    terminal_printf("Device requests: %d reads, %d writes\n", cstats.dev_reads, cstats.dev_writes);
+    terminal_printf("Write-back: %d passes, %d blocks in %d requests, %d throttled writes\n",
+                  cstats.wb_runs, cstats.wb_blocks, cstats.wb_requests, cstats.throttled);
+    terminal_printf("Last write-back: %d blocks in %d requests, %d us\n",
+                  cstats.wb_last_blocks, cstats.wb_last_requests, cstats.wb_last_us);
+    terminal_printf("Read-ahead: %d blocks in %d requests, %d used, %d wasted\n",
+                  cstats.ra_blocks, cstats.ra_requests, cstats.ra_hits, cstats.ra_waste);
+    terminal_printf("Cache blocks: %d empty, %d clean, %d dirty\n",
+                  cstats.capacity - cstats.clean - cstats.dirty, cstats.clean, cstats.dirty);
+    
+    // File data, and how much of it sparse files did not need
+    uint32_t data_pages = 0;
+    uint32_t data_bytes = 0;
+    for (int i = 0; i < FS_MAX_FILES; i++) {
+        if (fs_nodes[i].in_use && fs_nodes[i].type == FS_TYPE_FILE) {
+            data_pages += fs_nodes[i].pages;
+            data_bytes += fs_nodes[i].size;
         }
     }
-    
-    terminal_printf("Cache blocks: %d empty, %d clean, %d dirty\n",
-                  empty_blocks, clean_blocks, dirty_blocks);
+    terminal_printf("File data: %d bytes in %d pages (%d KB)\n",
+                  data_bytes, data_pages, data_pages * (FS_PAGE_SIZE / 1024));
     
     // Display file operation statistics
     terminal_printf("File operations: %d opens, %d closes, %d reads, %d writes\n",
@@ -374,41 +649,26 @@ void fs_display_cache_info(void) {
                   fs_stats.file_reads, fs_stats.file_writes);
     terminal_printf("Directory operations: %d\n", fs_stats.dir_operations);
     
+    dcache_stats_t dstats;
+    dcache_get_stats(&dstats);
+    terminal_printf("Dentry cache: %d/%d entries, %d hits (%d negative), %d misses, %d evictions\n",
+                  dstats.entries, DCACHE_ENTRIES, dstats.hits, dstats.negative_hits,
+                  dstats.misses, dstats.evictions);
+    
     // Display most active cache blocks
     terminal_writestring("\nMost Active Cache Blocks:\n");
-    terminal_writestring("Block  Sector   State   Accesses\n");
+    terminal_writestring("  Dev   Sector    State Accesses\n");
     terminal_writestring("----- -------- -------- --------\n");
     
     // Find top 5 most accessed blocks
-    for (int top = 0; top < 5; top++) {
-        int max_index = -1;
-        uint32_t max_count = 0;
-        
-        for (int i = 0; i < FS_CACHE_SIZE; i++) {
-            if (fs_cache[i].state != CACHE_STATE_EMPTY && 
-                fs_cache[i].access_count > max_count) {
-                max_index = i;
-                max_count = fs_cache[i].access_count;
-            }
-        }
-        
-        if (max_index >= 0) {
-            const char* state_str;
-            switch (fs_cache[max_index].state) {
-                case CACHE_STATE_CLEAN: state_str = "Clean"; break;
-                case CACHE_STATE_DIRTY: state_str = "Dirty"; break;
-                default: state_str = "Unknown"; break;
-            }
-            
-            terminal_printf("%5d %8d %8s %8d\n",
-                          max_index,
-                          fs_cache[max_index].sector,
-                          state_str,
-                          fs_cache[max_index].access_count);
-            
-            // Mark as processed by setting count to 0
-            fs_cache[max_index].access_count = 0;
-        }
+    bcache_block_info_t top[5];
+    int count = bcache_top_blocks(top, 5);
+    for (int i = 0; i < count; i++) {
+        terminal_printf("%5d %8d %8s %8d\n",
+                      top[i].dev,
+                      top[i].sector,
+                      top[i].dirty ? "Dirty" : "Clean",
+                      top[i].access_count);
     }
 }
 
@@ -417,7 +677,7 @@ int fs_check(void) {
     terminal_writestring("Performing file system consistency check...\n");
     
     // Flush all cache to ensure disk is consistent
-    fs_flush_all_cache();
+    bcache_sync();
     
     // For now, we'll just perform a simple check of the in-memory file system
     int errors = 0;
@@ -489,7 +749,7 @@ int fs_repair(void) {
     terminal_writestring("Repairing file system...\n");
     
     // Flush all cache
-    fs_flush_all_cache();
+    bcache_sync();
     
     // For this simplified version, we'll just implement basic repairs
     int repairs = 0;
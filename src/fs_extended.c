@@ -1,5 +1,6 @@
 // src/fs_extended.c
 #include "fs_extended.h"
+#include "bcache.h"
 #include "hal_ata.h"
 #include "kmalloc.h"
 #include "string.h"
@@ -47,7 +48,7 @@ int fs_detect_partitions(uint8_t drive) {
     }
     
     // Read MBR (first sector)
-    if (hal_ata_read_sectors(drive, 0, 1, mbr) != 0) {
+    if (bcache_read_meta(BCACHE_DEV_ATA(drive), 0, mbr, 1) != 0) {
         terminal_writestring("Failed to read MBR\n");
         kfree(mbr);
         return -1;
@@ -227,14 +228,14 @@ int fs_format_partition(uint8_t drive, uint8_t partition, uint8_t fs_type) {
             boot_sector[511] = 0xAA;
             
             // Write boot sector
-            if (hal_ata_write_sectors(drive, part->start_lba, 1, boot_sector) != 0) {
+            if (bcache_write_meta(BCACHE_DEV_ATA(drive), part->start_lba, boot_sector, 1) != 0) {
                 terminal_writestring("Failed to write boot sector\n");
                 kfree(boot_sector);
                 return -1;
             }
             
             // Write backup boot sector at sector 6
-            if (hal_ata_write_sectors(drive, part->start_lba + 6, 1, boot_sector) != 0) {
+            if (bcache_write_meta(BCACHE_DEV_ATA(drive), part->start_lba + 6, boot_sector, 1) != 0) {
                 terminal_writestring("Failed to write backup boot sector\n");
                 kfree(boot_sector);
                 return -1;
@@ -248,14 +249,14 @@ int fs_format_partition(uint8_t drive, uint8_t partition, uint8_t fs_type) {
             *(uint32_t*)(boot_sector + 492) = 3;               // Next free cluster
             *(uint16_t*)(boot_sector + 510) = 0xAA55;          // Signature
             
-            if (hal_ata_write_sectors(drive, part->start_lba + 1, 1, boot_sector) != 0) {
+            if (bcache_write_meta(BCACHE_DEV_ATA(drive), part->start_lba + 1, boot_sector, 1) != 0) {
                 terminal_writestring("Failed to write FSInfo sector\n");
                 kfree(boot_sector);
                 return -1;
             }
             
             // Backup FSInfo sector
-            if (hal_ata_write_sectors(drive, part->start_lba + 7, 1, boot_sector) != 0) {
+            if (bcache_write_meta(BCACHE_DEV_ATA(drive), part->start_lba + 7, boot_sector, 1) != 0) {
                 terminal_writestring("Failed to write backup FSInfo sector\n");
                 kfree(boot_sector);
                 return -1;
@@ -270,14 +271,14 @@ int fs_format_partition(uint8_t drive, uint8_t partition, uint8_t fs_type) {
             *(uint32_t*)(boot_sector + 8) = 0x0FFFFFFF;  // End of cluster chain for root directory
             
             // Write first FAT sector
-            if (hal_ata_write_sectors(drive, part->start_lba + reserved_sectors, 1, boot_sector) != 0) {
+            if (bcache_write_meta(BCACHE_DEV_ATA(drive), part->start_lba + reserved_sectors, boot_sector, 1) != 0) {
                 terminal_writestring("Failed to write FAT\n");
                 kfree(boot_sector);
                 return -1;
             }
             
             // Write first sector of second FAT
-            if (hal_ata_write_sectors(drive, part->start_lba + reserved_sectors + fat_size, 1, boot_sector) != 0) {
+            if (bcache_write_meta(BCACHE_DEV_ATA(drive), part->start_lba + reserved_sectors + fat_size, boot_sector, 1) != 0) {
                 terminal_writestring("Failed to write second FAT\n");
                 kfree(boot_sector);
                 return -1;
@@ -288,7 +289,7 @@ int fs_format_partition(uint8_t drive, uint8_t partition, uint8_t fs_type) {
             uint32_t root_dir_sector = part->start_lba + reserved_sectors + (2 * fat_size);
             
             for (uint32_t i = 0; i < sectors_per_cluster; i++) {
-                if (hal_ata_write_sectors(drive, root_dir_sector + i, 1, boot_sector) != 0) {
+                if (bcache_write_meta(BCACHE_DEV_ATA(drive), root_dir_sector + i, boot_sector, 1) != 0) {
                     terminal_writestring("Failed to clear root directory\n");
                     kfree(boot_sector);
                     return -1;
@@ -297,6 +298,12 @@ int fs_format_partition(uint8_t drive, uint8_t partition, uint8_t fs_type) {
             
             kfree(boot_sector);
             
+            // The sectors above only dirtied the cache
+            if (bcache_sync() != 0) {
+                terminal_writestring("Failed to write back the new file system\n");
+                return -1;
+            }
+            
             terminal_writestring("FAT32 formatting complete\n");
             
             // Update partition file system type
@@ -552,8 +559,8 @@ int fs_create_partition_table(uint8_t drive) {
     // Set boot signature
     mbr->signature = 0xAA55;
     
-    // Write the MBR
-    if (hal_ata_write_sectors(drive, 0, 1, mbr) != 0) {
+    // Write the MBR, straight through to the disk
+    if (bcache_write_meta(BCACHE_DEV_ATA(drive), 0, mbr, 1) != 0 || bcache_sync() != 0) {
         terminal_writestring("Failed to write MBR\n");
         kfree(mbr);
         return -1;
@@ -622,7 +629,7 @@ int fs_add_partition(uint8_t drive, uint32_t start_lba, uint32_t size_sectors, u
     }
     
     // Read MBR
-    if (hal_ata_read_sectors(drive, 0, 1, mbr) != 0) {
+    if (bcache_read_meta(BCACHE_DEV_ATA(drive), 0, mbr, 1) != 0) {
         terminal_writestring("Failed to read MBR\n");
         kfree(mbr);
         return -1;
@@ -661,8 +668,8 @@ int fs_add_partition(uint8_t drive, uint32_t start_lba, uint32_t size_sectors, u
     part->start_lba = start_lba;
     part->total_sectors = size_sectors;
     
-    // Write updated MBR
-    if (hal_ata_write_sectors(drive, 0, 1, mbr) != 0) {
+    // Write updated MBR, straight through to the disk
+    if (bcache_write_meta(BCACHE_DEV_ATA(drive), 0, mbr, 1) != 0 || bcache_sync() != 0) {
         terminal_writestring("Failed to write MBR\n");
         kfree(mbr);
         return -1;
@@ -730,7 +737,7 @@ int fs_delete_partition(uint8_t drive, uint8_t partition) {
     }
     
     // Read MBR
-    if (hal_ata_read_sectors(drive, 0, 1, mbr) != 0) {
+    if (bcache_read_meta(BCACHE_DEV_ATA(drive), 0, mbr, 1) != 0) {
         terminal_writestring("Failed to read MBR\n");
         kfree(mbr);
         return -1;
@@ -739,8 +746,8 @@ int fs_delete_partition(uint8_t drive, uint8_t partition) {
     // Clear partition entry
     memset(&mbr->partitions[partition], 0, sizeof(mbr_partition_t));
     
-    // Write updated MBR
-    if (hal_ata_write_sectors(drive, 0, 1, mbr) != 0) {
+    // Write updated MBR, straight through to the disk
+    if (bcache_write_meta(BCACHE_DEV_ATA(drive), 0, mbr, 1) != 0 || bcache_sync() != 0) {
         terminal_writestring("Failed to write MBR\n");
         kfree(mbr);
         return -1;
@@ -786,7 +793,7 @@ int fat32_mount(uint8_t drive, uint32_t start_lba, uint32_t sectors, void** fs_d
         return -1;
     }
     
-    if (hal_ata_read_sectors(drive, start_lba, 1, boot_sector) != 0) {
+    if (bcache_read_meta(BCACHE_DEV_ATA(drive), start_lba, boot_sector, 1) != 0) {
         terminal_writestring("Failed to read boot sector\n");
         kfree(boot_sector);
         kfree(fat_data);
@@ -0,0 +1,102 @@
+// src/gdt.c
+#include "gdt.h"
+#include "string.h"
+
+// Segment descriptor
+struct gdt_entry {
+    uint16_t limit_low;
+    uint16_t base_low;
+    uint8_t base_mid;
+    uint8_t access;
+    uint8_t granularity;
+    uint8_t base_high;
+} __attribute__((packed));
+
+// GDT pointer structure
+struct gdt_ptr {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed));
+
+// 32-bit task state segment; only the ring 0 stack is used
+struct tss_entry {
+    uint32_t prev_tss;
+    uint32_t esp0, ss0;
+    uint32_t esp1, ss1;
+    uint32_t esp2, ss2;
+    uint32_t cr3, eip, eflags;
+    uint32_t eax, ecx, edx, ebx, esp, ebp, esi, edi;
+    uint32_t es, cs, ss, ds, fs, gs;
+    uint32_t ldt;
+    uint16_t trap;
+    uint16_t iomap_base;
+} __attribute__((packed));
+
+// Null, kernel code/data, user code/data, TSS
+#define GDT_ENTRIES 6
+
+// Access bytes
+#define GDT_ACCESS_KERNEL_CODE 0x9A
+#define GDT_ACCESS_KERNEL_DATA 0x92
+#define GDT_ACCESS_USER_CODE   0xFA
+#define GDT_ACCESS_USER_DATA   0xF2
+#define GDT_ACCESS_TSS         0x89
+
+// 4 KB granularity, 32-bit
+#define GDT_FLAGS_FLAT 0xCF
+
+static struct gdt_entry gdt[GDT_ENTRIES] __attribute__((aligned(8)));
+static struct gdt_ptr gdtp;
+static struct tss_entry tss __attribute__((aligned(16)));
+
+// Stack for interrupts and SYSENTER from user mode
+static uint8_t trap_stack[GDT_TRAP_STACK_SIZE] __attribute__((aligned(16)));
+
+static void gdt_set_entry(int num, uint32_t base, uint32_t limit, uint8_t access, uint8_t flags) {
+    gdt[num].base_low = base & 0xFFFF;
+    gdt[num].base_mid = (base >> 16) & 0xFF;
+    gdt[num].base_high = (base >> 24) & 0xFF;
+    gdt[num].limit_low = limit & 0xFFFF;
+    gdt[num].granularity = ((limit >> 16) & 0x0F) | (flags & 0xF0);
+    gdt[num].access = access;
+}
+
+void gdt_init(void) {
+    gdt_set_entry(0, 0, 0, 0, 0);
+    gdt_set_entry(GDT_KERNEL_CODE >> 3, 0, 0xFFFFF, GDT_ACCESS_KERNEL_CODE, GDT_FLAGS_FLAT);
+    gdt_set_entry(GDT_KERNEL_DATA >> 3, 0, 0xFFFFF, GDT_ACCESS_KERNEL_DATA, GDT_FLAGS_FLAT);
+    gdt_set_entry(GDT_USER_CODE >> 3, 0, 0xFFFFF, GDT_ACCESS_USER_CODE, GDT_FLAGS_FLAT);
+    gdt_set_entry(GDT_USER_DATA >> 3, 0, 0xFFFFF, GDT_ACCESS_USER_DATA, GDT_FLAGS_FLAT);
+    
+    // The TSS has no I/O bitmap: iomap_base points past its limit
+    memset(&tss, 0, sizeof(tss));
+    tss.ss0 = GDT_KERNEL_DATA;
+    tss.esp0 = gdt_trap_stack_top();
+    tss.iomap_base = sizeof(tss);
+    gdt_set_entry(GDT_TSS >> 3, (uint32_t)&tss, sizeof(tss) - 1, GDT_ACCESS_TSS, 0);
+    
+    gdtp.limit = sizeof(gdt) - 1;
+    gdtp.base = (uint32_t)&gdt;
+    
+    // The bootloader's selectors may differ; reload all of them
+    asm volatile("lgdt %0\n\t"
+                 "ljmp %1, $1f\n"
+                 "1:\n\t"
+                 "movw %2, %%ax\n\t"
+                 "movw %%ax, %%ds\n\t"
+                 "movw %%ax, %%es\n\t"
+                 "movw %%ax, %%fs\n\t"
+                 "movw %%ax, %%gs\n\t"
+                 "movw %%ax, %%ss"
+                 : : "m"(gdtp), "i"(GDT_KERNEL_CODE), "i"(GDT_KERNEL_DATA) : "eax", "memory");
+    
+    asm volatile("ltr %w0" : : "r"(GDT_TSS));
+}
+
+void gdt_set_kernel_stack(uint32_t esp0) {
+    tss.esp0 = esp0;
+}
+
+uint32_t gdt_trap_stack_top(void) {
+    return (uint32_t)&trap_stack[GDT_TRAP_STACK_SIZE];
+}
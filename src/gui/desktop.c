@@ -10,6 +10,7 @@
 #include "terminal.h"
 #include "kmalloc.h"
 #include "string.h"
+#include "task.h"
 
 // Add these definitions to desktop.c
 #define CURSOR_WIDTH 8
@@ -26,6 +27,9 @@
 #define ICON_MARGIN_X 20
 #define ICON_MARGIN_Y 20
 
+// Desktop redraw interval in milliseconds (~30 frames per second)
+#define DESKTOP_FRAME_MS 33
+
 // Taskbar dimensions
 #define TASKBAR_HEIGHT 30
 #define TASKBAR_BUTTON_WIDTH 120
@@ -87,6 +91,11 @@ static int text_editor_event_handler(window_t* window, window_message_t* msg);
 static int settings_event_handler(window_t* window, window_message_t* msg);
 
 
+// Desktop tasks (run cooperatively on the kernel thread)
+static task_t desktop_input_task;
+static task_t desktop_clock_task;
+static task_t desktop_render_task;
+
 // Last known mouse position for redrawing
 static int16_t last_mouse_x = -1;
 static int16_t last_mouse_y = -1;
@@ -238,6 +247,37 @@ void desktop_process_events(void) {
     update_clock();
 }
 
+// Input task: pump window manager events once per frame, so mouse
+// motion is coalesced into one hit test and cursor update per frame
+static int desktop_input_task_func(task_t* task) {
+    TASK_BEGIN(task);
+    while (1) {
+        wm_process_events();
+        TASK_SLEEP(task, DESKTOP_FRAME_MS);
+    }
+    TASK_END(task);
+}
+
+// Clock task: refresh the taskbar clock once a second
+static int desktop_clock_task_func(task_t* task) {
+    TASK_BEGIN(task);
+    while (1) {
+        update_clock();
+        TASK_SLEEP(task, 1000);
+    }
+    TASK_END(task);
+}
+
+// Render task: redraw the desktop at a fixed frame rate
+static int desktop_render_task_func(task_t* task) {
+    TASK_BEGIN(task);
+    while (1) {
+        desktop_update();
+        TASK_SLEEP(task, DESKTOP_FRAME_MS);
+    }
+    TASK_END(task);
+}
+
 // In desktop.c - update the desktop_run function
 int desktop_run(void) {
     terminal_writestring("desktop_run: Starting desktop environment...\n");
@@ -287,29 +327,15 @@ int desktop_run(void) {
     desktop_update();
     terminal_writestring("desktop_run: Entering main event loop\n");
 
-    // Main desktop event loop
-    uint32_t loop_count = 0;
-    while (1) {
-        // Process desktop events (mouse, keyboard, etc.)
-        desktop_process_events();
-        
-        // Update desktop display
-        desktop_update();
-        
-        // Simple delay to reduce CPU usage
-        for (volatile int i = 0; i < 100000; i++) {
-            // Empty delay loop
-        }
-        
-        // Log every 1000 iterations
-        loop_count++;
-        if (loop_count % 1000 == 0) {
-            char buf[32];
-            sprintf(buf, "Desktop event loop: %u", loop_count);
-            terminal_writestring(buf);
-            terminal_writestring("\n");
-        }
-    }
+    // Hand the event loop over to the cooperative task runtime
+    task_init(&desktop_input_task, "desktop-input", desktop_input_task_func, NULL);
+    task_init(&desktop_clock_task, "desktop-clock", desktop_clock_task_func, NULL);
+    task_init(&desktop_render_task, "desktop-render", desktop_render_task_func, NULL);
+    task_start(&desktop_input_task);
+    task_start(&desktop_clock_task);
+    task_start(&desktop_render_task);
+    
+    task_run_loop();
     
     return -1; // Should never reach here
 }
@@ -595,7 +621,7 @@ static void draw_taskbar(void) {
 // Update the taskbar clock
 static void update_clock(void) {
     // Get current time from system timer
-    uint32_t current_time = hal_timer_get_ticks() / 100; // Convert to seconds
+    uint32_t current_time = hal_timer_get_ticks() / hal_timer_get_frequency(); // Convert to seconds
     
     // Calculate hours and minutes
     uint32_t seconds = current_time % 60;
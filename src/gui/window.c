@@ -237,7 +237,7 @@ void wm_update(void) {
 
 // Process window manager events (mouse, keyboard, etc.)
 void wm_process_events(void) {
-    // Poll for mouse updates
+    // Deliver mouse motion coalesced since the last pass
     mouse_update();
     
     // Process messages in the queue
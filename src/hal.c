@@ -136,6 +136,7 @@ extern int hal_timer_init(void);
 extern int hal_keyboard_init(void);
 extern int hal_framebuffer_init(void);
 extern int hal_mouse_init(void);
+extern int hal_storage_init(void);
 
 int hal_init_devices(void) {
     int status = 0;
@@ -158,6 +159,32 @@ int hal_init_devices(void) {
             fb_data.width, fb_data.height, fb_data.bits_per_pixel); // ADDED DEBUG
     terminal_writestring(buf); // ADDED DEBUG
     
+    // Timer drives IRQ0; the scheduler and all timed waits depend on it
+    SERIAL_DEBUG("Initializing timer...\n");
+    if (hal_timer_init() != 0) {
+        terminal_writestring("Failed to initialize HAL timer device\n");
+        return -1;
+    }
+    
+    // Keyboard feeds its event ring from IRQ1
+    SERIAL_DEBUG("Initializing keyboard...\n");
+    if (hal_keyboard_init() != 0) {
+        terminal_writestring("Failed to initialize HAL keyboard device\n");
+        return -1;
+    }
+    
+    // Mouse assembles packets from IRQ12; the system runs fine without one
+    SERIAL_DEBUG("Initializing mouse...\n");
+    if (hal_mouse_init() != 0) {
+        terminal_writestring("No PS/2 mouse, continuing without it\n");
+    }
+    
+    // RAM disk; the buffer cache set up by fs_init() sits in front of it
+    SERIAL_DEBUG("Initializing RAM disk...\n");
+    if (hal_storage_init() != 0) {
+        terminal_writestring("No RAM disk, continuing without it\n");
+    }
+    
     // ... (Rest of hal_init_devices - device inits commented out) ...
 
     return 0;
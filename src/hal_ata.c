@@ -7,6 +7,8 @@
 #include "terminal.h"
 #include "stdio.h"
 #include "string.h"
+#include "hal_timer.h"
+#include "hrtimer.h"
 
 // Maximum number of ATA devices
 #define ATA_MAX_DEVICES 4
@@ -42,19 +44,37 @@ static void ata_select_drive(uint16_t base_port, uint8_t drive) {
     ata_delay(base_port);
 }
 
+// Busy-poll this long before sleeping between status reads
+#define ATA_SPIN_NS     (50 * NSEC_PER_USEC)
+
+// Sleep between status reads once past the spin window
+#define ATA_BACKOFF_NS  (100 * NSEC_PER_USEC)
+
+// Status reads per millisecond of timeout, a backstop in case the clock
+// is not running yet (a status read takes well over 100 ns)
+#define ATA_POLLS_PER_MS 10000
+
 // Wait for BSY flag to clear with timeout
 static int ata_wait_not_busy(uint16_t base_port, int timeout_ms) {
-    uint8_t status;
-    int timeout = timeout_ms * 1000; // Convert to µs
+    uint64_t start = hal_timer_get_ns();
+    uint64_t deadline = start + (uint64_t)timeout_ms * NSEC_PER_MSEC;
+    uint32_t polls = (uint32_t)timeout_ms * ATA_POLLS_PER_MS;
     
-    while (timeout > 0) {
-        status = inb(base_port + 7);
+    while (polls-- > 0) {
+        uint8_t status = inb(base_port + 7);
         if (!(status & ATA_STATUS_BSY))
             return 0; // Not busy
         
-        // Delay ~1µs
-        ata_delay(base_port);
-        timeout -= 400; // Approximate delay of ata_delay
+        uint64_t now = hal_timer_get_ns();
+        if (now >= deadline)
+            return -1; // Timeout
+        
+        // Most commands finish within microseconds; slow ones get a timed sleep
+        if (now - start < ATA_SPIN_NS) {
+            asm volatile("pause");
+        } else {
+            hrtimer_sleep_ns(ATA_BACKOFF_NS);
+        }
     }
     
     return -1; // Timeout
@@ -62,11 +82,12 @@ static int ata_wait_not_busy(uint16_t base_port, int timeout_ms) {
 
 // Wait for DRQ flag to set with timeout
 static int ata_wait_drq(uint16_t base_port, int timeout_ms) {
-    uint8_t status;
-    int timeout = timeout_ms * 1000; // Convert to µs
+    uint64_t start = hal_timer_get_ns();
+    uint64_t deadline = start + (uint64_t)timeout_ms * NSEC_PER_MSEC;
+    uint32_t polls = (uint32_t)timeout_ms * ATA_POLLS_PER_MS;
     
-    while (timeout > 0) {
-        status = inb(base_port + 7);
+    while (polls-- > 0) {
+        uint8_t status = inb(base_port + 7);
         if (status & ATA_STATUS_DRQ)
             return 0; // DRQ set
         
@@ -77,9 +98,15 @@ static int ata_wait_drq(uint16_t base_port, int timeout_ms) {
             return -1;
         }
         
-        // Delay ~1µs
-        ata_delay(base_port);
-        timeout -= 400; // Approximate delay of ata_delay
+        uint64_t now = hal_timer_get_ns();
+        if (now >= deadline)
+            return -1; // Timeout
+        
+        if (now - start < ATA_SPIN_NS) {
+            asm volatile("pause");
+        } else {
+            hrtimer_sleep_ns(ATA_BACKOFF_NS);
+        }
     }
     
     return -1; // Timeout
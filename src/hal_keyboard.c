@@ -1,19 +1,199 @@
 // src/hal_keyboard.c
 #include "hal.h"
+#include "hal_keyboard.h"
+#include "hal_timer.h"
+#include "interrupts.h"
 #include "terminal.h"
 
-// Keyboard device private data
+// IRQ1 vector after the PIC remap
+#define KEYBOARD_IRQ_VECTOR 33
+
+// Scancode prefix for extended keys
+#define SCANCODE_EXTENDED 0xE0
+
+// Number of keycodes covered by the translation tables
+#define KEYCODE_TABLE_SIZE 0x70
+
+// Keyboard device private data. The ring is single-producer (IRQ1, or
+// the poller with interrupts off) / single-consumer (the reader), so
+// head is only written by the producer and tail only by the consumer.
 typedef struct {
     int last_scancode;
-    int buffer[16];
-    int buffer_head;
-    int buffer_tail;
+    key_event_t ring[KEYBOARD_RING_SIZE];
+    volatile uint32_t head;          // Next slot to fill
+    volatile uint32_t tail;          // Next slot to read
+    uint32_t dropped;                // Events lost to a full ring
+    uint8_t extended;                // Last byte was an E0 prefix
+    uint8_t modifiers;               // KEY_EVENT_SHIFT/CTRL/ALT/CAPS state
+    wait_queue_t waiters;            // Woken when an event is queued
 } keyboard_data_t;
 
 // Local keyboard device
 static keyboard_data_t keyboard_data = {0};
 static hal_device_t keyboard_device = {0};
 
+// US QWERTY, unshifted; indexed by keycode
+static const char keymap_normal[KEYCODE_TABLE_SIZE] = {
+    0, 27, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b',
+    '\t', 'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '[', ']', '\n',
+    0, 'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ';', '\'', '`',
+    0, '\\', 'z', 'x', 'c', 'v', 'b', 'n', 'm', ',', '.', '/', 0,
+    '*', 0, ' ', 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0,                 // F1-F10
+    0, 0,                                         // Num Lock, Scroll Lock
+    '7', '8', '9', '-', '4', '5', '6', '+', '1', '2', '3', '0', '.',
+    [KEY_KPENTER] = '\n',
+    [KEY_KPSLASH] = '/'
+};
+
+// US QWERTY, shifted; indexed by keycode
+static const char keymap_shift[KEYCODE_TABLE_SIZE] = {
+    0, 27, '!', '@', '#', '$', '%', '^', '&', '*', '(', ')', '_', '+', '\b',
+    '\t', 'Q', 'W', 'E', 'R', 'T', 'Y', 'U', 'I', 'O', 'P', '{', '}', '\n',
+    0, 'A', 'S', 'D', 'F', 'G', 'H', 'J', 'K', 'L', ':', '"', '~',
+    0, '|', 'Z', 'X', 'C', 'V', 'B', 'N', 'M', '<', '>', '?', 0,
+    '*', 0, ' ', 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0,
+    '7', '8', '9', '-', '4', '5', '6', '+', '1', '2', '3', '0', '.',
+    [KEY_KPENTER] = '\n',
+    [KEY_KPSLASH] = '/'
+};
+
+// E0-prefixed scancodes to keycodes (0 = ignored, e.g. fake shifts)
+static const uint8_t keymap_extended[128] = {
+    [0x1C] = KEY_KPENTER,
+    [0x1D] = KEY_RCTRL,
+    [0x35] = KEY_KPSLASH,
+    [0x38] = KEY_RALT,
+    [0x47] = KEY_HOME,
+    [0x48] = KEY_UP,
+    [0x49] = KEY_PGUP,
+    [0x4B] = KEY_LEFT,
+    [0x4D] = KEY_RIGHT,
+    [0x4F] = KEY_END,
+    [0x50] = KEY_DOWN,
+    [0x51] = KEY_PGDN,
+    [0x52] = KEY_INSERT,
+    [0x53] = KEY_DELETE
+};
+
+// Translate a keycode to ASCII given modifier flags
+char hal_keyboard_keycode_to_ascii(uint8_t keycode, uint8_t flags) {
+    if (keycode >= KEYCODE_TABLE_SIZE) {
+        return 0;
+    }
+    
+    char c = keymap_normal[keycode];
+    int shifted = (flags & KEY_EVENT_SHIFT) != 0;
+    
+    // Caps Lock only affects letters
+    if ((flags & KEY_EVENT_CAPS) && c >= 'a' && c <= 'z') {
+        shifted = !shifted;
+    }
+    if (shifted) {
+        c = keymap_shift[keycode];
+    }
+    
+    // Ctrl+letter gives the control character (Ctrl+D = 0x04)
+    if ((flags & KEY_EVENT_CTRL) && ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))) {
+        c &= 0x1F;
+    }
+    
+    return c;
+}
+
+// Track modifier state from a key event
+static void keyboard_update_modifiers(keyboard_data_t* data, uint8_t keycode, int released) {
+    uint8_t bit = 0;
+    
+    switch (keycode) {
+        case KEY_LSHIFT:
+        case KEY_RSHIFT:
+            bit = KEY_EVENT_SHIFT;
+            break;
+        case KEY_LCTRL:
+        case KEY_RCTRL:
+            bit = KEY_EVENT_CTRL;
+            break;
+        case KEY_LALT:
+        case KEY_RALT:
+            bit = KEY_EVENT_ALT;
+            break;
+        case KEY_CAPS:
+            if (!released) {
+                data->modifiers ^= KEY_EVENT_CAPS;
+            }
+            return;
+        default:
+            return;
+    }
+    
+    if (released) {
+        data->modifiers &= ~bit;
+    } else {
+        data->modifiers |= bit;
+    }
+}
+
+// Translate one byte from the controller and queue the resulting event.
+// Producer side of the ring: runs in IRQ1 or with interrupts disabled.
+static void keyboard_process_scancode(keyboard_data_t* data, uint8_t scancode) {
+    data->last_scancode = scancode;
+    
+    if (scancode == SCANCODE_EXTENDED) {
+        data->extended = 1;
+        return;
+    }
+    
+    int released = (scancode & KEY_RELEASE) != 0;
+    uint8_t code = scancode & ~KEY_RELEASE;
+    uint8_t keycode;
+    uint8_t flags = 0;
+    
+    if (data->extended) {
+        data->extended = 0;
+        keycode = keymap_extended[code];
+        flags |= KEY_EVENT_EXTENDED;
+        if (keycode == 0) {
+            return;
+        }
+    } else {
+        keycode = code;
+    }
+    
+    keyboard_update_modifiers(data, keycode, released);
+    
+    uint32_t head = data->head;
+    if (head - __atomic_load_n(&data->tail, __ATOMIC_ACQUIRE) >= KEYBOARD_RING_SIZE) {
+        data->dropped++;
+        return;
+    }
+    
+    key_event_t* ev = &data->ring[head & (KEYBOARD_RING_SIZE - 1)];
+    ev->timestamp_ns = hal_timer_get_ns();
+    ev->scancode = scancode;
+    ev->keycode = keycode;
+    ev->flags = flags | data->modifiers | (released ? KEY_EVENT_RELEASE : 0);
+    ev->ascii = released ? 0 : hal_keyboard_keycode_to_ascii(keycode, data->modifiers);
+    
+    // Publish the slot before moving head
+    __atomic_store_n(&data->head, head + 1, __ATOMIC_RELEASE);
+    
+    wait_queue_wake_all(&data->waiters);
+}
+
+// IRQ1 handler
+static void keyboard_irq_handler(struct regs* r) {
+    // Ignore bytes that belong to the auxiliary (mouse) port
+    uint8_t status = inb(0x64);
+    if (!(status & 0x01) || (status & 0x20)) {
+        return;
+    }
+    
+    keyboard_process_scancode(&keyboard_data, inb(0x60));
+}
+
 // Device-specific functions
 static int keyboard_init(void* device) {
     hal_device_t* dev = (hal_device_t*)device;
@@ -21,10 +201,21 @@ static int keyboard_init(void* device) {
     
     // Initialize data
     data->last_scancode = 0;
-    data->buffer_head = 0;
-    data->buffer_tail = 0;
+    data->head = 0;
+    data->tail = 0;
+    data->dropped = 0;
+    data->extended = 0;
+    data->modifiers = 0;
+    wait_queue_init(&data->waiters);
+    
+    // Drain anything left over from the firmware, then take IRQ1
+    while (inb(0x64) & 0x01) {
+        inb(0x60);
+    }
+    interrupt_register_handler(KEYBOARD_IRQ_VECTOR, keyboard_irq_handler);
+    dev->mode = HAL_MODE_INTERRUPT;
     
-    terminal_writestring("HAL Keyboard initialized in polling mode\n");
+    terminal_writestring("HAL Keyboard initialized in interrupt mode\n");
     
     return 0;
 }
@@ -34,18 +225,13 @@ static int keyboard_close(void* device) {
 }
 
 static int keyboard_read(void* device, void* buffer, uint32_t size) {
-    hal_device_t* dev = (hal_device_t*)device;
-    keyboard_data_t* data = (keyboard_data_t*)dev->private_data;
-    
-    if (size < sizeof(int)) {
+    if (size < sizeof(key_event_t)) {
         return -1;
     }
     
-    // Read scancode from buffer if available
-    if (data->buffer_head != data->buffer_tail) {
-        *((int*)buffer) = data->buffer[data->buffer_tail];
-        data->buffer_tail = (data->buffer_tail + 1) % 16;
-        return sizeof(int);
+    // Read one event if available
+    if (hal_keyboard_read_event((key_event_t*)buffer)) {
+        return sizeof(key_event_t);
     }
     
     return 0; // No data available
@@ -59,37 +245,67 @@ static int keyboard_ioctl(void* device, uint32_t request, void* arg) {
     return -1; // No ioctls defined yet
 }
 
-// Poll keyboard for input
+// Poll keyboard for input (only used before IRQ1 is set up)
 void hal_keyboard_poll(void) {
+    if (keyboard_device.mode == HAL_MODE_INTERRUPT) {
+        return;
+    }
+    
+    // Keep the single-producer rule: IRQ1 cannot run while we feed the ring
+    uint32_t flags = irq_save();
+    if ((inb(0x64) & 0x21) == 0x01) {
+        keyboard_process_scancode(&keyboard_data, inb(0x60));
+    }
+    irq_restore(flags);
+}
+
+// Take the next key event (consumer side of the ring)
+int hal_keyboard_read_event(key_event_t* event) {
     keyboard_data_t* data = &keyboard_data;
     
-    // Check if keyboard has data
-    if (inb(0x64) & 1) {
-        int scancode = inb(0x60);
-        
-        // Store in buffer if space available
-        int next_head = (data->buffer_head + 1) % 16;
-        if (next_head != data->buffer_tail) {
-            data->buffer[data->buffer_head] = scancode;
-            data->buffer_head = next_head;
+    // Poll keyboard first (no-op in interrupt mode)
+    hal_keyboard_poll();
+    
+    uint32_t tail = data->tail;
+    if (tail == __atomic_load_n(&data->head, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    
+    *event = data->ring[tail & (KEYBOARD_RING_SIZE - 1)];
+    __atomic_store_n(&data->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Wait until a key event is available and take it
+void hal_keyboard_wait_event(key_event_t* event) {
+    while (!hal_keyboard_read_event(event)) {
+        if (keyboard_device.mode == HAL_MODE_INTERRUPT) {
+            // IRQ1 wakes us; "sti; hlt" closes the check-then-sleep race
+            uint32_t flags = irq_save();
+            if (keyboard_data.tail == keyboard_data.head) {
+                irq_enable_and_halt();
+            }
+            irq_restore(flags);
         }
-        
-        data->last_scancode = scancode;
     }
 }
 
+// Wait queue woken whenever a key event is queued
+wait_queue_t* hal_keyboard_wait_queue(void) {
+    return &keyboard_data.waiters;
+}
+
+// Number of events dropped because the ring was full
+uint32_t hal_keyboard_dropped(void) {
+    return keyboard_data.dropped;
+}
+
 // HAL keyboard interface functions
 int hal_keyboard_read(void) {
-    keyboard_data_t* data = &keyboard_data;
+    key_event_t event;
     
-    // Poll keyboard first
-    hal_keyboard_poll();
-    
-    // Read from buffer if available
-    if (data->buffer_head != data->buffer_tail) {
-        int scancode = data->buffer[data->buffer_tail];
-        data->buffer_tail = (data->buffer_tail + 1) % 16;
-        return scancode;
+    if (hal_keyboard_read_event(&event)) {
+        return event.scancode;
     }
     
     return -1; // No key available
@@ -101,7 +317,7 @@ int hal_keyboard_is_key_available(void) {
     // Poll keyboard first
     hal_keyboard_poll();
     
-    return (data->buffer_head != data->buffer_tail);
+    return data->head != data->tail;
 }
 
 // Initialize and register keyboard device
@@ -120,4 +336,4 @@ int hal_keyboard_init(void) {
     
     // Register with HAL
     return hal_register_device(&keyboard_device);
-}
\ No newline at end of file
+}
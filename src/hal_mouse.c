@@ -1,9 +1,23 @@
 // src/hal_mouse.c
 #include "hal_mouse.h"
 #include "hal.h"  // Added to get hal_device_t definition
+#include "interrupts.h"
+#include "softirq.h"
+#include "wait_queue.h"
 #include "terminal.h"
 #include "stdio.h"
 
+// IRQ12 vector after the PIC remap
+#define MOUSE_IRQ_VECTOR 44
+
+// Coalesced motion slots between two mouse_update() calls. Motion is
+// merged into the newest slot while the buttons stay the same; a button
+// change opens a new slot so a click inside one frame is not lost.
+#define MOUSE_MOTION_SLOTS 8
+
+// Raw bytes between IRQ12 and the decode tasklet (power of two)
+#define MOUSE_BYTE_RING 64
+
 // PS/2 mouse ports
 #define PS2_DATA_PORT      0x60
 #define PS2_COMMAND_PORT   0x64
@@ -52,6 +66,14 @@
 #define MOUSE_TYPE_WHEEL    3
 #define MOUSE_TYPE_5BUTTON  4
 
+// Accumulated movement for one button state
+typedef struct {
+    int16_t dx;
+    int16_t dy;
+    int16_t dz;
+    uint8_t buttons;
+} mouse_motion_t;
+
 // Mouse data structure
 typedef struct {
     int16_t x;
@@ -65,12 +87,29 @@ typedef struct {
     uint8_t packet_index;
     uint8_t packet_size;
     uint8_t has_wheel;
+    
+    // Raw aux bytes: IRQ12 writes byte_head, the tasklet writes byte_tail
+    uint8_t bytes[MOUSE_BYTE_RING];
+    volatile uint32_t byte_head;
+    volatile uint32_t byte_tail;
+    uint32_t bytes_dropped;          // Ring was full
+    
+    // Filled by the tasklet, drained by mouse_update() with interrupts off
+    mouse_motion_t motion[MOUSE_MOTION_SLOTS];
+    volatile uint8_t motion_count;
+    uint8_t irq_buttons;             // Button state of the newest packet
+    wait_queue_t waiters;            // Woken when motion is queued
+    uint32_t packets;                // Packets received
+    uint32_t events;                 // Events delivered to handlers
 } mouse_data_t;
 
 // Local mouse device
 static mouse_data_t mouse_data = {0};
 static hal_device_t mouse_device = {0};
 
+// Bottom half that decodes the bytes IRQ12 collected
+static tasklet_t mouse_tasklet;
+
 // For GUI integration - Mouse event callbacks
 static mouse_event_handler_t mouse_event_handlers[MAX_MOUSE_EVENT_HANDLERS] = {0};
 static uint8_t mouse_event_handler_count = 0;
@@ -237,11 +276,16 @@ static int init_ps2_mouse(void) {
     return 0;
 }
 
-// Process a complete mouse packet
-static void process_mouse_packet(void) {
+// Merge a complete packet into the pending motion (tasklet context)
+static void mouse_queue_packet(void) {
     // First byte contains button state and signs
     uint8_t buttons = mouse_data.packet[0] & 0x07;  // 3 lower bits are buttons
     
+    // Drop packets the mouse flagged as overflowed; the deltas are garbage
+    if (mouse_data.packet[0] & (MOUSE_X_OVERFLOW | MOUSE_Y_OVERFLOW)) {
+        return;
+    }
+    
     // Extract movement values
     int16_t dx = mouse_data.packet[1];
     int16_t dy = mouse_data.packet[2];
@@ -265,61 +309,113 @@ static void process_mouse_packet(void) {
         dz = (int8_t)mouse_data.packet[3];
     }
     
-    // Update mouse position
-    mouse_data.x += dx;
-    mouse_data.y += dy;
-    mouse_data.z += dz;
+    mouse_data.packets++;
     
-    // Clamp position to screen boundaries (assuming 640x480)
-    if (mouse_data.x < 0) mouse_data.x = 0;
-    if (mouse_data.y < 0) mouse_data.y = 0;
-    if (mouse_data.x > 639) mouse_data.x = 639;
-    if (mouse_data.y > 479) mouse_data.y = 479;
-    
-    // Update button state
-    mouse_data.buttons = buttons;
-    
-    // Call event handlers
-    mouse_event_t event = {
-        .x = mouse_data.x,
-        .y = mouse_data.y,
-        .z = dz,
-        .dx = dx,
-        .dy = dy,
-        .dz = dz,
-        .buttons = buttons,
-        .prev_buttons = mouse_data.buttons
-    };
-    
-    for (uint8_t i = 0; i < mouse_event_handler_count; i++) {
-        if (mouse_event_handlers[i] != NULL) {
-            mouse_event_handlers[i](&event);
-        }
+    uint8_t count = mouse_data.motion_count;
+    mouse_motion_t* slot;
+    if (count > 0 && (mouse_data.motion[count - 1].buttons == buttons ||
+                      count == MOUSE_MOTION_SLOTS)) {
+        // Same buttons (or no room left): fold into the newest slot
+        slot = &mouse_data.motion[count - 1];
+    } else {
+        slot = &mouse_data.motion[count];
+        slot->dx = 0;
+        slot->dy = 0;
+        slot->dz = 0;
+        mouse_data.motion_count = count + 1;
     }
+    
+    slot->dx += dx;
+    slot->dy += dy;
+    slot->dz += dz;
+    slot->buttons = buttons;
+    mouse_data.irq_buttons = buttons;
+    
+    wait_queue_wake_all(&mouse_data.waiters);
 }
 
-// Poll for mouse data
+// Feed one byte from the aux port into the packet assembler
+static void mouse_process_byte(uint8_t data) {
+    if (mouse_data.packet_size == 0) {
+        return;  // Not initialized yet
+    }
+    
+    // Handle packet assembly
+    if (mouse_data.packet_index == 0 && (data & 0x08) == 0) {
+        // Ignore packet if first byte doesn't have bit 3 set
+        // (synchronization)
+        return;
+    }
+    
+    // Add byte to packet
+    mouse_data.packet[mouse_data.packet_index++] = data;
+    
+    // Queue packet if complete
+    if (mouse_data.packet_index >= mouse_data.packet_size) {
+        mouse_queue_packet();
+        mouse_data.packet_index = 0;
+    }
+}
+
+// Decode tasklet: assemble packets from the bytes IRQ12 queued
+static void mouse_tasklet_func(void* data) {
+    uint32_t tail = mouse_data.byte_tail;
+    
+    while (tail != mouse_data.byte_head) {
+        mouse_process_byte(mouse_data.bytes[tail & (MOUSE_BYTE_RING - 1)]);
+        tail++;
+        mouse_data.byte_tail = tail;
+    }
+}
+
+// IRQ12 handler: take the byte and leave decoding to the tasklet
+static void mouse_irq_handler(struct regs* r) {
+    // Only take bytes that came from the auxiliary port
+    uint8_t status = inb(PS2_STATUS_PORT);
+    if ((status & 0x21) != 0x21) {
+        return;
+    }
+    
+    uint8_t data = inb(PS2_DATA_PORT);
+    uint32_t head = mouse_data.byte_head;
+    if (head - mouse_data.byte_tail >= MOUSE_BYTE_RING) {
+        mouse_data.bytes_dropped++;
+    } else {
+        mouse_data.bytes[head & (MOUSE_BYTE_RING - 1)] = data;
+        mouse_data.byte_head = head + 1;
+    }
+    
+    tasklet_schedule(&mouse_tasklet);
+}
+
+// Poll for mouse data when IRQ12 is not in use
 static void mouse_poll(void) {
-    // Check if data is available
-    if (inb(PS2_STATUS_PORT) & 0x01) {
-        uint8_t data = inb(PS2_DATA_PORT);
-        
-        // Handle packet assembly
-        if (mouse_data.packet_index == 0 && (data & 0x08) == 0) {
-            // Ignore packet if first byte doesn't have bit 3 set
-            // (synchronization)
-            return;
-        }
-        
-        // Add byte to packet
-        mouse_data.packet[mouse_data.packet_index++] = data;
-        
-        // Process packet if complete
-        if (mouse_data.packet_index >= mouse_data.packet_size) {
-            process_mouse_packet();
-            mouse_data.packet_index = 0;
-        }
+    if (mouse_device.mode == HAL_MODE_INTERRUPT) {
+        return;
     }
+    
+    uint32_t flags = irq_save();
+    while ((inb(PS2_STATUS_PORT) & 0x21) == 0x21) {
+        mouse_process_byte(inb(PS2_DATA_PORT));
+    }
+    irq_restore(flags);
+}
+
+// Keep the cursor on the visible framebuffer
+static void mouse_clamp_position(void) {
+    fb_info_t info;
+    int16_t max_x = 639;
+    int16_t max_y = 479;
+    
+    if (fb_get_info(&info) == 0 && info.width > 0 && info.height > 0) {
+        max_x = (int16_t)(info.width - 1);
+        max_y = (int16_t)(info.height - 1);
+    }
+    
+    if (mouse_data.x < 0) mouse_data.x = 0;
+    if (mouse_data.y < 0) mouse_data.y = 0;
+    if (mouse_data.x > max_x) mouse_data.x = max_x;
+    if (mouse_data.y > max_y) mouse_data.y = max_y;
 }
 
 // Device-specific functions
@@ -330,14 +426,31 @@ static int mouse_init(void* device) {
         return -1;
     }
     
-    // Initialize mouse data
-    mouse_data.x = 320;  // Center of 640x480 screen
-    mouse_data.y = 240;
+    // Initialize mouse data, starting at the center of the screen
+    fb_info_t info;
+    if (fb_get_info(&info) == 0 && info.width > 0 && info.height > 0) {
+        mouse_data.x = (int16_t)(info.width / 2);
+        mouse_data.y = (int16_t)(info.height / 2);
+    } else {
+        mouse_data.x = 320;
+        mouse_data.y = 240;
+    }
     mouse_data.z = 0;
     mouse_data.buttons = 0;
+    mouse_data.irq_buttons = 0;
     mouse_data.packet_index = 0;
+    mouse_data.motion_count = 0;
+    mouse_data.byte_head = 0;
+    mouse_data.byte_tail = 0;
+    wait_queue_init(&mouse_data.waiters);
+    
+    // Take IRQ12; this also unmasks the cascade on the master PIC
+    hal_device_t* dev = (hal_device_t*)device;
+    tasklet_init(&mouse_tasklet, mouse_tasklet_func, NULL);
+    interrupt_register_handler(MOUSE_IRQ_VECTOR, mouse_irq_handler);
+    dev->mode = HAL_MODE_INTERRUPT;
     
-    terminal_writestring("HAL Mouse initialized\n");
+    terminal_writestring("HAL Mouse initialized in interrupt mode\n");
     
     return 0;
 }
@@ -356,9 +469,6 @@ static int mouse_read(void* device, void* buffer, uint32_t size) {
         return -1;
     }
     
-    // Poll for new data
-    mouse_poll();
-    
     // Copy current state
     state->x = mouse_data.x;
     state->y = mouse_data.y;
@@ -393,6 +503,7 @@ static int mouse_ioctl(void* device, uint32_t request, void* arg) {
             if (pos) {
                 mouse_data.x = pos->x;
                 mouse_data.y = pos->y;
+                mouse_clamp_position();
                 return 0;
             }
             break;
@@ -447,9 +558,61 @@ int mouse_unregister_handler(mouse_event_handler_t handler) {
     return mouse_ioctl(&mouse_device, MOUSE_IOCTL_UNREGISTER_HANDLER, handler);
 }
 
+// Deliver the motion coalesced since the last call. Meant to be called
+// once per frame: handlers see one event per button state instead of
+// one per packet.
 void mouse_update(void) {
-    // Poll for new mouse data
+    mouse_motion_t motion[MOUSE_MOTION_SLOTS];
+    
     mouse_poll();
+    
+    // Take the pending slots in one go so the tasklet can start a new batch
+    uint32_t flags = irq_save();
+    uint8_t count = mouse_data.motion_count;
+    for (uint8_t i = 0; i < count; i++) {
+        motion[i] = mouse_data.motion[i];
+    }
+    mouse_data.motion_count = 0;
+    irq_restore(flags);
+    
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t prev_buttons = mouse_data.buttons;
+        
+        // Update mouse position
+        mouse_data.x += motion[i].dx;
+        mouse_data.y += motion[i].dy;
+        mouse_data.z += motion[i].dz;
+        mouse_clamp_position();
+        mouse_data.buttons = motion[i].buttons;
+        
+        // Call event handlers
+        mouse_event_t event = {
+            .x = mouse_data.x,
+            .y = mouse_data.y,
+            .z = mouse_data.z,
+            .dx = motion[i].dx,
+            .dy = motion[i].dy,
+            .dz = motion[i].dz,
+            .buttons = mouse_data.buttons,
+            .prev_buttons = prev_buttons
+        };
+        
+        for (uint8_t h = 0; h < mouse_event_handler_count; h++) {
+            if (mouse_event_handlers[h] != NULL) {
+                mouse_event_handlers[h](&event);
+            }
+        }
+        mouse_data.events++;
+    }
+}
+
+int mouse_pending(void) {
+    mouse_poll();
+    return mouse_data.motion_count != 0;
+}
+
+wait_queue_t* mouse_wait_queue(void) {
+    return mouse_device.mode == HAL_MODE_INTERRUPT ? &mouse_data.waiters : NULL;
 }
 
 // Initialize and register mouse device
@@ -466,15 +629,12 @@ int hal_mouse_init(void) {
     mouse_device.write = mouse_write;
     mouse_device.ioctl = mouse_ioctl;
     
-    // Register with HAL
+    // Register with HAL; this runs mouse_init()
     int result = hal_register_device(&mouse_device);
     if (result != 0) {
         terminal_writestring("Failed to register mouse device\n");
         return result;
     }
     
-    // Initialize the device
-    result = mouse_init(&mouse_device);
-    
-    return result;
+    return 0;
 }
\ No newline at end of file
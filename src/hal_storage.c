@@ -633,7 +633,7 @@ int hal_storage_init(void) {
     storage_data.storage_type = STORAGE_TYPE_RAM_DISK;
     storage_data.device_number = 0;
     storage_data.sector_size = 512;
-    storage_data.total_sectors = 8192;  // 4MB RAM disk (512 * 8192)
+    storage_data.total_sectors = 2048;  // 1MB RAM disk, well within the kernel heap
     
     // Set functions
     storage_device.init = storage_init;
@@ -1,34 +1,158 @@
 // src/hal_timer.c
 #include "hal.h"
+#include "hal_timer.h"
 #include "terminal.h"
+#include "stdio.h"
 #include "scheduler.h"
+#include "interrupts.h"
+#include "cpu.h"
+#include "hrtimer.h"
+#include "vdso.h"
 
 // Use the existing timer_ticks from interrupts.c instead of defining a new one
 extern volatile uint32_t timer_ticks;
 
+// IRQ0 vector after the PIC remap
+#define TIMER_IRQ_VECTOR 32
+
+// Ticks to measure the TSC over during calibration (~50 ms)
+#define TIMER_CALIBRATE_MS 50
+
+// Fixed point shift of the cycles-to-nanoseconds multiplier
+#define TIMER_NS_SHIFT 24
+
+// Slowest TSC the multiplier fits 32 bits for: (10^6 << 24) / 3907 kHz
+#define TIMER_TSC_MIN_KHZ 3907
+
 // Callback function pointer
 static void (*timer_callback)(void) = 0;
 
 // Timer device private data
 typedef struct {
-    uint32_t frequency;
-    uint32_t counter;
+    uint32_t frequency;              // Tick rate in Hz
+    uint32_t divisor;                // PIT reload value
+    uint32_t counter;                // Ticks since boot
+    uint32_t period_ns;              // Length of one tick
+    uint64_t tick_ns;                // Tick clock, advanced by period_ns per tick
+    uint32_t tsc_khz;                // Calibrated TSC rate (0 if none)
+    uint32_t ns_mult;                // Cycles to ns multiplier
+    uint64_t tsc_base;               // TSC at calibration
 } timer_data_t;
 
 // Local timer device
 static timer_data_t timer_data = {0};
 static hal_device_t timer_device = {0};
 
+// Program PIT channel 0 as a rate generator
+static void pit_program(timer_data_t* data, uint32_t hz) {
+    uint32_t divisor = PIT_BASE_FREQUENCY / hz;
+    
+    uint32_t flags = irq_save();
+    outb(0x43, 0x34);  // Channel 0, lobyte/hibyte, mode 2
+    outb(0x40, divisor & 0xFF);
+    outb(0x40, (divisor >> 8) & 0xFF);
+    data->frequency = hz;
+    data->divisor = divisor;
+    data->period_ns = (uint32_t)cpu_div64_32((uint64_t)divisor * 1000000000ULL,
+                                             PIT_BASE_FREQUENCY, NULL);
+    irq_restore(flags);
+}
+
+// Copy the clock calibration to the vDSO page
+static void timer_publish_clock(timer_data_t* data) {
+    vdso_set_clock(data->tsc_khz, data->ns_mult, TIMER_NS_SHIFT, data->tsc_base, data->frequency);
+}
+
+// IRQ0 handler
+static void timer_irq_handler(struct regs* r) {
+    timer_ticks++;
+    timer_data.counter++;
+    timer_data.tick_ns += timer_data.period_ns;
+    vdso_tick(timer_ticks, hal_timer_get_ns());
+    
+    // Expire high-resolution timers when no one-shot source is armed
+    hrtimer_tick();
+    
+    // Call callback if registered
+    if (timer_callback) {
+        timer_callback();
+    }
+}
+
+// Wait for the next tick edge; returns 0 if no tick arrives
+static int timer_wait_tick(void) {
+    uint32_t start = timer_ticks;
+    
+    for (uint32_t guard = 0; guard < 100000000; guard++) {
+        if (timer_ticks != start) {
+            return 1;
+        }
+        asm volatile("pause");
+    }
+    return 0;
+}
+
+// Calibrate the TSC against IRQ0
+static void timer_calibrate_tsc(timer_data_t* data) {
+    data->tsc_khz = 0;
+    
+    if (!(cpu_features() & CPU_FEATURE_TSC)) {
+        terminal_writestring("HAL Timer: no TSC, using tick resolution\n");
+        return;
+    }
+    
+    uint32_t ticks = (TIMER_CALIBRATE_MS * data->frequency + 999) / 1000;
+    
+    if (!timer_wait_tick()) {
+        terminal_writestring("HAL Timer: IRQ0 not firing, TSC not calibrated\n");
+        return;
+    }
+    uint64_t start = cpu_read_tsc();
+    
+    for (uint32_t i = 0; i < ticks; i++) {
+        if (!timer_wait_tick()) {
+            return;
+        }
+    }
+    uint64_t cycles = cpu_read_tsc() - start;
+    
+    // Elapsed time is ticks * divisor / PIT_BASE_FREQUENCY seconds
+    data->tsc_khz = (uint32_t)cpu_div64_32(cycles * PIT_BASE_FREQUENCY,
+                                           ticks * data->divisor * 1000, NULL);
+    if (data->tsc_khz < TIMER_TSC_MIN_KHZ) {
+        data->tsc_khz = 0;
+        return;
+    }
+    
+    data->ns_mult = (uint32_t)cpu_div64_32((uint64_t)1000000 << TIMER_NS_SHIFT, data->tsc_khz, NULL);
+    data->tsc_base = cpu_read_tsc();
+}
+
 // Device-specific functions
 static int timer_init(void* device) {
     hal_device_t* dev = (hal_device_t*)device;
     timer_data_t* data = (timer_data_t*)dev->private_data;
     
     // Initialize data
-    data->frequency = 100; // 100Hz default (10ms)
     data->counter = 0;
+    data->tick_ns = 0;
+    pit_program(data, HZ);
     
-    terminal_writestring("HAL Timer initialized in polling mode\n");
+    // Take over IRQ0 and let it run
+    interrupt_register_handler(TIMER_IRQ_VECTOR, timer_irq_handler);
+    dev->mode = HAL_MODE_INTERRUPT;
+    
+    timer_calibrate_tsc(data);
+    timer_publish_clock(data);
+    
+    terminal_printf("HAL Timer initialized: IRQ0 at %d Hz", data->frequency);
+    if (data->tsc_khz) {
+        terminal_printf(", TSC %d MHz", data->tsc_khz / 1000);
+    }
+    terminal_writestring("\n");
+    
+    // One-shot timers need the calibrated TSC clock
+    hrtimer_subsystem_init();
     
     return 0;
 }
@@ -53,13 +177,9 @@ static int timer_write(void* device, const void* buffer, uint32_t size) {
 }
 
 static int timer_ioctl(void* device, uint32_t request, void* arg) {
-    hal_device_t* dev = (hal_device_t*)device;
-    timer_data_t* data = (timer_data_t*)dev->private_data;
-    
     switch (request) {
         case 0: // Set frequency
-            data->frequency = *(uint32_t*)arg;
-            return 0;
+            return hal_timer_set_frequency(*(uint32_t*)arg);
             
         case 1: // Register callback
             timer_callback = (void (*)(void))arg;
@@ -70,41 +190,60 @@ static int timer_ioctl(void* device, uint32_t request, void* arg) {
     }
 }
 
-// Poll timer based on PIT counter
-void hal_timer_poll(void) {
-    // Read timer status - we can check port 0x40 to poll the timer
-    static uint32_t last_time = 0;
-    uint32_t current_time = 0;
-    
-    // Read the timer counter from PIT channel 0
-    outb(0x43, 0x00);  // Command: channel 0, read counter
-    current_time = inb(0x40);   // Read low byte
-    current_time |= inb(0x40) << 8;  // Read high byte
-    
-    // Timer counts down, so we can detect a change
-    if (current_time != last_time) {
-        last_time = current_time;
-        timer_ticks++;
-        
-        // Call callback if registered
-        if (timer_callback) {
-            timer_callback();
-        }
-    }
-}
-
 // HAL timer interface functions
 uint32_t hal_timer_get_ticks(void) {
     return timer_ticks;
 }
 
-void hal_timer_sleep(uint32_t ms) {
-    uint32_t start_ticks = timer_ticks;
-    uint32_t target_ticks = start_ticks + (ms / 10) + 1;
+// Monotonic clock in nanoseconds
+uint64_t hal_timer_get_ns(void) {
+    if (timer_data.tsc_khz) {
+        return hal_timer_tsc_to_ns(cpu_read_tsc() - timer_data.tsc_base);
+    }
     
-    while (timer_ticks < target_ticks) {
-        hal_timer_poll();
+    // No TSC: fall back to tick resolution. Each tick adds the period it
+    // was programmed with, so a rate change does not move the clock.
+    uint32_t flags = irq_save();
+    uint64_t ns = timer_data.tick_ns;
+    irq_restore(flags);
+    return ns;
+}
+
+uint32_t hal_timer_get_frequency(void) {
+    return timer_data.frequency ? timer_data.frequency : HZ;
+}
+
+int hal_timer_set_frequency(uint32_t hz) {
+    if (hz < HAL_TIMER_HZ_MIN) {
+        hz = HAL_TIMER_HZ_MIN;
+    } else if (hz > HAL_TIMER_HZ_MAX) {
+        hz = HAL_TIMER_HZ_MAX;
     }
+    
+    pit_program(&timer_data, hz);
+    timer_publish_clock(&timer_data);
+    return 0;
+}
+
+uint32_t hal_timer_ms_to_ticks(uint32_t ms) {
+    uint32_t hz = hal_timer_get_frequency();
+    return (uint32_t)cpu_div64_32((uint64_t)ms * hz + 999, 1000, NULL);
+}
+
+uint32_t hal_timer_tsc_khz(void) {
+    return timer_data.tsc_khz;
+}
+
+uint64_t hal_timer_tsc_to_ns(uint64_t cycles) {
+    return cpu_mul_u64_u32_shr(cycles, timer_data.ns_mult, TIMER_NS_SHIFT);
+}
+
+void hal_timer_sleep(uint32_t ms) {
+    hrtimer_sleep_ns(ms * NSEC_PER_MSEC);
+}
+
+void hal_timer_usleep(uint32_t us) {
+    hrtimer_sleep_ns(us * NSEC_PER_USEC);
 }
 
 void hal_timer_register_callback(void (*callback)(void)) {
@@ -127,4 +266,4 @@ int hal_timer_init(void) {
     
     // Register with HAL
     return hal_register_device(&timer_device);
-}
\ No newline at end of file
+}
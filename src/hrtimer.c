@@ -0,0 +1,233 @@
+// src/hrtimer.c
+#include "hrtimer.h"
+#include "hal_timer.h"
+#include "interrupts.h"
+#include "lapic.h"
+#include "softirq.h"
+#include "terminal.h"
+#include "stdio.h"
+#include <stddef.h>
+
+// Min-heap of armed timers, ordered by deadline
+static hrtimer_t* heap[HRTIMER_MAX];
+static uint32_t heap_count = 0;
+
+// Clock event source
+static int use_lapic = 0;
+
+// Expected worst case for one pass over expired timers
+#define HRTIMER_SOFTIRQ_BUDGET_NS 200000
+
+// Statistics
+static uint32_t timers_fired = 0;
+static uint32_t timers_dropped = 0;
+static uint32_t reprograms = 0;
+
+// Place a timer in a heap slot
+static inline void heap_set(uint32_t index, hrtimer_t* timer) {
+    heap[index] = timer;
+    timer->index = index;
+}
+
+static void heap_sift_up(uint32_t index) {
+    hrtimer_t* timer = heap[index];
+    
+    while (index > 0) {
+        uint32_t parent = (index - 1) / 2;
+        if (heap[parent]->expires <= timer->expires) {
+            break;
+        }
+        heap_set(index, heap[parent]);
+        index = parent;
+    }
+    heap_set(index, timer);
+}
+
+static void heap_sift_down(uint32_t index) {
+    hrtimer_t* timer = heap[index];
+    
+    while (1) {
+        uint32_t child = index * 2 + 1;
+        if (child >= heap_count) {
+            break;
+        }
+        if (child + 1 < heap_count && heap[child + 1]->expires < heap[child]->expires) {
+            child++;
+        }
+        if (timer->expires <= heap[child]->expires) {
+            break;
+        }
+        heap_set(index, heap[child]);
+        index = child;
+    }
+    heap_set(index, timer);
+}
+
+// Remove a timer from the heap (interrupts must be disabled)
+static void heap_remove(hrtimer_t* timer) {
+    uint32_t index = timer->index;
+    hrtimer_t* last = heap[--heap_count];
+    
+    timer->index = HRTIMER_INACTIVE;
+    if (last == timer) {
+        return;
+    }
+    
+    heap_set(index, last);
+    heap_sift_up(index);
+    heap_sift_down(last->index);
+}
+
+// Program the clock event for the earliest deadline
+static void hrtimer_reprogram(uint64_t now) {
+    if (!use_lapic) {
+        return;
+    }
+    
+    if (heap_count == 0) {
+        lapic_timer_stop();
+        return;
+    }
+    
+    uint64_t expires = heap[0]->expires;
+    lapic_timer_oneshot_ns(expires > now ? expires - now : 0);
+    reprograms++;
+}
+
+// SOFTIRQ_HRTIMER action: pop and run every expired timer, then re-arm
+// the clock event. Callbacks run with interrupts enabled.
+static void hrtimer_softirq(void) {
+    while (1) {
+        uint32_t flags = irq_save();
+        uint64_t now = hal_timer_get_ns();
+        
+        if (heap_count == 0 || heap[0]->expires > now) {
+            hrtimer_reprogram(now);
+            irq_restore(flags);
+            return;
+        }
+        
+        hrtimer_t* timer = heap[0];
+        heap_remove(timer);
+        timers_fired++;
+        irq_restore(flags);
+        
+        if (timer->function) {
+            timer->function(timer);
+        }
+    }
+}
+
+// Local APIC timer interrupt
+static void hrtimer_interrupt(struct regs* r) {
+    lapic_eoi();
+    raise_softirq(SOFTIRQ_HRTIMER);
+}
+
+void hrtimer_subsystem_init(void) {
+    open_softirq(SOFTIRQ_HRTIMER, "hrtimer", hrtimer_softirq, HRTIMER_SOFTIRQ_BUDGET_NS);
+    
+    if (lapic_init() == 0 && lapic_timer_init(LAPIC_TIMER_VECTOR) == 0) {
+        interrupt_register_handler(LAPIC_TIMER_VECTOR, hrtimer_interrupt);
+        use_lapic = 1;
+        terminal_printf("hrtimer: LAPIC one-shot, %d kHz\n", lapic_timer_khz());
+    } else {
+        terminal_writestring("hrtimer: no LAPIC timer, using PIT tick resolution\n");
+    }
+    
+    // Timers armed before now still need their first event
+    uint32_t flags = irq_save();
+    hrtimer_reprogram(hal_timer_get_ns());
+    irq_restore(flags);
+}
+
+void hrtimer_init(hrtimer_t* timer, hrtimer_func_t function, void* data) {
+    timer->expires = 0;
+    timer->function = function;
+    timer->data = data;
+    timer->index = HRTIMER_INACTIVE;
+}
+
+int hrtimer_start(hrtimer_t* timer, uint64_t expires_ns) {
+    uint32_t flags = irq_save();
+    
+    if (hrtimer_active(timer)) {
+        heap_remove(timer);
+    }
+    
+    if (heap_count >= HRTIMER_MAX) {
+        timers_dropped++;
+        irq_restore(flags);
+        return -1;
+    }
+    
+    timer->expires = expires_ns;
+    heap_set(heap_count++, timer);
+    heap_sift_up(timer->index);
+    
+    // Only a new earliest deadline moves the clock event
+    if (timer->index == 0) {
+        hrtimer_reprogram(hal_timer_get_ns());
+    }
+    
+    irq_restore(flags);
+    return 0;
+}
+
+int hrtimer_start_relative(hrtimer_t* timer, uint64_t delay_ns) {
+    return hrtimer_start(timer, hal_timer_get_ns() + delay_ns);
+}
+
+int hrtimer_cancel(hrtimer_t* timer) {
+    uint32_t flags = irq_save();
+    int was_active = hrtimer_active(timer);
+    
+    if (was_active) {
+        heap_remove(timer);
+    }
+    
+    irq_restore(flags);
+    return was_active;
+}
+
+// Called from the PIT interrupt on every tick
+void hrtimer_tick(void) {
+    // The APIC path also lands here, as a backstop for a lost one-shot
+    if (heap_count > 0 && heap[0]->expires <= hal_timer_get_ns()) {
+        raise_softirq(SOFTIRQ_HRTIMER);
+    }
+}
+
+// Sleep timer callback: flag the sleeper
+static void hrtimer_sleep_expired(hrtimer_t* timer) {
+    *(volatile int*)timer->data = 1;
+}
+
+void hrtimer_sleep_ns(uint64_t ns) {
+    volatile int done = 0;
+    hrtimer_t timer;
+    
+    hrtimer_init(&timer, hrtimer_sleep_expired, (void*)&done);
+    if (hrtimer_start_relative(&timer, ns) != 0) {
+        // Heap full: fall back to checking the clock on every interrupt
+        uint64_t deadline = hal_timer_get_ns() + ns;
+        while (hal_timer_get_ns() < deadline) {
+            irq_enable_and_halt();
+        }
+        return;
+    }
+    
+    while (!done) {
+        uint32_t flags = irq_save();
+        if (!done) {
+            irq_enable_and_halt();
+        }
+        irq_restore(flags);
+    }
+}
+
+void hrtimer_print_stats(void) {
+    terminal_printf("hrtimer: source %s, %d armed, %d fired, %d reprograms, %d dropped\n",
+                    use_lapic ? "LAPIC one-shot" : "PIT tick",
+                    heap_count, timers_fired, reprograms, timers_dropped);
+}
@@ -4,8 +4,33 @@
 #include "stdio.h"
 #include "io.h"
 #include "string.h"
+#include "interrupts.h"
+#include "hal_timer.h"
 #include <stdarg.h>  // Added for va_list
 
+// Latency histograms: log2 buckets of TSC cycles, per PIC line
+#define LATENCY_IRQS    16
+#define LATENCY_BUCKETS 32
+
+typedef struct {
+    uint32_t samples;
+    uint32_t entry_max;                       // Stub entry -> handler start
+    uint32_t handler_max;                     // Handler start -> EOI
+    uint32_t entry_hist[LATENCY_BUCKETS];
+    uint32_t handler_hist[LATENCY_BUCKETS];
+} irq_latency_t;
+
+static irq_latency_t irq_latency[LATENCY_IRQS];
+
+// Interrupts-off tracking; the open section lives in interrupts.h
+uint32_t irqoff_tracking = 0;
+uint64_t irqoff_start_tsc = 0;
+uint32_t irqoff_start_site = 0;
+static uint32_t irqoff_sections = 0;
+static uint32_t irqoff_max = 0;
+static uint32_t irqoff_max_site = 0;
+static uint32_t irqoff_hist[LATENCY_BUCKETS];
+
 // Log buffer for diagnostics
 #define DIAG_LOG_SIZE 4096
 static char diag_log_buffer[DIAG_LOG_SIZE];
@@ -719,4 +744,107 @@ void interrupt_diag_test_interrupts(void) {
 // Get the diagnostics log buffer
 const char* interrupt_diag_get_log(void) {
     return diag_log_buffer;
-}
\ No newline at end of file
+}
+
+// Bucket k holds values in [2^k, 2^(k+1)); anything past 32 bits saturates
+static uint32_t latency_bucket(uint64_t cycles) {
+    if (cycles >> 32) {
+        return LATENCY_BUCKETS - 1;
+    }
+    uint32_t c = (uint32_t)cycles;
+    return c ? 31 - __builtin_clz(c) : 0;
+}
+
+static uint32_t latency_clamp(uint64_t cycles) {
+    return (cycles >> 32) ? 0xFFFFFFFF : (uint32_t)cycles;
+}
+
+// Called from interrupt_dispatch() with interrupts off
+void interrupt_diag_record_irq(uint32_t irq, uint64_t entry_cycles, uint64_t handler_cycles) {
+    if (irq >= LATENCY_IRQS) {
+        return;
+    }
+    
+    irq_latency_t* lat = &irq_latency[irq];
+    uint32_t entry = latency_clamp(entry_cycles);
+    uint32_t handler = latency_clamp(handler_cycles);
+    
+    lat->samples++;
+    lat->entry_hist[latency_bucket(entry_cycles)]++;
+    lat->handler_hist[latency_bucket(handler_cycles)]++;
+    if (entry > lat->entry_max) lat->entry_max = entry;
+    if (handler > lat->handler_max) lat->handler_max = handler;
+}
+
+// Called by irq_restore()/irq_enable_and_halt() just before interrupts
+// come back on
+void irqoff_section_end(void) {
+    uint64_t cycles = cpu_read_tsc() - irqoff_start_tsc;
+    uint32_t clamped = latency_clamp(cycles);
+    
+    irqoff_start_tsc = 0;
+    irqoff_sections++;
+    irqoff_hist[latency_bucket(cycles)]++;
+    if (clamped > irqoff_max) {
+        irqoff_max = clamped;
+        irqoff_max_site = irqoff_start_site;
+    }
+}
+
+void interrupt_diag_reset_latency(void) {
+    uint32_t flags = irq_save();
+    memset(irq_latency, 0, sizeof(irq_latency));
+    memset(irqoff_hist, 0, sizeof(irqoff_hist));
+    irqoff_sections = 0;
+    irqoff_max = 0;
+    irqoff_max_site = 0;
+    irq_restore(flags);
+}
+
+// Print a histogram as "2^k: count" for the non-empty buckets
+static void print_latency_hist(const char* label, const uint32_t* hist) {
+    terminal_printf("  %s:", label);
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        if (hist[b]) {
+            terminal_printf(" 2^%d:%d", b, hist[b]);
+        }
+    }
+    terminal_writestring("\n");
+}
+
+void interrupt_diag_print_latency(void) {
+    if (!interrupt_have_tsc) {
+        terminal_writestring("Interrupt latency: no TSC, sampling disabled\n");
+        return;
+    }
+    
+    // Snapshot so IRQs landing mid-print do not skew the numbers
+    static irq_latency_t snap[LATENCY_IRQS];
+    static uint32_t off_hist[LATENCY_BUCKETS];
+    uint32_t flags = irq_save();
+    memcpy(snap, irq_latency, sizeof(snap));
+    memcpy(off_hist, irqoff_hist, sizeof(off_hist));
+    uint32_t sections = irqoff_sections;
+    uint32_t off_max = irqoff_max;
+    uint32_t off_site = irqoff_max_site;
+    irq_restore(flags);
+    
+    terminal_writestring("Interrupt latency (TSC cycles, log2 buckets):\n");
+    for (int irq = 0; irq < LATENCY_IRQS; irq++) {
+        irq_latency_t* lat = &snap[irq];
+        if (lat->samples == 0) {
+            continue;
+        }
+        
+        terminal_printf("IRQ%d: %d samples, entry max %d ns, handler max %d ns\n",
+                        irq, lat->samples,
+                        (uint32_t)hal_timer_tsc_to_ns(lat->entry_max),
+                        (uint32_t)hal_timer_tsc_to_ns(lat->handler_max));
+        print_latency_hist("entry  ", lat->entry_hist);
+        print_latency_hist("handler", lat->handler_hist);
+    }
+    
+    terminal_printf("Interrupts-off sections: %d, longest %d ns at 0x%x\n",
+                    sections, (uint32_t)hal_timer_tsc_to_ns(off_max), off_site);
+    print_latency_hist("irqoff ", off_hist);
+}
@@ -7,6 +7,12 @@
 #include "terminal.h"
 #include "stdio.h"
 #include "interrupt_diagnostics.h"
+#include "trace.h"
+#include "cpu.h"
+#include "softirq.h"
+#include "uaccess.h"
+#include "memory.h"
+#include "elf.h"
 
 // IDT entry structure
 struct idt_entry {
@@ -28,20 +34,22 @@ struct idt_ptr {
 static struct idt_entry idt[IDT_SIZE] __attribute__((aligned(8)));
 static struct idt_ptr idtp;
 
-// Timer ticks counter
-volatile uint32_t timer_ticks = 0;
+// PIC-routed vectors after the remap
+#define IRQ_BASE_VECTOR 32
+#define IRQ_LAST_VECTOR 47
 
-// Handler function pointers
-static void (*interrupt_handlers[IDT_SIZE])(void) = {0};
+// Handler function pointers, indexed by vector
+static interrupt_handler_t interrupt_handlers[IDT_SIZE] = {0};
 
-// Default handler for unhandled interrupts
-static void default_handler(void) {
-    terminal_writestring("Unhandled interrupt!\n");
-    
-    // Send EOI to PIC for IRQs
-    outb(0x20, 0x20); // Master PIC
-    outb(0xA0, 0x20); // Slave PIC
-}
+// Per-vector counters; read them with interrupt_get_stat()
+static interrupt_stat_t interrupt_stats[IDT_SIZE];
+static uint32_t spurious_irqs = 0;
+
+// Read by isr_common before it samples the TSC
+uint32_t interrupt_have_tsc = 0;
+
+// Stub addresses from interrupt_stubs_new.asm
+extern uint32_t isr_stub_table[IDT_SIZE];
 
 // Helper function to set an IDT gate
 static void idt_set_gate(uint8_t num, uint32_t base, uint16_t sel, uint8_t flags) {
@@ -88,79 +96,136 @@ static const char* exception_names[] = {
     "Reserved"
 };
 
-// Exception handlers
-static void exception_handler_common(void) {
-    uint32_t int_no;
-
-    // Get interrupt number from stack
-    asm volatile("mov 8(%%ebp), %0" : "=r"(int_no));
-
-    if (int_no < 32) {
-        terminal_writestring("EXCEPTION: ");
-        terminal_writestring(exception_names[int_no]);
-        terminal_writestring("\n");
-        
-        // Capture diagnostic information
-        cpu_state_t state;
-        interrupt_diag_capture_state(&state);
-        interrupt_diag_print_state(&state);
-        
-        // Halt the system
-        terminal_writestring("System halted\n");
-        for (;;) {
-            asm volatile("hlt");
-        }
+// Report a CPU exception nobody handled and halt
+static void exception_handler_common(struct regs* r) {
+    // First touch of a demand-paged user page
+    if (r->int_no == 14 && memory_fault_handler(cpu_read_cr2(), r->err_code)) {
+        return;
+    }
+    
+    // A user copy touched a bad address; let it return SYSCALL_EFAULT
+    if ((r->int_no == 13 || r->int_no == 14) && uaccess_fixup(r)) {
+        return;
+    }
+    
+    // A program faulted: end it rather than the system
+    elf_exec_fault(r);
+    
+    terminal_writestring("EXCEPTION: ");
+    terminal_writestring(exception_names[r->int_no]);
+    terminal_printf(" (err=0x%x, eip=0x%x, cs=0x%x)\n", r->err_code, r->eip, r->cs);
+    
+    // Capture diagnostic information
+    cpu_state_t state;
+    interrupt_diag_capture_state(&state);
+    interrupt_diag_print_state(&state);
+    
+    // Halt the system
+    terminal_writestring("System halted\n");
+    for (;;) {
+        asm volatile("cli; hlt");
     }
 }
 
-// IRQ common handler
-static void irq_handler_common(void) {
-    uint32_t int_no;
-
-    // Get interrupt number from stack
-    asm volatile("mov 8(%%ebp), %0" : "=r"(int_no));
-
-    // Calculate IRQ number
-    uint32_t irq = int_no - 32;
+// Read the in-service register of a PIC
+static uint8_t pic_read_isr(uint16_t command_port) {
+    outb(command_port, 0x0B);
+    return inb(command_port);
+}
 
-    // Check if we have a handler for this IRQ
-    if (interrupt_handlers[int_no] != 0) {
-        // Call the handler
-        interrupt_handlers[int_no]();
-    } else {
-        // No handler registered
-        terminal_printf("Unhandled IRQ%d\n", irq);
+// IRQ7 and IRQ15 can fire without a real request; the ISR bit tells
+static int irq_is_spurious(uint32_t irq) {
+    if (irq == 7) {
+        return !(pic_read_isr(0x20) & 0x80);
+    }
+    if (irq == 15 && !(pic_read_isr(0xA0) & 0x80)) {
+        // The master still saw the cascade line and wants its EOI
+        outb(0x20, 0x20);
+        return 1;
     }
+    return 0;
+}
 
+// Single entry point for every vector (called from isr_common)
+void interrupt_dispatch(struct regs* r) {
+    uint32_t int_no = r->int_no & 0xFF;
+    uint64_t entry = ((uint64_t)r->entry_tsc_hi << 32) | r->entry_tsc_lo;
+    int is_irq = int_no >= IRQ_BASE_VECTOR && int_no <= IRQ_LAST_VECTOR;
+    uint32_t irq = int_no - IRQ_BASE_VECTOR;
+    
+    if (is_irq && (irq == 7 || irq == 15) && irq_is_spurious(irq)) {
+        spurious_irqs++;
+        return;
+    }
+    
+    trace_event(TRACE_EV_IRQ_ENTRY, int_no, 0);
+    
+    uint64_t handler_start = interrupt_have_tsc ? cpu_read_tsc() : 0;
+    
+    interrupt_handler_t handler = interrupt_handlers[int_no];
+    if (handler) {
+        handler(r);
+    } else if (int_no < 32) {
+        exception_handler_common(r);
+    }
+    // Unhandled IRQs and software vectors are only counted
+    
     // Send EOI to PIC
-    if (irq >= 8) {
-        // Send EOI to slave PIC
-        outb(0xA0, 0x20);
+    if (is_irq) {
+        if (irq >= 8) {
+            // Send EOI to slave PIC
+            outb(0xA0, 0x20);
+        }
+        
+        // Send EOI to master PIC
+        outb(0x20, 0x20);
     }
     
-    // Send EOI to master PIC
-    outb(0x20, 0x20);
+    trace_event(TRACE_EV_IRQ_EXIT, int_no, 0);
+    
+    interrupt_stat_t* stat = &interrupt_stats[int_no];
+    stat->count++;
+    if (interrupt_have_tsc) {
+        uint64_t eoi = cpu_read_tsc();
+        stat->cycles += eoi - entry;
+        if (is_irq) {
+            interrupt_diag_record_irq(irq, handler_start - entry, eoi - handler_start);
+        }
+    }
+    
+    // Bottom halves raised by device interrupts run on the way out
+    if (int_no >= 32) {
+        softirq_irq_exit();
+    }
 }
 
-// Timer (IRQ0) handler
-static void timer_handler(void) {
-    timer_ticks++;
+int interrupt_get_stat(uint32_t vector, interrupt_stat_t* stat) {
+    if (vector >= IDT_SIZE || !stat) {
+        return -1;
+    }
+    
+    // The 64-bit cycle total is not updated atomically
+    uint32_t flags = irq_save();
+    *stat = interrupt_stats[vector];
+    irq_restore(flags);
+    return 0;
 }
 
-// Keyboard (IRQ1) handler
-static void keyboard_handler(void) {
-    // Read the scancode from the keyboard
-    uint8_t scancode = inb(0x60);
-    
-    // Process the scancode here
-    // For diagnostics, just print the scancode
-    terminal_printf("Keyboard: Scancode 0x%x\n", scancode);
+uint32_t interrupt_spurious_count(void) {
+    return spurious_irqs;
 }
 
-// IRQ handlers need to be defined in assembly
-extern void irq0_handler(void);
-extern void irq1_handler(void);
-extern void exception_handler(void);
+void interrupt_reset_stats(void) {
+    uint32_t flags = irq_save();
+    for (int i = 0; i < IDT_SIZE; i++) {
+        interrupt_stats[i].count = 0;
+        interrupt_stats[i].cycles = 0;
+    }
+    spurious_irqs = 0;
+    irq_restore(flags);
+    
+    interrupt_diag_reset_latency();
+}
 
 // Initialize the IDT with proper handlers
 static void init_idt(void) {
@@ -168,14 +233,16 @@ static void init_idt(void) {
     idtp.limit = (sizeof(struct idt_entry) * IDT_SIZE) - 1;
     idtp.base = (uint32_t)&idt;
     
-    // Clear out the entire IDT
+    // Every vector gets its own stub; dispatch happens in C
     for (int i = 0; i < IDT_SIZE; i++) {
-        idt_set_gate(i, (uint32_t)exception_handler, 0x08, 0x8E);
+        idt_set_gate(i, isr_stub_table[i], 0x08, 0x8E);
     }
     
-    // Setup IRQ handlers (we'll map IRQs 0-15 to interrupts 32-47)
-    idt_set_gate(32, (uint32_t)irq0_handler, 0x08, 0x8E);
-    idt_set_gate(33, (uint32_t)irq1_handler, 0x08, 0x8E);
+    // Cycle accounting and latency sampling need the TSC
+    interrupt_have_tsc = (cpu_features() & CPU_FEATURE_TSC) != 0;
+#if CONFIG_IRQOFF_TRACK
+    irqoff_tracking = interrupt_have_tsc;
+#endif
     
     // Load IDT
     asm volatile("lidt %0" : : "m"(idtp));
@@ -207,7 +274,7 @@ static void init_pic(void) {
 }
 
 // Register an interrupt handler
-void interrupt_register_handler(uint8_t num, void (*handler)(void)) {
+void interrupt_register_handler(uint8_t num, interrupt_handler_t handler) {
     interrupt_handlers[num] = handler;
     
     // If this is an IRQ, update the PIC mask
@@ -235,6 +302,11 @@ void interrupt_register_handler(uint8_t num, void (*handler)(void)) {
     }
 }
 
+void interrupt_set_user_gate(uint8_t num) {
+    // Present, DPL 3, 32-bit interrupt gate
+    idt[num].type_attr = 0xEE;
+}
+
 // Initialize interrupts
 void interrupts_init_proper(void) {
     // Initialize the IDT
@@ -243,9 +315,7 @@ void interrupts_init_proper(void) {
     // Initialize the PIC
     init_pic();
     
-    // Register handlers
-    interrupt_register_handler(32, timer_handler);
-    interrupt_register_handler(33, keyboard_handler);
+    // Drivers register their own IRQ handlers (IRQ0 belongs to hal_timer.c)
     
     // Enable interrupts
     asm volatile("sti");
@@ -271,9 +341,7 @@ void interrupts_init_with_diagnostic(void) {
     init_pic();
     init_idt();
     
-    // Register handlers
-    interrupt_register_handler(32, timer_handler);
-    interrupt_register_handler(33, keyboard_handler);
+    // Drivers register their own IRQ handlers (IRQ1 belongs to hal_keyboard.c)
     
     // Capture post-setup CPU state
     cpu_state_t post_setup_state;
@@ -1,124 +1,90 @@
 ; src/interrupt_stubs_new.asm
-; New, more robust implementation of interrupt stubs
+; Generated entry stubs for all 256 IDT vectors
 
 [BITS 32]
 
 ; Exports
-global irq0_handler
-global irq1_handler
-global exception_handler
+global isr_stub_table
 global load_idt
-extern irq_handler_common
-extern exception_handler_common
-extern idt_load
+extern interrupt_dispatch
+extern interrupt_have_tsc
 
 section .text
 
-; Exception handler stub (generic for all exceptions)
-exception_handler:
+; Every stub leaves the same frame for interrupt_dispatch() (struct regs
+; in interrupts.h): an error code (dummy 0 where the CPU pushes none) and
+; the vector number, then the common path saves the rest.
+%assign i 0
+%rep 256
+isr_stub_%+i:
+%if i == 8 || (i >= 10 && i <= 14) || i == 17 || i == 21 || i == 29 || i == 30
+    ; CPU already pushed an error code
+%else
+    push dword 0
+%endif
+    push dword i
+    jmp isr_common
+%assign i i+1
+%endrep
+
+; Common path for all vectors
+isr_common:
     ; Save all registers
     pushad          ; Push EAX, ECX, EDX, EBX, ESP, EBP, ESI, EDI
+
+    ; Sample the TSC as early as possible for latency accounting
+    xor eax, eax
+    xor edx, edx
+    cmp dword [interrupt_have_tsc], 0
+    je .no_tsc
+    rdtsc
+.no_tsc:
     push ds
     push es
     push fs
     push gs
-    
+    push edx
+    push eax
+
     ; Set up data segments
     mov ax, 0x10    ; Kernel data segment
     mov ds, ax
     mov es, ax
     mov fs, ax
     mov gs, ax
-    
-    ; Push interrupt number (simulated, would come from specific handler)
-    push dword 0
-    
-    ; Call C handler
-    call exception_handler_common
-    
-    ; Clean up stack
-    add esp, 4
-    
-    ; Restore registers
-    pop gs
-    pop fs
-    pop es
-    pop ds
-    popad
-    
-    ; Return from interrupt
-    iret
+    cld
 
-; IRQ0 handler (Timer)
-irq0_handler:
-    ; Save all registers
-    pushad
-    push ds
-    push es
-    push fs
-    push gs
-    
-    ; Set up data segments
-    mov ax, 0x10
-    mov ds, ax
-    mov es, ax
-    mov fs, ax
-    mov gs, ax
-    
-    ; Push interrupt number
-    push dword 32    ; IRQ0 = INT 32
-    
-    ; Call C handler
-    call irq_handler_common
-    
-    ; Clean up stack
-    add esp, 4
-    
-    ; Restore registers
-    pop gs
-    pop fs
-    pop es
-    pop ds
-    popad
-    
-    ; Return from interrupt
-    iret
+    ; Call C dispatcher with a pointer to the saved frame
+    push esp
+    call interrupt_dispatch
+    add esp, 12     ; Frame pointer and entry TSC
 
-; IRQ1 handler (Keyboard)
-irq1_handler:
-    ; Save all registers
-    pushad
-    push ds
-    push es
-    push fs
-    push gs
-    
-    ; Set up data segments
-    mov ax, 0x10
-    mov ds, ax
-    mov es, ax
-    mov fs, ax
-    mov gs, ax
-    
-    ; Push interrupt number
-    push dword 33    ; IRQ1 = INT 33
-    
-    ; Call C handler
-    call irq_handler_common
-    
-    ; Clean up stack
-    add esp, 4
-    
     ; Restore registers
     pop gs
     pop fs
     pop es
     pop ds
     popad
-    
+
+    ; Drop vector number and error code
+    add esp, 8
+
     ; Return from interrupt
     iret
 
+section .data
+
+; Stub addresses indexed by vector, used by init_idt()
+align 4
+isr_stub_table:
+%assign i 0
+%rep 256
+    dd isr_stub_%+i
+%assign i i+1
+%endrep
+
+section .text
+
 ; Function to load the IDT
 load_idt:
     push ebp
@@ -126,4 +92,4 @@ load_idt:
     mov eax, [ebp+8]    ; Get the pointer parameter
     lidt [eax]          ; Load IDT
     pop ebp
-    ret
\ No newline at end of file
+    ret
@@ -0,0 +1,336 @@
+// src/ioring.c
+#include "ioring.h"
+#include "file.h"
+#include "fs.h"
+#include "hrtimer.h"
+#include "interrupts.h"
+#include "kmalloc.h"
+#include "memory.h"
+#include "pollset.h"
+#include "string.h"
+#include "syscall.h"
+#include "uaccess.h"
+#include "wait_queue.h"
+#include <stddef.h>
+
+// Bounce buffer size for SQE reads and writes
+#define IORING_COPY_CHUNK 512
+
+typedef struct ioring ioring_t;
+
+// Timeout waiting on its hrtimer
+typedef struct {
+    hrtimer_t timer;
+    ioring_t* ring;
+    uint64_t user_data;
+    uint8_t in_use;
+} ioring_timeout_t;
+
+// Kernel side of a ring. The shared area is writable by the process, so
+// the sizes and array pointers used here are private copies.
+struct ioring {
+    ioring_shared_t* shared;
+    ioring_sqe_t* sqes;
+    ioring_cqe_t* cqes;
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    void* block;                     // kmalloc() block behind shared
+    uint32_t size;                   // Bytes of shared pages
+    ioring_timeout_t timeouts[IORING_MAX_TIMEOUTS];
+    uint32_t inflight;               // Submitted, not yet completed
+    wait_queue_t cq_wait;            // Woken on every completion
+};
+
+// ioring_enter() parked on cq_wait
+typedef struct {
+    wait_queue_entry_t entry;
+    volatile int woken;
+} ioring_waiter_t;
+
+// Post a completion; may run from softirq context
+static void ioring_post(ioring_t* ring, uint64_t user_data, int32_t res) {
+    ioring_shared_t* shared = ring->shared;
+    
+    uint32_t flags = irq_save();
+    if (shared->cq_tail - shared->cq_head >= ring->cq_entries) {
+        shared->cq_overflow++;
+    } else {
+        ioring_cqe_t* cqe = &ring->cqes[shared->cq_tail & (ring->cq_entries - 1)];
+        cqe->user_data = user_data;
+        cqe->res = res;
+        cqe->flags = 0;
+        asm volatile("" : : : "memory");
+        shared->cq_tail++;
+    }
+    irq_restore(flags);
+    
+    wait_queue_wake_all(&ring->cq_wait);
+}
+
+// cq_wait callback for ioring_enter()
+static void ioring_waiter_wake(wait_queue_entry_t* entry) {
+    ((ioring_waiter_t*)entry->owner)->woken = 1;
+}
+
+// IORING_OP_TIMEOUT expiry (softirq context)
+static void ioring_timeout_expired(hrtimer_t* timer) {
+    ioring_timeout_t* timeout = (ioring_timeout_t*)timer->data;
+    ioring_t* ring = timeout->ring;
+    
+    timeout->in_use = 0;
+    ring->inflight--;
+    ioring_post(ring, timeout->user_data, 0);
+}
+
+static int ioring_arm_timeout(ioring_t* ring, const ioring_sqe_t* sqe) {
+    for (int i = 0; i < IORING_MAX_TIMEOUTS; i++) {
+        ioring_timeout_t* timeout = &ring->timeouts[i];
+        if (timeout->in_use) {
+            continue;
+        }
+        
+        timeout->ring = ring;
+        timeout->user_data = sqe->user_data;
+        timeout->in_use = 1;
+        hrtimer_init(&timeout->timer, ioring_timeout_expired, timeout);
+        
+        uint32_t flags = irq_save();
+        ring->inflight++;
+        irq_restore(flags);
+        
+        if (hrtimer_start_relative(&timeout->timer, sqe->off) != 0) {
+            flags = irq_save();
+            ring->inflight--;
+            irq_restore(flags);
+            timeout->in_use = 0;
+            return SYSCALL_EBUSY;
+        }
+        return 0;
+    }
+    return SYSCALL_EBUSY;
+}
+
+// Read or write one buffer for an SQE. The data is bounced through the
+// kernel so a bad user page fails the copy, not the file code.
+static int ioring_rw(const ioring_sqe_t* sqe, int write) {
+    file_t* file = fd_get(sqe->fd);
+    if (!file) {
+        return SYSCALL_EINVAL;
+    }
+    if (!access_ok(sqe->addr, sqe->len)) {
+        return SYSCALL_EFAULT;
+    }
+    
+    int current = sqe->off == IORING_OFF_CURRENT;
+    if (!current && (sqe->off >> 32)) {
+        return SYSCALL_EINVAL;
+    }
+    uint32_t offset = (uint32_t)sqe->off;
+    
+    char chunk[IORING_COPY_CHUNK];
+    uint32_t done = 0;
+    while (done < sqe->len) {
+        uint32_t n = sqe->len - done < IORING_COPY_CHUNK ? sqe->len - done : IORING_COPY_CHUNK;
+        char* user = (char*)sqe->addr + done;
+        int res;
+        
+        if (write) {
+            res = copy_from_user(chunk, user, n);
+            if (res == 0) {
+                res = current ? file_write(file, chunk, n) : file_pwrite(file, chunk, n, offset + done);
+            }
+        } else {
+            res = current ? file_read(file, chunk, n) : file_pread(file, chunk, n, offset + done);
+            if (res > 0 && copy_to_user(user, chunk, res) < 0) {
+                res = SYSCALL_EFAULT;
+            }
+        }
+        
+        if (res < 0) {
+            return done ? (int)done : res;
+        }
+        done += res;
+        if ((uint32_t)res < n) {
+            break;  // End of file
+        }
+    }
+    return done;
+}
+
+// Execute one SQE; everything but timeouts completes inline
+static void ioring_issue(ioring_t* ring, const ioring_sqe_t* sqe) {
+    int res;
+    
+    switch (sqe->opcode) {
+        case IORING_OP_NOP:
+            res = 0;
+            break;
+        case IORING_OP_READ:
+            res = ioring_rw(sqe, 0);
+            break;
+        case IORING_OP_WRITE:
+            res = ioring_rw(sqe, 1);
+            break;
+        case IORING_OP_FSYNC:
+            res = fs_sync() < 0 ? SYSCALL_ERROR : 0;
+            break;
+        case IORING_OP_TIMEOUT:
+            res = ioring_arm_timeout(ring, sqe);
+            if (res == 0) {
+                return;  // Completes from the timer
+            }
+            break;
+        default:
+            res = SYSCALL_EINVAL;
+            break;
+    }
+    
+    ioring_post(ring, sqe->user_data, res);
+}
+
+// Open the shared pages to CPL 3, or close them again
+static void ioring_expose(ioring_t* ring, int user) {
+    uint32_t prot = MEM_PROT_READ | MEM_PROT_WRITE | (user ? MEM_PROT_USER : 0);
+    for (uint32_t off = 0; off < ring->size; off += PAGE_SIZE) {
+        uint32_t page = (uint32_t)ring->shared + off;
+        map_page(page, page, prot);
+    }
+}
+
+static void ioring_release(file_t* file) {
+    ioring_t* ring = (ioring_t*)file->private_data;
+    
+    for (int i = 0; i < IORING_MAX_TIMEOUTS; i++) {
+        if (ring->timeouts[i].in_use) {
+            hrtimer_cancel(&ring->timeouts[i].timer);
+            ring->timeouts[i].in_use = 0;
+        }
+    }
+    
+    ioring_expose(ring, 0);
+    kfree(ring->block);
+    kfree(ring);
+}
+
+// Readable while completions are waiting
+static uint32_t ioring_poll(file_t* file, wait_queue_t** wq) {
+    ioring_t* ring = (ioring_t*)file->private_data;
+    *wq = &ring->cq_wait;
+    return ring->shared->cq_tail != ring->shared->cq_head ? POLL_IN : 0;
+}
+
+static const file_ops_t ioring_ops = { NULL, NULL, ioring_release, ioring_poll };
+
+int ioring_setup(uint32_t entries, ioring_shared_t** shared_out) {
+    if (entries == 0 || entries > IORING_MAX_ENTRIES) {
+        return SYSCALL_EINVAL;
+    }
+    
+    // Ring sizes are powers of two so indices wrap with a mask
+    uint32_t sq_entries = 1;
+    while (sq_entries < entries) {
+        sq_entries <<= 1;
+    }
+    uint32_t cq_entries = sq_entries * 2;
+    
+    // Whole pages, so exposing them to CPL 3 exposes nothing else
+    uint32_t bytes = sizeof(ioring_shared_t) + sq_entries * sizeof(ioring_sqe_t) +
+                     cq_entries * sizeof(ioring_cqe_t);
+    uint32_t size = (bytes + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    ioring_t* ring = kmalloc(sizeof(ioring_t));
+    void* block = kmalloc(size + PAGE_SIZE - 1);
+    if (!ring || !block) {
+        kfree(ring);
+        kfree(block);
+        return SYSCALL_ENOMEM;
+    }
+    
+    ioring_shared_t* shared = (ioring_shared_t*)(((uint32_t)block + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1));
+    memset(shared, 0, size);
+    shared->sq_entries = sq_entries;
+    shared->cq_entries = cq_entries;
+    shared->sqes = (ioring_sqe_t*)(shared + 1);
+    shared->cqes = (ioring_cqe_t*)(shared->sqes + sq_entries);
+    
+    ring->shared = shared;
+    ring->sqes = shared->sqes;
+    ring->cqes = shared->cqes;
+    ring->sq_entries = sq_entries;
+    ring->cq_entries = cq_entries;
+    ring->block = block;
+    ring->size = size;
+    ring->inflight = 0;
+    wait_queue_init(&ring->cq_wait);
+    for (int i = 0; i < IORING_MAX_TIMEOUTS; i++) {
+        ring->timeouts[i].in_use = 0;
+    }
+    
+    file_t* file = file_create(FILE_TYPE_IORING, O_RDWR, &ioring_ops, ring);
+    if (!file) {
+        kfree(block);
+        kfree(ring);
+        return SYSCALL_EMFILE;
+    }
+    
+    int fd = fd_install(file);
+    if (fd < 0) {
+        file_put(file);
+        return fd;
+    }
+    
+    ioring_expose(ring, 1);
+    *shared_out = shared;
+    return fd;
+}
+
+int ioring_enter(int fd, uint32_t to_submit, uint32_t min_complete) {
+    file_t* file = fd_get(fd);
+    if (!file || file->type != FILE_TYPE_IORING) {
+        return SYSCALL_EINVAL;
+    }
+    
+    ioring_t* ring = (ioring_t*)file->private_data;
+    ioring_shared_t* shared = ring->shared;
+    
+    // A tail more than a ring ahead is garbage; drop what cannot be valid
+    uint32_t tail = shared->sq_tail;
+    if (tail - shared->sq_head > ring->sq_entries) {
+        shared->sq_dropped += tail - shared->sq_head - ring->sq_entries;
+        shared->sq_head = tail - ring->sq_entries;
+    }
+    
+    uint32_t submitted = 0;
+    while (submitted < to_submit && shared->sq_head != tail) {
+        // Keep room in the CQ for everything in flight
+        if (shared->cq_tail - shared->cq_head + ring->inflight >= ring->cq_entries) {
+            break;
+        }
+        
+        // Work on a copy so the process cannot change it underneath us
+        ioring_sqe_t sqe = ring->sqes[shared->sq_head & (ring->sq_entries - 1)];
+        shared->sq_head++;
+        ioring_issue(ring, &sqe);
+        submitted++;
+    }
+    
+    // Sleep on the completion queue while anything can still arrive
+    ioring_waiter_t waiter;
+    wait_queue_entry_init(&waiter.entry, ioring_waiter_wake, &waiter);
+    while (shared->cq_tail - shared->cq_head < min_complete && ring->inflight > 0) {
+        // Park before checking again, so a completion in between still wakes us
+        waiter.woken = 0;
+        wait_queue_add(&ring->cq_wait, &waiter.entry);
+        if (shared->cq_tail - shared->cq_head < min_complete && ring->inflight > 0) {
+            while (!waiter.woken) {
+                uint32_t flags = irq_save();
+                if (!waiter.woken) {
+                    irq_enable_and_halt();
+                }
+                irq_restore(flags);
+            }
+        }
+        wait_queue_remove(&ring->cq_wait, &waiter.entry);
+    }
+    
+    return submitted;
+}
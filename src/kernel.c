@@ -6,6 +6,7 @@
 #include "interrupts.h"
 #include "shell.h"
 #include "fs.h"
+#include "bcache.h"
 #include "process.h"
 #include "scheduler.h"
 #include "memory.h"
@@ -13,6 +14,12 @@
 #include "system_utils.h"
 #include "hal.h"
 #include "gui/desktop.h"
+#include "task.h"
+#include "softirq.h"
+#include "trace.h"
+#include "gdt.h"
+#include "syscall.h"
+#include "vdso.h"
 
 // Global stack canary variable
 uint32_t __stack_canary = 0xDEADBEEF;
@@ -91,11 +98,32 @@ bool safe_desktop_init() {
     return false;
 }
 
-// Fallback shell loop with safety checks
-// Fallback shell loop with safety checks
-void fallback_shell_loop() {
-    SERIAL_DEBUG("Entering fallback shell loop...\n");
-    
+// Fallback shell tasks
+static task_t shell_input_task;
+static task_t watchdog_task;
+
+// Shell input task: feed keystrokes to the shell as they arrive
+static int shell_input_task_func(task_t* task) {
+    TASK_BEGIN(task);
+    while (1) {
+        // Sleep until IRQ1 queues a key event
+        TASK_WAIT_EVENT(task, hal_keyboard_wait_queue(), hal_keyboard_is_key_available());
+        
+        key_event_t event;
+        if (!hal_keyboard_read_event(&event)) {
+            SERIAL_DEBUG("Keyboard read error.\n");
+            continue;
+        }
+        
+        // Handle key in shell
+        shell_handle_key_event(&event);
+    }
+    TASK_END(task);
+}
+
+// Watchdog task: periodic stack canary and stability checks
+static int watchdog_task_func(task_t* task) {
+    TASK_BEGIN(task);
     while (1) {
         // Stack canary check
         if (__stack_canary != 0xDEADBEEF) {
@@ -113,24 +141,22 @@ void fallback_shell_loop() {
             system_halt();
         }
         
-        // Poll timer to keep system responsive
-        hal_timer_poll();
-        
-        // Keyboard handling with error checking
-        if (hal_keyboard_is_key_available()) {
-            int scancode = hal_keyboard_read();
-            if (scancode == -1) {
-                SERIAL_DEBUG("Keyboard read error.\n");
-                continue;
-            }
-            
-            // Handle key in shell
-            shell_handle_key(scancode);
-        }
-        
-        // Yield to prevent tight looping
-        scheduler_yield();
+        TASK_SLEEP(task, 100);
     }
+    TASK_END(task);
+}
+
+// Fallback shell loop with safety checks
+void fallback_shell_loop() {
+    SERIAL_DEBUG("Entering fallback shell loop...\n");
+    
+    task_init(&shell_input_task, "shell-input", shell_input_task_func, NULL);
+    task_init(&watchdog_task, "watchdog", watchdog_task_func, NULL);
+    task_start(&shell_input_task);
+    task_start(&watchdog_task);
+    
+    // Never returns
+    task_run_loop();
 }
 extern uint32_t __stack_canary; // Declare stack canary symbol
 
@@ -187,6 +213,20 @@ void kernel_main(unsigned int magic, unsigned int addr) {
     }
     SERIAL_DEBUG("HAL core initialized successfully.\n");
     
+    // Our own GDT, so the selectors the IDT and syscall paths use are known
+    gdt_init();
+    SERIAL_DEBUG("GDT and TSS loaded.\n");
+    
+    // IDT and PIC; every line stays masked until a driver claims it
+    interrupts_init();
+    SERIAL_DEBUG("Interrupts initialized.\n");
+    
+    syscall_init();
+    SERIAL_DEBUG("System call entry initialized.\n");
+    
+    vdso_init();
+    SERIAL_DEBUG("vDSO data page published.\n");
+    
     SERIAL_DEBUG("Starting HAL device initialization...\n");
     int hal_devices_result = hal_init_devices();
     if (hal_devices_result != 0) {
@@ -227,6 +267,18 @@ void kernel_main(unsigned int magic, unsigned int addr) {
     SERIAL_DEBUG("Scheduler initialization complete.\n");
     SERIAL_DEBUG("Process scheduler initialized.\n");
     
+    task_runtime_init();
+    SERIAL_DEBUG("Cooperative task runtime initialized.\n");
+    
+    softirq_init();
+    SERIAL_DEBUG("Softirqs and ksoftirqd initialized.\n");
+    
+    bcache_start_flusher();
+    SERIAL_DEBUG("Buffer cache flusher started.\n");
+    
+    trace_init();
+    SERIAL_DEBUG("Event trace buffer initialized.\n");
+    
     // Attempt GUI initialization
     SERIAL_DEBUG("About to attempt GUI desktop initialization...\n");
     bool gui_success = safe_desktop_init();
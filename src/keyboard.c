@@ -20,7 +20,7 @@ static const char scancode_ascii[] = {
 };
 
 // This is a dedicated keyboard handler - it doesn't depend on external handlers
-static void keyboard_interrupt_handler(void) {
+static void keyboard_interrupt_handler(struct regs* r) {
     uint8_t scancode = inb(KEYBOARD_DATA_PORT);
     
     // Only handle key press events (ignore key release with bit 7 set)
@@ -38,8 +38,7 @@ static void keyboard_interrupt_handler(void) {
         terminal_putchar(c);
     }
     
-    // Send End of Interrupt
-    outb(0x20, 0x20);
+    // interrupt_dispatch() sends the EOI
 }
 
 void keyboard_init(void) {
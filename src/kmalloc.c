@@ -1,8 +1,12 @@
 #include "kmalloc.h"
 #include "memory.h"
 
-#define HEAP_START 0x100000  // 1MB (assuming kernel code is below this)
-#define HEAP_SIZE 0x400000   // 4MB heap
+// The heap runs from the end of the kernel image to HEAP_END; the page
+// frame pool for user memory starts there (memory.c)
+#define HEAP_END 0x500000    // 5MB
+
+// End of the kernel image (linker.ld)
+extern char _kernel_end[];
 // Forward declarations for debugging functions
 // void SERIAL_DEBUG(const char* message);
 // void fb_print_hex(uint32_t value);
@@ -13,12 +17,18 @@ typedef struct block_header {
 } block_header_t;
 
 static block_header_t* heap_start = NULL;
-static void* heap_end = (void*)(HEAP_START + HEAP_SIZE);
+static size_t heap_size = 0;
 
 /* Initialize the heap */
 int kmalloc_init(void) {
-    heap_start = (block_header_t*)HEAP_START;
-    heap_start->size = HEAP_SIZE - sizeof(block_header_t);
+    uint32_t start = ((uint32_t)_kernel_end + 0xFFF) & ~0xFFF;
+    if (start >= HEAP_END) {
+        return -1;
+    }
+    
+    heap_size = HEAP_END - start;
+    heap_start = (block_header_t*)start;
+    heap_start->size = heap_size - sizeof(block_header_t);
     heap_start->is_free = 1;
     heap_start->next = NULL;
     return 0;  // Return 0 to indicate successful initialization
@@ -94,7 +104,7 @@ void kfree(void* ptr) {
 
 /* Get heap statistics */
 void kmalloc_stats(size_t* total, size_t* used, size_t* free) {
-    *total = HEAP_SIZE;
+    *total = heap_size;
     *used = 0;
     *free = 0;
     
@@ -0,0 +1,129 @@
+// src/lapic.c
+#include "lapic.h"
+#include "cpu.h"
+#include "hal_timer.h"
+#include "interrupts.h"
+#include "terminal.h"
+
+// IA32_APIC_BASE model-specific register
+#define IA32_APIC_BASE_MSR    0x1B
+#define IA32_APIC_BASE_ENABLE (1 << 11)
+
+// Local APIC registers (byte offsets)
+#define LAPIC_REG_ID          0x020
+#define LAPIC_REG_TPR         0x080
+#define LAPIC_REG_EOI         0x0B0
+#define LAPIC_REG_SVR         0x0F0
+#define LAPIC_REG_LVT_TIMER   0x320
+#define LAPIC_REG_LVT_LINT0   0x350
+#define LAPIC_REG_LVT_LINT1   0x360
+#define LAPIC_REG_TIMER_INIT  0x380
+#define LAPIC_REG_TIMER_CUR   0x390
+#define LAPIC_REG_TIMER_DIV   0x3E0
+
+// Register values
+#define LAPIC_SVR_ENABLE      0x100
+#define LAPIC_LVT_MASKED      0x10000
+#define LAPIC_DM_EXTINT       0x700
+#define LAPIC_DM_NMI          0x400
+#define LAPIC_TIMER_DIV_16    0x3
+
+// Calibration window
+#define LAPIC_CALIBRATE_MS    10
+
+// Fixed point shift of the ns-to-count multiplier
+#define LAPIC_NS_SHIFT        24
+
+// MMIO base (identity mapped) and timer calibration
+static volatile uint32_t* lapic_base = 0;
+static uint32_t timer_khz = 0;
+static uint32_t timer_ns_mult = 0;
+
+static inline uint32_t lapic_read(uint32_t reg) {
+    return lapic_base[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t value) {
+    lapic_base[reg / 4] = value;
+}
+
+int lapic_init(void) {
+    uint32_t features = cpu_features();
+    if (!(features & CPU_FEATURE_APIC) || !(features & CPU_FEATURE_MSR)) {
+        return -1;
+    }
+    
+    uint64_t base = cpu_read_msr(IA32_APIC_BASE_MSR);
+    cpu_write_msr(IA32_APIC_BASE_MSR, base | IA32_APIC_BASE_ENABLE);
+    lapic_base = (volatile uint32_t*)(uint32_t)(base & 0xFFFFF000);
+    
+    // Virtual wire mode: PIC interrupts arrive as ExtINT on LINT0
+    lapic_write(LAPIC_REG_LVT_LINT0, LAPIC_DM_EXTINT);
+    lapic_write(LAPIC_REG_LVT_LINT1, LAPIC_DM_NMI);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_TPR, 0);
+    lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+    
+    return 0;
+}
+
+int lapic_present(void) {
+    return lapic_base != 0;
+}
+
+void lapic_eoi(void) {
+    lapic_write(LAPIC_REG_EOI, 0);
+}
+
+int lapic_timer_init(uint8_t vector) {
+    uint32_t tsc_khz = hal_timer_tsc_khz();
+    if (!lapic_base || !tsc_khz) {
+        return -1;
+    }
+    
+    // Count down from the top for a fixed TSC interval
+    uint32_t flags = irq_save();
+    lapic_write(LAPIC_REG_TIMER_DIV, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | vector);
+    
+    uint64_t window = (uint64_t)tsc_khz * LAPIC_CALIBRATE_MS;
+    uint64_t start = cpu_read_tsc();
+    lapic_write(LAPIC_REG_TIMER_INIT, 0xFFFFFFFF);
+    while (cpu_read_tsc() - start < window) {
+        asm volatile("pause");
+    }
+    uint32_t elapsed = 0xFFFFFFFF - lapic_read(LAPIC_REG_TIMER_CUR);
+    lapic_write(LAPIC_REG_TIMER_INIT, 0);
+    irq_restore(flags);
+    
+    timer_khz = elapsed / LAPIC_CALIBRATE_MS;
+    if (timer_khz < 1000) {
+        timer_khz = 0;
+        return -1;
+    }
+    timer_ns_mult = (uint32_t)cpu_div64_32((uint64_t)timer_khz << LAPIC_NS_SHIFT, 1000000, NULL);
+    
+    // One-shot mode, unmasked
+    lapic_write(LAPIC_REG_LVT_TIMER, vector);
+    return 0;
+}
+
+void lapic_timer_oneshot_ns(uint64_t ns) {
+    uint64_t count = cpu_mul_u64_u32_shr(ns, timer_ns_mult, LAPIC_NS_SHIFT);
+    
+    // Zero would stop the timer; far deadlines are re-armed on expiry
+    if (count == 0) {
+        count = 1;
+    } else if (count > 0xFFFFFFFF) {
+        count = 0xFFFFFFFF;
+    }
+    lapic_write(LAPIC_REG_TIMER_INIT, (uint32_t)count);
+}
+
+void lapic_timer_stop(void) {
+    lapic_write(LAPIC_REG_TIMER_INIT, 0);
+}
+
+uint32_t lapic_timer_khz(void) {
+    return timer_khz;
+}
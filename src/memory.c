@@ -5,6 +5,8 @@
 #include "terminal.h"
 #include "kmalloc.h"
 #include "string.h"
+#include "interrupts.h"
+#include "vm.h"
 #include <stdint.h>
 
 #define PAGE_SIZE 4096 // 4KB pages
@@ -61,23 +63,11 @@ static int num_memory_zones = 0;
 // Memory allocation tracking
 static memory_block_t* allocation_list = NULL;
 
-// Map a physical page to a virtual address
-int map_page(uint32_t physical_addr, uint32_t virtual_addr, uint32_t flags) {
-    // Simple stub - in a real OS, this would update page tables
-    return 0;  // Success
-}
-
-// Unmap a virtual address
-int unmap_page(uint32_t virtual_addr) {
-    // Simple stub - in a real OS, this would update page tables
-    return 0;  // Success
-}
-
 // Memory mapping list
 static memory_mapping_t* mapping_list = NULL;
 
 // Bitmap of physical page allocations
-#define MAX_PHYSICAL_PAGES 1024 // 4MB with 4KB pages
+#define MAX_PHYSICAL_PAGES 2048 // 8MB with 4KB pages
 static uint32_t physical_page_bitmap[MAX_PHYSICAL_PAGES / 32]; // 1 bit per page, 32 pages per uint32_t
 
 // Initialize memory zones
@@ -135,20 +125,29 @@ static void init_memory_zones(void) {
 
 // Initialize physical page bitmap
 static void init_physical_page_bitmap(void) {
+    // Frames may already be in use by page tables and programs
+    static int initialized = 0;
+    if (initialized) {
+        return;
+    }
+    initialized = 1;
+    
     // Clear the bitmap (0 = free, 1 = allocated)
     for (int i = 0; i < MAX_PHYSICAL_PAGES / 32; i++) {
         physical_page_bitmap[i] = 0;
     }
 
-    // Mark kernel pages as allocated (0MB to 1MB, pages 0-255)
-    for (int i = 0; i < 256 / 32; i++) {
+    // Low memory, the kernel and its heap are never handed out; only the
+    // frame pool is
+    const int reserved = FRAME_POOL_BASE / PAGE_SIZE;
+    for (int i = 0; i < reserved / 32; i++) {
         physical_page_bitmap[i] = 0xFFFFFFFF; // All 32 pages in this uint32_t are allocated
     }
     
     // Mark any partially allocated uint32_t entries
-    if (256 % 32 != 0) {
-        int remainder = 256 % 32;
-        physical_page_bitmap[256 / 32] = (1 << remainder) - 1;
+    if (reserved % 32 != 0) {
+        int remainder = reserved % 32;
+        physical_page_bitmap[reserved / 32] = (1 << remainder) - 1;
     }
 }
 
@@ -210,12 +209,213 @@ static void free_physical_page(uint32_t physical_addr) {
     memory_stats.free_memory += PAGE_SIZE;
 }
 
+uint32_t page_frame_alloc(void) {
+    uint32_t flags = irq_save();
+    uint32_t frame = allocate_physical_page();
+    irq_restore(flags);
+    return frame;
+}
+
+void page_frame_free(uint32_t physical_addr) {
+    uint32_t flags = irq_save();
+    free_physical_page(physical_addr);
+    irq_restore(flags);
+}
+
+// Page directory and table entry bits
+#define PTE_PRESENT  0x001
+#define PTE_WRITE    0x002
+#define PTE_USER     0x004
+#define PTE_PWT      0x008
+#define PTE_PCD      0x010
+#define PDE_LARGE    0x080           // 4MB page (CR4.PSE)
+
+#define PTE_FRAME(e) ((e) & 0xFFFFF000)
+
+// Control register bits
+#define CR0_WP       0x00010000
+#define CR0_PG       0x80000000
+#define CR4_PSE      0x00000010
+
+// 4MB directory slot holding the local APIC and I/O APIC
+#define APIC_PDE     (0xFEE00000 >> 22)
+
+static uint32_t page_directory[1024] __attribute__((aligned(PAGE_SIZE)));
+static uint32_t low_page_tables[LOW_MAP_END >> 22][1024] __attribute__((aligned(PAGE_SIZE)));
+static int paging_on = 0;
+
+// The kernel code user_mode_call() runs at CPL 3 (linker.ld)
+extern char _user_text_start[], _user_text_end[];
+
+// Translate MEM_PROT_* flags to entry bits
+static uint32_t page_entry_flags(uint32_t flags) {
+    uint32_t bits = PTE_PRESENT;
+    if (flags & MEM_PROT_WRITE) {
+        bits |= PTE_WRITE;
+    }
+    if (flags & MEM_PROT_USER) {
+        bits |= PTE_USER;
+    }
+    return bits;
+}
+
+// The table entry for a 4KB-mapped address, or NULL
+static uint32_t* page_table_entry(uint32_t virtual_addr, int create) {
+    uint32_t* pde = &page_directory[virtual_addr >> 22];
+    if (*pde & PDE_LARGE) {
+        return NULL;
+    }
+    
+    if (!(*pde & PTE_PRESENT)) {
+        if (!create) {
+            return NULL;
+        }
+        
+        // Pool frames are identity mapped, so the table is usable at once
+        uint32_t table = page_frame_alloc();
+        if (!table) {
+            return NULL;
+        }
+        memset((void*)table, 0, PAGE_SIZE);
+        *pde = table | PTE_PRESENT | PTE_WRITE | PTE_USER;
+    }
+    
+    uint32_t* table = (uint32_t*)PTE_FRAME(*pde);
+    return &table[(virtual_addr >> 12) & 0x3FF];
+}
+
 // Initialize paging system
 int init_paging(void) {
-    terminal_writestring("Paging initialized\n");
+    if (!(cpu_features() & CPU_FEATURE_PSE)) {
+        terminal_writestring("Paging: no 4MB page support, running unpaged\n");
+        return 0;
+    }
+    
+    init_physical_page_bitmap();
+    
+    // Low memory: kernel only, except the user text page, which CPL 3
+    // may execute but not write. The directory entries allow user access
+    // so pages opened later (channels, rings) work; the table decides.
+    uint32_t user_start = (uint32_t)_user_text_start;
+    uint32_t user_end = (uint32_t)_user_text_end;
+    for (uint32_t addr = 0; addr < LOW_MAP_END; addr += PAGE_SIZE) {
+        uint32_t entry = addr | PTE_PRESENT | PTE_WRITE;
+        if (addr >= user_start && addr < user_end) {
+            entry = addr | PTE_PRESENT | PTE_USER;
+        }
+        low_page_tables[addr >> 22][(addr >> 12) & 0x3FF] = entry;
+    }
+    
+    for (uint32_t i = 0; i < 1024; i++) {
+        uint32_t base = i << 22;
+        if (base < LOW_MAP_END) {
+            page_directory[i] = (uint32_t)low_page_tables[i] | PTE_PRESENT | PTE_WRITE | PTE_USER;
+        } else if (base >= USER_BASE && base < USER_TOP) {
+            page_directory[i] = 0;  // Tables appear as programs fault
+        } else {
+            page_directory[i] = base | PTE_PRESENT | PTE_WRITE | PDE_LARGE;
+        }
+    }
+    
+    // Keep the APIC registers uncached
+    page_directory[APIC_PDE] |= PTE_PCD | PTE_PWT;
+    
+    // CR0.WP: the kernel faults on read-only pages too, so copy_to_user
+    // cannot write into a program's text
+    uint32_t cr;
+    asm volatile("mov %%cr4, %0" : "=r"(cr));
+    asm volatile("mov %0, %%cr4" : : "r"(cr | CR4_PSE));
+    asm volatile("mov %0, %%cr3" : : "r"((uint32_t)page_directory) : "memory");
+    asm volatile("mov %%cr0, %0" : "=r"(cr));
+    asm volatile("mov %0, %%cr0" : : "r"(cr | CR0_PG | CR0_WP) : "memory");
+    paging_on = 1;
+    
+    terminal_printf("Paging enabled: user window 0x%x-0x%x\n", USER_BASE, USER_TOP);
     return 0; // Success
 }
 
+int paging_enabled(void) {
+    return paging_on;
+}
+
+// Map a physical page to a virtual address
+int map_page(uint32_t physical_addr, uint32_t virtual_addr, uint32_t flags) {
+    if (!paging_on) {
+        return 0;  // Everything is reachable already
+    }
+    
+    uint32_t* pte = page_table_entry(virtual_addr, 1);
+    if (!pte) {
+        // 4MB identity pages can only stay as they are
+        return (page_directory[virtual_addr >> 22] & PDE_LARGE) &&
+               physical_addr == virtual_addr ? 0 : -1;
+    }
+    
+    *pte = PTE_FRAME(physical_addr) | page_entry_flags(flags);
+    cpu_invlpg(virtual_addr);
+    return 0;
+}
+
+// Unmap a virtual address
+int unmap_page(uint32_t virtual_addr) {
+    if (!paging_on) {
+        return 0;
+    }
+    
+    uint32_t* pte = page_table_entry(virtual_addr, 0);
+    if (!pte) {
+        return -1;
+    }
+    
+    *pte = 0;
+    cpu_invlpg(virtual_addr);
+    return 0;
+}
+
+// Change the protection of a mapped page
+int protect_page(uint32_t virtual_addr, uint32_t flags) {
+    if (!paging_on) {
+        return 0;
+    }
+    
+    uint32_t* pte = page_table_entry(virtual_addr, 0);
+    if (!pte || !(*pte & PTE_PRESENT)) {
+        return -1;
+    }
+    
+    *pte = PTE_FRAME(*pte) | page_entry_flags(flags);
+    cpu_invlpg(virtual_addr);
+    return 0;
+}
+
+// Physical address behind a virtual one; 0 if unmapped
+uint32_t get_physical_address(uint32_t virtual_addr) {
+    if (!paging_on) {
+        return virtual_addr;
+    }
+    
+    uint32_t pde = page_directory[virtual_addr >> 22];
+    if (!(pde & PTE_PRESENT)) {
+        return 0;
+    }
+    if (pde & PDE_LARGE) {
+        return virtual_addr;
+    }
+    
+    uint32_t pte = ((uint32_t*)PTE_FRAME(pde))[(virtual_addr >> 12) & 0x3FF];
+    if (!(pte & PTE_PRESENT)) {
+        return 0;
+    }
+    return PTE_FRAME(pte) | (virtual_addr & 0xFFF);
+}
+
+int memory_fault_handler(uint32_t fault_addr, uint32_t error_code) {
+    if (!paging_on || fault_addr < USER_BASE || fault_addr >= USER_TOP) {
+        return 0;
+    }
+    return vm_fault(fault_addr, error_code);
+}
+
 // Track memory allocation
 void track_memory_allocation(uint32_t address, uint32_t size, uint32_t flags, 
                            const char* allocation_type, const char* allocated_by) {
@@ -0,0 +1,343 @@
+// src/pollset.c
+#include "pollset.h"
+#include "file.h"
+#include "hal_keyboard.h"
+#include "hal_mouse.h"
+#include "hal_timer.h"
+#include "hrtimer.h"
+#include "interrupts.h"
+#include "kmalloc.h"
+#include "string.h"
+#include "syscall.h"
+#include <stddef.h>
+
+// Kernel side of one watch
+typedef struct {
+    poll_watch_t watch;
+    pollset_t* set;
+    uint32_t bit;                    // This watch's bit in the pending mask
+    uint8_t in_use;
+    file_t* file;                    // Reference held for POLL_SRC_FD
+    wait_queue_t* wq;                // Queue the entry parks on, if any
+    wait_queue_entry_t entry;
+    hrtimer_t timer;                 // POLL_SRC_TIMER
+    uint64_t period_ns;
+    volatile uint32_t expirations;   // Periods since the last report
+} poll_watch_state_t;
+
+struct pollset {
+    poll_watch_state_t watches[POLLSET_MAX_WATCHES];
+    volatile uint32_t pending;       // Watches to recheck
+    volatile uint32_t wakeups;       // Bumped by every mark
+    wait_queue_t waiters;            // Woken by every mark
+};
+
+// Flag a watch for the next collect; safe from interrupt context
+static void pollset_mark(poll_watch_state_t* ws) {
+    pollset_t* set = ws->set;
+    
+    uint32_t flags = irq_save();
+    set->pending |= ws->bit;
+    set->wakeups++;
+    irq_restore(flags);
+    
+    wait_queue_wake_all(&set->waiters);
+}
+
+// Source wait queue callback: stay registered, then mark
+static void pollset_wake(wait_queue_entry_t* entry) {
+    poll_watch_state_t* ws = (poll_watch_state_t*)entry->owner;
+    
+    wait_queue_add(ws->wq, &ws->entry);
+    pollset_mark(ws);
+}
+
+// Timer period elapsed (softirq context)
+static void pollset_timer_expired(hrtimer_t* timer) {
+    poll_watch_state_t* ws = (poll_watch_state_t*)timer->data;
+    
+    ws->expirations++;
+    hrtimer_start(&ws->timer, timer->expires + ws->period_ns);
+    pollset_mark(ws);
+}
+
+// Current ready bits of a watch; *wq is the queue to park on
+static uint32_t pollset_poll_source(poll_watch_state_t* ws, wait_queue_t** wq) {
+    *wq = NULL;
+    
+    switch (ws->watch.source) {
+        case POLL_SRC_FD:
+            return file_poll(ws->file, wq);
+        case POLL_SRC_KEYBOARD:
+            *wq = hal_keyboard_wait_queue();
+            return hal_keyboard_is_key_available() ? POLL_IN : 0;
+        case POLL_SRC_MOUSE:
+            *wq = mouse_wait_queue();
+            return mouse_pending() ? POLL_IN : 0;
+        case POLL_SRC_TIMER:
+            return ws->expirations ? POLL_IN : 0;
+        default:
+            return POLL_ERR;
+    }
+}
+
+static poll_watch_state_t* pollset_find(pollset_t* set, const poll_watch_t* watch) {
+    for (int i = 0; i < POLLSET_MAX_WATCHES; i++) {
+        poll_watch_state_t* ws = &set->watches[i];
+        if (ws->in_use && ws->watch.source == watch->source && ws->watch.id == watch->id) {
+            return ws;
+        }
+    }
+    return NULL;
+}
+
+static void pollset_detach(poll_watch_state_t* ws) {
+    if (ws->wq) {
+        wait_queue_remove(ws->wq, &ws->entry);
+        ws->wq = NULL;
+    }
+    if (ws->watch.source == POLL_SRC_TIMER) {
+        hrtimer_cancel(&ws->timer);
+    }
+    if (ws->file) {
+        file_put(ws->file);
+        ws->file = NULL;
+    }
+    
+    uint32_t flags = irq_save();
+    ws->set->pending &= ~ws->bit;
+    irq_restore(flags);
+    ws->in_use = 0;
+}
+
+static int pollset_attach(pollset_t* set, poll_watch_state_t* ws, const poll_watch_t* watch) {
+    ws->watch = *watch;
+    ws->file = NULL;
+    ws->wq = NULL;
+    ws->expirations = 0;
+    wait_queue_entry_init(&ws->entry, pollset_wake, ws);
+    
+    if (watch->source == POLL_SRC_FD) {
+        file_t* file = fd_get(watch->id);
+        if (!file || file->type == FILE_TYPE_POLLSET) {
+            return SYSCALL_EINVAL;
+        }
+        file_get(file);
+        ws->file = file;
+    } else if (watch->source == POLL_SRC_TIMER) {
+        if (watch->arg == 0) {
+            return SYSCALL_EINVAL;
+        }
+        ws->period_ns = watch->arg * NSEC_PER_MSEC;
+        hrtimer_init(&ws->timer, pollset_timer_expired, ws);
+        if (hrtimer_start_relative(&ws->timer, ws->period_ns) != 0) {
+            return SYSCALL_EBUSY;
+        }
+    } else if (watch->source != POLL_SRC_KEYBOARD && watch->source != POLL_SRC_MOUSE) {
+        return SYSCALL_EINVAL;
+    }
+    
+    // Park on the source's queue, then look once in case it is ready now
+    wait_queue_t* wq;
+    pollset_poll_source(ws, &wq);
+    if (wq) {
+        ws->wq = wq;
+        wait_queue_add(wq, &ws->entry);
+    }
+    ws->in_use = 1;
+    pollset_mark(ws);
+    return 0;
+}
+
+pollset_t* pollset_create(void) {
+    pollset_t* set = kmalloc(sizeof(pollset_t));
+    if (!set) {
+        return NULL;
+    }
+    
+    memset(set, 0, sizeof(pollset_t));
+    for (int i = 0; i < POLLSET_MAX_WATCHES; i++) {
+        set->watches[i].set = set;
+        set->watches[i].bit = 1u << i;
+    }
+    wait_queue_init(&set->waiters);
+    return set;
+}
+
+void pollset_destroy(pollset_t* set) {
+    for (int i = 0; i < POLLSET_MAX_WATCHES; i++) {
+        if (set->watches[i].in_use) {
+            pollset_detach(&set->watches[i]);
+        }
+    }
+    kfree(set);
+}
+
+int pollset_ctl(pollset_t* set, uint32_t op, const poll_watch_t* watch) {
+    poll_watch_state_t* ws = pollset_find(set, watch);
+    
+    switch (op) {
+        case POLL_CTL_ADD:
+            if (ws) {
+                return SYSCALL_EEXIST;
+            }
+            for (int i = 0; i < POLLSET_MAX_WATCHES && !ws; i++) {
+                if (!set->watches[i].in_use) {
+                    ws = &set->watches[i];
+                }
+            }
+            if (!ws) {
+                return SYSCALL_ENOMEM;
+            }
+            return pollset_attach(set, ws, watch);
+        case POLL_CTL_DEL:
+            if (!ws) {
+                return SYSCALL_ENOENT;
+            }
+            pollset_detach(ws);
+            return 0;
+        case POLL_CTL_MOD:
+            if (!ws) {
+                return SYSCALL_ENOENT;
+            }
+            if (watch->source == POLL_SRC_TIMER && watch->arg != ws->watch.arg) {
+                // A new period restarts the timer
+                pollset_detach(ws);
+                return pollset_attach(set, ws, watch);
+            }
+            ws->watch.events = watch->events;
+            ws->watch.data = watch->data;
+            pollset_mark(ws);
+            return 0;
+        default:
+            return SYSCALL_EINVAL;
+    }
+}
+
+int pollset_collect(pollset_t* set, poll_event_t* events, uint32_t max) {
+    uint32_t flags = irq_save();
+    uint32_t pending = set->pending;
+    set->pending = 0;
+    irq_restore(flags);
+    
+    uint32_t recheck = 0;
+    uint32_t count = 0;
+    for (int i = 0; i < POLLSET_MAX_WATCHES && pending; i++) {
+        poll_watch_state_t* ws = &set->watches[i];
+        if (!(pending & ws->bit)) {
+            continue;
+        }
+        pending &= ~ws->bit;
+        if (!ws->in_use) {
+            continue;
+        }
+        if (count == max) {
+            recheck |= ws->bit;  // Left for the next batch
+            continue;
+        }
+        
+        wait_queue_t* wq;
+        uint32_t ready = pollset_poll_source(ws, &wq) & (ws->watch.events | POLL_ERR);
+        if (!wq && ws->watch.source != POLL_SRC_TIMER) {
+            recheck |= ws->bit;  // Nothing will wake us for this one
+        }
+        if (!ready) {
+            continue;
+        }
+        
+        poll_event_t* ev = &events[count++];
+        ev->events = ready;
+        ev->data = ws->watch.data;
+        ev->count = 0;
+        if (ws->watch.source == POLL_SRC_TIMER) {
+            flags = irq_save();
+            ev->count = ws->expirations;
+            ws->expirations = 0;
+            irq_restore(flags);
+        } else {
+            recheck |= ws->bit;  // Level triggered: look again next time
+        }
+    }
+    
+    if (recheck) {
+        flags = irq_save();
+        set->pending |= recheck;
+        irq_restore(flags);
+    }
+    return count;
+}
+
+int pollset_pending(pollset_t* set) {
+    return set->pending != 0;
+}
+
+wait_queue_t* pollset_wait_queue(pollset_t* set) {
+    return &set->waiters;
+}
+
+// Descriptor wrappers
+
+static void pollset_release(file_t* file) {
+    pollset_destroy((pollset_t*)file->private_data);
+}
+
+static const file_ops_t pollset_ops = { NULL, NULL, pollset_release };
+
+static pollset_t* pollset_get(int fd) {
+    file_t* file = fd_get(fd);
+    if (!file || file->type != FILE_TYPE_POLLSET) {
+        return NULL;
+    }
+    return (pollset_t*)file->private_data;
+}
+
+int pollset_create_fd(void) {
+    pollset_t* set = pollset_create();
+    if (!set) {
+        return SYSCALL_ENOMEM;
+    }
+    
+    file_t* file = file_create(FILE_TYPE_POLLSET, O_RDWR, &pollset_ops, set);
+    if (!file) {
+        pollset_destroy(set);
+        return SYSCALL_EMFILE;
+    }
+    
+    int fd = fd_install(file);
+    if (fd < 0) {
+        file_put(file);
+    }
+    return fd;
+}
+
+int pollset_ctl_fd(int fd, uint32_t op, const poll_watch_t* watch) {
+    pollset_t* set = pollset_get(fd);
+    if (!set) {
+        return SYSCALL_EINVAL;
+    }
+    return pollset_ctl(set, op, watch);
+}
+
+int pollset_wait_fd(int fd, poll_event_t* events, uint32_t max, uint32_t timeout_ms) {
+    pollset_t* set = pollset_get(fd);
+    if (!set || max == 0) {
+        return SYSCALL_EINVAL;
+    }
+    
+    uint64_t deadline = hal_timer_get_ns() + timeout_ms * NSEC_PER_MSEC;
+    for (;;) {
+        uint32_t wakeups = set->wakeups;
+        int count = pollset_collect(set, events, max);
+        if (count > 0 || hal_timer_get_ns() >= deadline) {
+            return count;
+        }
+        
+        // Sleep until some source marks a watch; any interrupt ends the
+        // halt, so polled sources and the deadline are still checked
+        uint32_t flags = irq_save();
+        if (set->wakeups == wakeups) {
+            irq_enable_and_halt();
+        }
+        irq_restore(flags);
+    }
+}
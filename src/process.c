@@ -6,6 +6,10 @@
 #include "terminal.h"
 #include "scheduler.h"
 #include "interrupts.h"  // Include this for timer_ticks
+#include "trace.h"
+#include "hal_timer.h"
+#include "vdso.h"
+#include "file.h"
 
 // Process table
 static process_t process_table[MAX_PROCESSES];
@@ -16,6 +20,16 @@ static uint32_t next_pid = 1;
 // The currently running process
 static process_t* current_process = NULL;
 
+// Sleep timer callback (interrupt context)
+static void process_sleep_expired(hrtimer_t* timer) {
+    process_t* proc = (process_t*)timer->data;
+    
+    if (proc->state == PROCESS_STATE_SLEEPING) {
+        proc->state = PROCESS_STATE_READY;
+        trace_event(TRACE_EV_SCHED_WAKEUP, proc->pid, 0);
+    }
+}
+
 // Initialize the process management subsystem
 void process_init(void) {
     // Clear the process table
@@ -30,6 +44,8 @@ void process_init(void) {
     process_table[0].ticks_remaining = 1;
     process_table[0].total_runtime = 0;
     process_table[0].entry_point = NULL;  // Idle process just returns to scheduler
+    hrtimer_init(&process_table[0].sleep_timer, process_sleep_expired, &process_table[0]);
+    fd_table_init(process_table[0].fds);
     process_table[0].cpu_usage_percent = 0;
     process_table[0].parent_pid = 0;
     
@@ -47,6 +63,7 @@ void process_init(void) {
     
     // Set current process to idle
     current_process = &process_table[0];
+    vdso_set_pid(current_process->pid);
     
     terminal_writestring("Process management initialized\n");
 }
@@ -117,6 +134,9 @@ int process_create(const char* name, void (*entry_point)(void), uint8_t priority
     proc->parent_pid = 0;  // Default parent is system
     proc->cpu_usage_percent = 0;
     proc->exit_code = 0;
+    hrtimer_init(&proc->sleep_timer, process_sleep_expired, proc);
+    fd_table_init(proc->fds);
+    memset(proc->syscalls, 0, sizeof(proc->syscalls));
     
     // Set time slice based on priority
     switch (priority) {
@@ -188,9 +208,11 @@ void process_terminate(uint32_t pid) {
     }
     
     // Update state
+    hrtimer_cancel(&proc->sleep_timer);
     proc->state = PROCESS_STATE_TERMINATED;
     
     // Free resources
+    fd_table_close_all(proc->fds);
     if (proc->stack) {
         kfree(proc->stack);
         proc->stack = NULL;
@@ -235,6 +257,7 @@ void process_unblock(uint32_t pid) {
     }
     
     proc->state = PROCESS_STATE_READY;
+    trace_event(TRACE_EV_SCHED_WAKEUP, pid, 0);
 }
 
 // Put a process to sleep for a specified number of milliseconds
@@ -244,11 +267,13 @@ void process_sleep(uint32_t pid, uint32_t ms) {
         return;
     }
     
-    // Convert ms to timer ticks (assuming 100Hz timer)
-    uint32_t ticks = (ms / 10) + 1;
-    
+    // The timer moves the process back to READY at the deadline
+    uint32_t flags = irq_save();
     proc->state = PROCESS_STATE_SLEEPING;
-    proc->sleep_until = timer_ticks + ticks;
+    if (hrtimer_start_relative(&proc->sleep_timer, ms * NSEC_PER_MSEC) != 0) {
+        proc->state = PROCESS_STATE_READY;
+    }
+    irq_restore(flags);
     
     // If we're sleeping the current process, yield
     if (proc == current_process) {
@@ -297,6 +322,7 @@ process_t* process_get_current(void) {
 // Set the current running process
 void process_set_current(process_t* proc) {
     current_process = proc;
+    vdso_set_pid(proc ? proc->pid : 0);
 }
 
 // Get a process by PID
@@ -4,6 +4,8 @@
 #include "terminal.h"
 #include "stdio.h"
 #include "hal.h"
+#include "trace.h"
+#include "elf.h"
 
 // Scheduler types
 #define SCHEDULER_TYPE_ROUND_ROBIN   0
@@ -259,6 +261,8 @@ static void scheduler_context_switch(process_t* next) {
         return;
     }
     
+    trace_event(TRACE_EV_SCHED_SWITCH, current ? current->pid : 0, next->pid);
+    
     // Update states
     if (current) {
         if (current->state == PROCESS_STATE_RUNNING) {
@@ -398,17 +402,7 @@ void scheduler_timer_tick(void) {
         }
     }
     
-    // Check for sleeping processes that need to wake up
-    for (int q = 0; q < MAX_PRIORITY_QUEUES; q++) {
-        for (uint32_t i = 0; i < queue_counts[q]; i++) {
-            process_t* proc = process_queues[q][i];
-            if (proc && proc->state == PROCESS_STATE_SLEEPING) {
-                if (hal_timer_get_ticks() >= proc->sleep_until) {
-                    proc->state = PROCESS_STATE_READY;
-                }
-            }
-        }
-    }
+    // Sleeping processes are woken by their hrtimer (process_sleep)
     
     // Get current process
     process_t* current = process_get_current();
@@ -417,6 +411,12 @@ void scheduler_timer_tick(void) {
     // Update runtime statistics
     current->total_runtime++;
     
+    // A program run by elf_exec() owns the CPU, and its process must stay
+    // current until it returns
+    if (elf_exec_running()) {
+        return;
+    }
+    
     // Skip time slice management for idle process
     if (current->pid == scheduler_config.idle_task_pid) {
         // Always try to find a non-idle process
@@ -4,6 +4,7 @@
 #include "string.h"  // Added to fix implicit string function declarations
 #include "stdio.h"   // Added to fix implicit printf function declarations
 #include "fs.h"
+#include "bcache.h"
 #include "kmalloc.h"
 #include "hal.h"
 #include "memory.h"
@@ -13,6 +14,14 @@
 #include <stdarg.h>
 #include "fs_extended.h"
 #include "hal_ata.h"
+#include "hal_keyboard.h"
+#include "trace.h"
+#include "interrupts.h"
+#include "interrupt_diagnostics.h"
+#include "cpu.h"
+#include "hrtimer.h"
+#include "softirq.h"
+#include "vm.h"
 
 
 // Shell configuration
@@ -20,7 +29,10 @@
 #define COMMAND_HISTORY_SIZE 20
 #define MAX_ARGS 16
 #define PROMPT_TEXT "> "
-#define MAX_COMMANDS 32
+#define MAX_COMMANDS 64
+#define SHELL_WRITE_MAX 8192        // Text the write command collects
+#define DISKDUMP_SHOWN 10           // Sectors diskdump prints
+#define DISKFILL_SECTORS 32         // Sectors diskfill writes per request
 #define MAX_AUTOCOMPLETE_RESULTS 10
 
 // Command history
@@ -76,10 +88,17 @@ static int cmd_fsinfo(int argc, char** argv);
 static int cmd_fscheck(int argc, char** argv);
 static int cmd_fsrepair(int argc, char** argv);
 static int cmd_diskdump(int argc, char** argv);
+static int cmd_diskfill(int argc, char** argv);
 static int cmd_sched(int argc, char** argv);
 static int cmd_history(int argc, char** argv);
 static int cmd_reboot(int argc, char** argv);
 static int cmd_exit(int argc, char** argv);
+static int cmd_trace(int argc, char** argv);
+static int cmd_irqstat(int argc, char** argv);
+static int cmd_sysbench(int argc, char** argv);
+static int cmd_syscount(int argc, char** argv);
+static int cmd_exec(int argc, char** argv);
+static int cmd_cachepolicy(int argc, char** argv);
 
 // Command table
 static command_t commands[MAX_COMMANDS] = {
@@ -112,10 +131,17 @@ static command_t commands[MAX_COMMANDS] = {
     {"fscheck", "Check file system consistency", cmd_fscheck},
     {"fsrepair", "Repair file system", cmd_fsrepair},
     {"diskdump", "Dump disk contents", cmd_diskdump},
+    {"diskfill", "Fill disk sectors with a byte value", cmd_diskfill},
     {"sched", "Display scheduler info", cmd_sched},
     {"history", "Show command history", cmd_history},
     {"reboot", "Reboot the system", cmd_reboot},
     {"exit", "Exit the shell", cmd_exit},
+    {"trace", "Record scheduler/IRQ trace, dump over COM1", cmd_trace},
+    {"irqstat", "Show per-vector interrupt counts and cycles", cmd_irqstat},
+    {"sysbench", "Time null system calls via int 0x80 and sysenter", cmd_sysbench},
+    {"syscount", "Per-syscall counts, errors and cycles (system or pid)", cmd_syscount},
+    {"exec", "Run an ELF program and show its exit status", cmd_exec},
+    {"cachepolicy", "Show or set the buffer cache policy (lru, 2q)", cmd_cachepolicy},
     {NULL, NULL, NULL}  // Terminator
 };
 
@@ -152,22 +178,31 @@ static void add_to_history(const char* command) {
     }
 }
 
+// Write a character count times with a few bulk terminal writes
+static void shell_write_repeat(char c, int count) {
+    char run[32];
+    for (int i = 0; i < (int)sizeof(run); i++) {
+        run[i] = c;
+    }
+    while (count > 0) {
+        int n = count < (int)sizeof(run) ? count : (int)sizeof(run);
+        terminal_write(run, n);
+        count -= n;
+    }
+}
+
 // Helper function to clear the current line
 static void clear_current_line(void) {
+    int len = buffer_pos + strlen(PROMPT_TEXT);
+    
     // Move cursor to beginning of line
-    for (int i = 0; i < buffer_pos + strlen(PROMPT_TEXT); i++) {
-        terminal_putchar('\b');
-    }
+    shell_write_repeat('\b', len);
     
     // Clear the line with spaces
-    for (int i = 0; i < buffer_pos + strlen(PROMPT_TEXT); i++) {
-        terminal_putchar(' ');
-    }
+    shell_write_repeat(' ', len);
     
     // Move cursor back to beginning of line
-    for (int i = 0; i < buffer_pos + strlen(PROMPT_TEXT); i++) {
-        terminal_putchar('\b');
-    }
+    shell_write_repeat('\b', len);
 }
 
 // Helper function to redraw the current line
@@ -274,32 +309,11 @@ static void find_matching_commands(const char* prefix) {
     }
 }
 
-// Helper function to find a node by path (normally in fs.c, replicated here for completeness)
+// Node index for a path, or -1
 static int fs_find_node(const char* path) {
     extern fs_node_t fs_nodes[FS_MAX_FILES];
-    
-    // Handle absolute vs relative paths
-    char full_path[FS_MAX_PATH];
-    if (path[0] == '/') {
-        // Absolute path
-        strncpy(full_path, path, FS_MAX_PATH);
-    } else {
-        // Relative path - concatenate with current directory
-        strncpy(full_path, fs_getcwd(), FS_MAX_PATH);
-        if (fs_getcwd()[strlen(fs_getcwd())-1] != '/') {
-            strncat(full_path, "/", FS_MAX_PATH - strlen(full_path) - 1);
-        }
-        strncat(full_path, path, FS_MAX_PATH - strlen(full_path) - 1);
-    }
-    
-    // Search for the node
-    for (int i = 0; i < FS_MAX_FILES; i++) {
-        if (fs_nodes[i].in_use && strcmp(fs_nodes[i].path, full_path) == 0) {
-            return i;
-        }
-    }
-    
-    return -1; // Not found
+    fs_node_t* node = fs_lookup(path);
+    return node ? node - fs_nodes : -1;
 }
 
 // Helper function to find matching files for tab completion
@@ -431,80 +445,54 @@ static void handle_tab_completion(void) {
 }
 
 // Enhanced handle_key function for the shell
+// Map a translated key event to the shell's key code: the character
+// itself, or -1..-4 for the up/down/left/right arrows (0 = ignore)
+static int shell_key_from_event(const key_event_t* event) {
+    if (event->flags & KEY_EVENT_RELEASE) {
+        return 0;
+    }
+    
+    switch (event->keycode) {
+        case KEY_UP:    return -1;
+        case KEY_DOWN:  return -2;
+        case KEY_LEFT:  return -3;
+        case KEY_RIGHT: return -4;
+        default:        return (unsigned char)event->ascii;
+    }
+}
+
+// Process a single raw scancode (no modifier state)
 void shell_handle_key(int scancode) {
-    // Convert scancode to key code
-    int key = 0;
-    
-    // Standard US QWERTY keyboard mapping for common keys
-    switch (scancode) {
-        // Letters
-        case 16: key = 'q'; break;
-        case 17: key = 'w'; break;
-        case 18: key = 'e'; break;
-        case 19: key = 'r'; break;
-        case 20: key = 't'; break;
-        case 21: key = 'y'; break;
-        case 22: key = 'u'; break;
-        case 23: key = 'i'; break;
-        case 24: key = 'o'; break;
-        case 25: key = 'p'; break;
-        case 30: key = 'a'; break;
-        case 31: key = 's'; break;
-        case 32: key = 'd'; break;
-        case 33: key = 'f'; break;
-        case 34: key = 'g'; break;
-        case 35: key = 'h'; break;
-        case 36: key = 'j'; break;
-        case 37: key = 'k'; break;
-        case 38: key = 'l'; break;
-        case 44: key = 'z'; break;
-        case 45: key = 'x'; break;
-        case 46: key = 'c'; break;
-        case 47: key = 'v'; break;
-        case 48: key = 'b'; break;
-        case 49: key = 'n'; break;
-        case 50: key = 'm'; break;
-        
-        // Numbers
-        case 2: key = '1'; break;
-        case 3: key = '2'; break;
-        case 4: key = '3'; break;
-        case 5: key = '4'; break;
-        case 6: key = '5'; break;
-        case 7: key = '6'; break;
-        case 8: key = '7'; break;
-        case 9: key = '8'; break;
-        case 10: key = '9'; break;
-        case 11: key = '0'; break;
-        
-        // Special keys
-        case 14: key = '\b'; break;  // Backspace
-        case 15: key = '\t'; break;  // Tab
-        case 28: key = '\n'; break;  // Enter
-        case 57: key = ' '; break;   // Space
-        case 72: key = -1; break;    // Up arrow
-        case 80: key = -2; break;    // Down arrow
-        case 75: key = -3; break;    // Left arrow
-        case 77: key = -4; break;    // Right arrow
-        
-        // Symbols
-        case 12: key = '-'; break;
-        case 13: key = '='; break;
-        case 26: key = '['; break;
-        case 27: key = ']'; break;
-        case 39: key = ';'; break;
-        case 40: key = '\''; break;
-        case 41: key = '`'; break;
-        case 43: key = '\\'; break;
-        case 51: key = ','; break;
-        case 52: key = '.'; break;
-        case 53: key = '/'; break;
-        
-        default: 
-            key = 0;  // Ignore other keys
+    key_event_t event = {0};
+    
+    if (scancode < 0) {
+        return;
+    }
+    
+    // Bare arrow make codes map like their E0-prefixed forms
+    event.scancode = scancode;
+    event.flags = (scancode & KEY_RELEASE) ? KEY_EVENT_RELEASE : 0;
+    switch (scancode & ~KEY_RELEASE) {
+        case 72: event.keycode = KEY_UP; break;
+        case 80: event.keycode = KEY_DOWN; break;
+        case 75: event.keycode = KEY_LEFT; break;
+        case 77: event.keycode = KEY_RIGHT; break;
+        default:
+            event.keycode = scancode & ~KEY_RELEASE;
+            event.ascii = hal_keyboard_scancode_to_ascii(scancode);
             break;
     }
     
+    shell_handle_key_event(&event);
+}
+
+// Process a single translated key event
+void shell_handle_key_event(const key_event_t* event) {
+    int key = shell_key_from_event(event);
+    if (key == 0) {
+        return;
+    }
+    
     // Reset tab completion state if not tab key
     if (key != '\t') {
         tab_pressed = 0;
@@ -534,9 +522,7 @@ void shell_handle_key(int scancode) {
             // Backspace
             if (buffer_pos > 0) {
                 buffer_pos--;
-                terminal_putchar('\b');
-                terminal_putchar(' ');
-                terminal_putchar('\b');
+                terminal_write("\b \b", 3);
                 command_buffer[buffer_pos] = '\0';
             }
             break;
@@ -694,65 +680,38 @@ static int cmd_write(int argc, char** argv) {
     
     terminal_writestring("Enter file content (end with Ctrl+D on new line):\n");
     
-    char content[FS_MAX_FILESIZE] = {0};
+    char content[SHELL_WRITE_MAX] = {0};
     int content_pos = 0;
     int line_start = 1;  // Flag to track start of new line
     
-    while (content_pos < FS_MAX_FILESIZE - 1) {
-        // Poll for keyboard input
-        if (hal_keyboard_is_key_available()) {
-            int scancode = hal_keyboard_read();
-            
-            // Simple scancode to character conversion
-            char c = 0;
-            if (scancode >= 2 && scancode <= 13) {
-                // Digits 1-9, 0, -, =
-                if (scancode <= 11) {
-                    c = '0' + (scancode - 2 + 1) % 10;
-                } else if (scancode == 12) {
-                    c = '-';
-                } else {
-                    c = '=';
-                }
-            } else if (scancode >= 16 && scancode <= 27) {
-                // Letters Q-P
-                c = 'q' + (scancode - 16);
-            } else if (scancode >= 30 && scancode <= 40) {
-                // Letters A-L
-                c = 'a' + (scancode - 30);
-            } else if (scancode >= 44 && scancode <= 53) {
-                // Letters Z-M, comma, period, slash
-                if (scancode <= 50) {
-                    c = 'z' + (scancode - 44);
-                } else if (scancode == 51) {
-                    c = ',';
-                } else if (scancode == 52) {
-                    c = '.';
-                } else {
-                    c = '/';
-                }
-            } else if (scancode == 28) {
-                c = '\n';
-            } else if (scancode == 57) {
-                c = ' ';
+    while (content_pos < SHELL_WRITE_MAX - 1) {
+        key_event_t event;
+        hal_keyboard_wait_event(&event);
+        
+        char c = event.ascii;
+        if (c == 0x04) {
+            // Ctrl+D
+            break;
+        }
+        
+        if (c == '\n') {
+            // An empty line also ends input
+            if (line_start && content_pos > 0) {
+                break;
             }
             
-            if (c) {
-                if (c == '\n') {
-                    // Check for Ctrl+D at beginning of line
-                    if (line_start && content_pos > 0) {
-                        break;
-                    }
-                    
-                    line_start = 1;  // Next char will be at start of line
-                    content[content_pos++] = c;
-                    terminal_putchar(c);
-                } else {
-                    line_start = 0;  // No longer at start of line
-                    content[content_pos++] = c;
-                    terminal_putchar(c);
-                }
+            line_start = 1;  // Next char will be at start of line
+            content[content_pos++] = c;
+            terminal_putchar(c);
+        } else if (c == '\b') {
+            if (content_pos > 0 && content[content_pos - 1] != '\n') {
+                content_pos--;
+                terminal_write("\b \b", 3);
             }
+        } else if (c >= ' ' && c < 0x7F) {
+            line_start = 0;  // No longer at start of line
+            content[content_pos++] = c;
+            terminal_putchar(c);
         }
     }
     
@@ -1030,37 +989,28 @@ static int cmd_diag(int argc, char** argv) {
     terminal_writestring("  - Display: Functional\n");
     terminal_writestring("  - Storage: Functional (RAM Disk)\n");
     
+    // Interrupt controller state and latency
+    terminal_writestring("\n=== Interrupts ===\n");
+    interrupt_diag_print_pic_state();
+    interrupt_diag_print_latency();
+    hrtimer_print_stats();
+    softirq_print_stats();
+    
     terminal_writestring("\nDiagnostics completed.\n");
     return 0;
 }
 
 static int cmd_fsinfo(int argc, char** argv) {
-    // This would call the enhanced file system functions
-    // For now, just display placeholder information
     terminal_writestring("File System Information:\n");
     terminal_writestring("------------------------\n");
     terminal_writestring("Type: In-memory file system\n");
-    terminal_writestring("Max files: 64\n");
-    terminal_writestring("Max filename length: 32\n");
-    terminal_writestring("Max path length: 128\n");
-    terminal_writestring("Max file size: 8192 bytes\n");
-    
-    // These would be actual calls if we had implemented these functions
-    uint32_t hits = 0, misses = 0, flushes = 0;
-    uint32_t opens = 0, closes = 0, reads = 0, writes = 0, dirs = 0;
-    
-    terminal_writestring("\nCache Statistics:\n");
-    terminal_printf("  Hits: %d\n", hits);
-    terminal_printf("  Misses: %d\n", misses);
-    terminal_printf("  Flushes: %d\n", flushes);
-    
-    terminal_writestring("\nFile Operations:\n");
-    terminal_printf("  Opens: %d\n", opens);
-    terminal_printf("  Closes: %d\n", closes);
-    terminal_printf("  Reads: %d\n", reads);
-    terminal_printf("  Writes: %d\n", writes);
-    terminal_printf("  Directory Ops: %d\n", dirs);
+    terminal_printf("Max files: %d\n", FS_MAX_FILES);
+    terminal_printf("Max filename length: %d\n", FS_MAX_FILENAME);
+    terminal_printf("Max path length: %d\n", FS_MAX_PATH);
+    terminal_printf("Max file size: %d MB\n", FS_MAX_FILESIZE / (1024 * 1024));
+    terminal_writestring("\n");
     
+    fs_display_cache_info();
     return 0;
 }
 
@@ -1111,38 +1061,79 @@ static int cmd_diskdump(int argc, char** argv) {
         }
     }
     
-    // Check count boundaries
-    if (count > 10) {
-        terminal_writestring("Maximum dump count is 10 sectors\n");
-        count = 10;
-    }
+    // Through the buffer cache, like any other reader of the disk. Only
+    // the first sectors are printed; the rest are read as a scan, which
+    // the cache follows with read-ahead.
+    uint32_t shown = count < DISKDUMP_SHOWN ? count : DISKDUMP_SHOWN;
+    terminal_printf("Dumping %d sector(s) starting at sector %d:\n", shown, sector);
     
-    // This would call the hal_storage_dump function
-    // For now, just display placeholder information
-    terminal_printf("Dumping %d sector(s) starting at sector %d:\n", count, sector);
+    bcache_stats_t before;
+    bcache_get_stats(&before);
     
-    // Dummy data for demonstration
+    uint8_t data[BCACHE_SECTOR_SIZE];
     for (uint32_t s = 0; s < count; s++) {
+        if (bcache_read(BCACHE_DEV_STORAGE, sector + s, data, 1) != 0) {
+            terminal_printf("\nError reading sector %d\n", sector + s);
+            return 1;
+        }
+        if (s >= shown) {
+            continue;
+        }
+        
         terminal_printf("\nSector %d:\n", sector + s);
         for (int i = 0; i < 4; i++) {
             terminal_printf("%04x: ", i * 16);
             for (int j = 0; j < 16; j++) {
-                terminal_printf("%02x ", (i + j) % 256);
+                terminal_printf("%02x ", data[i * 16 + j]);
             }
-            terminal_writestring(" |");
+            char ascii[16];
             for (int j = 0; j < 16; j++) {
-                char c = (i + j) % 256;
-                if (c >= 32 && c <= 126) {
-                    terminal_putchar(c);
-                } else {
-                    terminal_putchar('.');
-                }
+                char c = data[i * 16 + j];
+                ascii[j] = (c >= 32 && c <= 126) ? c : '.';
             }
+            terminal_writestring(" |");
+            terminal_write(ascii, sizeof(ascii));
             terminal_writestring("|\n");
         }
         terminal_writestring("...\n");
     }
     
+    if (count > shown) {
+        bcache_stats_t after;
+        bcache_get_stats(&after);
+        terminal_printf("\nRead %d more sector(s): %d device reads, %d blocks read ahead, %d used\n",
+                        count - shown, after.dev_reads - before.dev_reads,
+                        after.ra_blocks - before.ra_blocks, after.ra_hits - before.ra_hits);
+    }
+    
+    return 0;
+}
+
+static int cmd_diskfill(int argc, char** argv) {
+    if (argc != 4) {
+        terminal_writestring("Usage: diskfill <sector> <count> <byte>\n");
+        return 1;
+    }
+    
+    // Large writes cover whole cache blocks, which need no read first
+    static uint8_t data[DISKFILL_SECTORS * BCACHE_SECTOR_SIZE];
+    uint32_t sector = atoi(argv[1]);
+    uint32_t count = atoi(argv[2]);
+    memset(data, atoi(argv[3]), sizeof(data));
+    
+    // Writes only dirty the cache; the flusher takes them to the disk
+    for (uint32_t s = 0; s < count; s += DISKFILL_SECTORS) {
+        uint32_t n = count - s < DISKFILL_SECTORS ? count - s : DISKFILL_SECTORS;
+        if (bcache_write(BCACHE_DEV_STORAGE, sector + s, data, n) != 0) {
+            terminal_printf("Error writing sectors %d-%d\n", sector + s, sector + s + n - 1);
+            return 1;
+        }
+    }
+    
+    bcache_stats_t stats;
+    bcache_get_stats(&stats);
+    terminal_printf("Filled %d sector(s) from sector %d, %d cache blocks dirty\n",
+                    count, sector, stats.dirty);
     return 0;
 }
 
@@ -1175,6 +1166,231 @@ static int cmd_sched(int argc, char** argv) {
     return 0;
 }
 
+static int cmd_trace(int argc, char** argv) {
+    if (argc < 2 || strcmp(argv[1], "status") == 0) {
+        trace_status();
+        if (argc < 2) {
+            terminal_writestring("Usage: trace <start|stop|clear|dump|status>\n");
+        }
+        return 0;
+    }
+    
+    if (strcmp(argv[1], "start") == 0) {
+        trace_start();
+    } else if (strcmp(argv[1], "stop") == 0) {
+        trace_stop();
+    } else if (strcmp(argv[1], "clear") == 0) {
+        trace_clear();
+    } else if (strcmp(argv[1], "dump") == 0) {
+        terminal_writestring("Streaming Chrome trace JSON over COM1...\n");
+        trace_dump_serial();
+        return 0;
+    } else {
+        terminal_writestring("Usage: trace <start|stop|clear|dump|status>\n");
+        return 1;
+    }
+    
+    trace_status();
+    return 0;
+}
+
+static int cmd_irqstat(int argc, char** argv) {
+    if (argc > 1) {
+        if (strcmp(argv[1], "reset") == 0) {
+            interrupt_reset_stats();
+            terminal_writestring("Interrupt counters reset\n");
+            return 0;
+        }
+        terminal_writestring("Usage: irqstat [reset]\n");
+        return 1;
+    }
+    
+    // Total cycles across all vectors, for the share column
+    uint64_t total_cycles = 0;
+    interrupt_stat_t stat;
+    for (uint32_t v = 0; v < 256; v++) {
+        interrupt_get_stat(v, &stat);
+        total_cycles += stat.cycles;
+    }
+    
+    // Scale both sides down so the percentage fits 32-bit math
+    uint32_t shift = 0;
+    while ((total_cycles >> shift) > 0x00FFFFFF) {
+        shift++;
+    }
+    uint32_t total_scaled = (uint32_t)(total_cycles >> shift);
+    
+    terminal_writestring("Vector  Source      Count       Avg cycles  Share\n");
+    terminal_writestring("------  ----------  ----------  ----------  -----\n");
+    for (uint32_t v = 0; v < 256; v++) {
+        interrupt_get_stat(v, &stat);
+        if (stat.count == 0) {
+            continue;
+        }
+        
+        uint32_t avg = (uint32_t)cpu_div64_32(stat.cycles, stat.count, NULL);
+        uint32_t share = total_scaled ?
+            (uint32_t)(stat.cycles >> shift) * 100 / total_scaled : 0;
+        
+        terminal_printf("%6d  ", v);
+        if (v < 32) {
+            terminal_printf("exc %2d      ", v);
+        } else if (v < 48) {
+            terminal_printf("IRQ%2d       ", v - 32);
+        } else if (v == SYSCALL_VECTOR) {
+            terminal_writestring("syscall     ");
+        } else {
+            terminal_writestring("software    ");
+        }
+        terminal_printf("%10d  %10d  %4d%%\n", stat.count, avg, share);
+    }
+    
+    terminal_printf("Spurious IRQ7/15: %d\n", interrupt_spurious_count());
+    return 0;
+}
+
+static int cmd_sysbench(int argc, char** argv) {
+    uint32_t iterations = 100000;
+    if (argc > 1) {
+        int n = atoi(argv[1]);
+        if (n <= 0) {
+            terminal_writestring("Usage: sysbench [iterations]\n");
+            return 1;
+        }
+        iterations = (uint32_t)n;
+    }
+    
+    if (syscall_benchmark(iterations) != 0) {
+        terminal_writestring("sysbench: needs a CPU with a time stamp counter\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int cmd_exec(int argc, char** argv) {
+    if (argc < 2) {
+        terminal_writestring("Usage: exec <program> [args...]\n");
+        return 1;
+    }
+    
+    vm_stats_t before, after;
+    vm_get_stats(&before);
+    
+    // The program sees its own path as argv[0]
+    // Negative statuses may also be load errors (SYSCALL_E*)
+    int status = sys_exec(argv[1], &argv[1]);
+    
+    vm_get_stats(&after);
+    terminal_printf("%s returned %d (%d page faults, %d from file)\n",
+                    argv[1], status, after.faults - before.faults,
+                    after.file_pages - before.file_pages);
+    return 0;
+}
+
+static int cmd_cachepolicy(int argc, char** argv) {
+    if (argc > 2) {
+        terminal_writestring("Usage: cachepolicy [lru|2q]\n");
+        return 1;
+    }
+    if (argc == 2) {
+        int policy = -1;
+        for (int i = 0; i < BCACHE_POLICIES; i++) {
+            if (strcmp(argv[1], bcache_policy_name(i)) == 0) {
+                policy = i;
+            }
+        }
+        if (policy < 0 || bcache_set_policy(policy) != 0) {
+            terminal_printf("cachepolicy: unknown policy %s\n", argv[1]);
+            return 1;
+        }
+    }
+    
+    // Counters restart on a switch, so this is the current policy's rate
+    bcache_stats_t stats;
+    bcache_get_stats(&stats);
+    uint32_t lookups = stats.hits + stats.misses;
+    terminal_printf("Buffer cache policy: %s\n", bcache_policy_name(stats.policy));
+    terminal_printf("Since selected: %d hits, %d misses (%d%% hit rate), %d evictions\n",
+                    stats.hits, stats.misses, lookups ? stats.hits * 100 / lookups : 0,
+                    stats.evictions);
+    return 0;
+}
+
+static int cmd_syscount(int argc, char** argv) {
+    // Process counters come back through SYS_PROCESS_INFO
+    static process_t info;
+    syscall_stat_t* stats = info.syscalls;
+    
+    if (argc > 2) {
+        terminal_writestring("Usage: syscount [pid|reset]\n");
+        return 1;
+    }
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        syscall_reset_stats();
+        terminal_writestring("System call counters reset\n");
+        return 0;
+    }
+    if (argc == 2) {
+        if (sys_process_info(atoi(argv[1]), &info) < 0) {
+            terminal_printf("syscount: no process %s\n", argv[1]);
+            return 1;
+        }
+        terminal_printf("System calls made by %d (%s):\n", info.pid, info.name);
+    } else {
+        for (uint32_t n = 0; n < SYSCALL_STATS_MAX; n++) {
+            syscall_get_stat(n, &stats[n]);
+        }
+    }
+    
+    uint64_t total_cycles = 0;
+    uint32_t total_calls = 0;
+    uint32_t total_errors = 0;
+    for (uint32_t n = 0; n < SYSCALL_STATS_MAX; n++) {
+        total_cycles += stats[n].cycles;
+        total_calls += stats[n].count;
+        total_errors += stats[n].errors;
+    }
+    
+    // Scale both sides down so the percentage fits 32-bit math
+    uint32_t shift = 0;
+    while ((total_cycles >> shift) > 0x00FFFFFF) {
+        shift++;
+    }
+    uint32_t total_scaled = (uint32_t)(total_cycles >> shift);
+    
+    terminal_writestring("% time  Avg cycles  Max cycles  Calls       Errors      Syscall\n");
+    terminal_writestring("------  ----------  ----------  ----------  ----------  ------------\n");
+    
+    // Most expensive first, like strace -c
+    uint32_t printed = 0;
+    for (;;) {
+        int best = -1;
+        for (uint32_t n = 0; n < SYSCALL_STATS_MAX; n++) {
+            if (stats[n].count && !(printed & (1u << n)) &&
+                (best < 0 || stats[n].cycles > stats[best].cycles)) {
+                best = n;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        printed |= 1u << best;
+        
+        syscall_stat_t* s = &stats[best];
+        uint32_t avg = (uint32_t)cpu_div64_32(s->cycles, s->count, NULL);
+        uint32_t share = total_scaled ?
+            (uint32_t)(s->cycles >> shift) * 100 / total_scaled : 0;
+        // Saturate for the signed %d column
+        uint32_t max = s->max_cycles > 0x7FFFFFFF ? 0x7FFFFFFF : (uint32_t)s->max_cycles;
+        terminal_printf("%5d%%  %10d  %10d  %10d  %10d  %s\n", share, avg, max,
+                        s->count, s->errors, syscall_name(best));
+    }
+    
+    terminal_writestring("------  ----------  ----------  ----------  ----------  ------------\n");
+    terminal_printf("                                %10d  %10d  total\n", total_calls, total_errors);
+    return 0;
+}
+
 static int cmd_history(int argc, char** argv) {
     if (history_count == 0) {
         terminal_writestring("No command history\n");
@@ -1355,9 +1571,7 @@ static int cmd_help(int argc, char** argv) {
             
             // Add padding spaces for alignment
             int padding = max_name_len + 2 - strlen(commands[i].name);
-            for (int j = 0; j < padding; j++) {
-                terminal_putchar(' ');
-            }
+            shell_write_repeat(' ', padding);
             
             terminal_writestring("- ");
             terminal_writestring(commands[i].description);
@@ -1379,9 +1593,7 @@ static int cmd_help(int argc, char** argv) {
             
             // Add padding spaces for alignment
             int padding = max_name_len + 2 - strlen(commands[i].name);
-            for (int j = 0; j < padding; j++) {
-                terminal_putchar(' ');
-            }
+            shell_write_repeat(' ', padding);
             
             terminal_writestring("- ");
             terminal_writestring(commands[i].description);
@@ -1404,9 +1616,7 @@ static int cmd_help(int argc, char** argv) {
             
             // Add padding spaces for alignment
             int padding = max_name_len + 2 - strlen(commands[i].name);
-            for (int j = 0; j < padding; j++) {
-                terminal_putchar(' ');
-            }
+            shell_write_repeat(' ', padding);
             
             terminal_writestring("- ");
             terminal_writestring(commands[i].description);
@@ -1416,15 +1626,19 @@ static int cmd_help(int argc, char** argv) {
     
     terminal_writestring("\nSystem Diagnostics:\n");
     for (int i = 0; commands[i].name != NULL; i++) {
-        if (strcmp(commands[i].name, "diag") == 0) {
+        if (strcmp(commands[i].name, "diag") == 0 ||
+            strcmp(commands[i].name, "trace") == 0 ||
+            strcmp(commands[i].name, "irqstat") == 0 ||
+            strcmp(commands[i].name, "sysbench") == 0 ||
+            strcmp(commands[i].name, "exec") == 0 ||
+            strcmp(commands[i].name, "cachepolicy") == 0 ||
+            strcmp(commands[i].name, "syscount") == 0) {
             terminal_writestring("  ");
             terminal_writestring(commands[i].name);
             
             // Add padding spaces for alignment
             int padding = max_name_len + 2 - strlen(commands[i].name);
-            for (int j = 0; j < padding; j++) {
-                terminal_putchar(' ');
-            }
+            shell_write_repeat(' ', padding);
             
             terminal_writestring("- ");
             terminal_writestring(commands[i].description);
@@ -1442,10 +1656,9 @@ void shell_run(void) {
     terminal_writestring("> ");
     
     while (1) {
-        // Poll for keyboard input
-        if (hal_keyboard_is_key_available()) {
-            int scancode = hal_keyboard_read();
-            shell_handle_key(scancode);
-        }
+        // Wait for keyboard input
+        key_event_t event;
+        hal_keyboard_wait_event(&event);
+        shell_handle_key_event(&event);
     }
 }
\ No newline at end of file
@@ -0,0 +1,241 @@
+// src/softirq.c
+#include "softirq.h"
+#include "interrupts.h"
+#include "hal_timer.h"
+#include "task.h"
+#include "trace.h"
+#include "terminal.h"
+#include "stdio.h"
+#include <stddef.h>
+
+// Actions and accounting, indexed by softirq type
+static softirq_action_t softirq_vec[SOFTIRQ_NR];
+static softirq_stat_t softirq_stats[SOFTIRQ_NR];
+
+// Pending mask, set from hard IRQ context
+static volatile uint32_t softirq_pending = 0;
+
+// Softirqs are running; nested interrupt exits leave them alone
+static int softirq_running = 0;
+
+// Work was handed to ksoftirqd; interrupt exits stop running softirqs
+// until it catches up
+static int softirq_deferred = 0;
+static uint64_t softirq_deferred_at = 0;
+static uint32_t softirq_deferrals = 0;
+
+// ksoftirqd task and the queue it sleeps on
+static task_t ksoftirqd_task;
+static wait_queue_t ksoftirqd_wq;
+
+// Tasklets waiting to run
+static tasklet_t* tasklet_head = NULL;
+static tasklet_t* tasklet_tail = NULL;
+
+// Run one softirq action and account for it
+static void softirq_run_action(uint32_t nr) {
+    softirq_stat_t* stat = &softirq_stats[nr];
+    
+    trace_event(TRACE_EV_SOFTIRQ_ENTRY, nr, 0);
+    uint64_t start = hal_timer_get_ns();
+    softirq_vec[nr]();
+    uint64_t elapsed = hal_timer_get_ns() - start;
+    trace_event(TRACE_EV_SOFTIRQ_EXIT, nr, 0);
+    
+    uint32_t ns = (elapsed >> 32) ? 0xFFFFFFFF : (uint32_t)elapsed;
+    stat->runs++;
+    stat->total_ns += elapsed;
+    if (ns > stat->max_ns) {
+        stat->max_ns = ns;
+    }
+    if (stat->budget_ns && ns > stat->budget_ns) {
+        stat->overruns++;
+    }
+}
+
+// Run pending softirqs with interrupts enabled. With a budget, stop
+// after SOFTIRQ_MAX_RESTART passes or budget_ns and return 1 if work is
+// left over.
+static int softirq_run(uint64_t budget_ns) {
+    uint64_t start = hal_timer_get_ns();
+    int restart = SOFTIRQ_MAX_RESTART;
+    
+    while (1) {
+        uint32_t flags = irq_save();
+        uint32_t pending = softirq_pending;
+        softirq_pending = 0;
+        irq_restore(flags);
+        
+        if (!pending) {
+            return 0;
+        }
+        
+        for (uint32_t nr = 0; nr < SOFTIRQ_NR; nr++) {
+            if ((pending & (1u << nr)) && softirq_vec[nr]) {
+                softirq_run_action(nr);
+            }
+        }
+        
+        if (budget_ns && (--restart == 0 || hal_timer_get_ns() - start >= budget_ns)) {
+            return softirq_pending != 0;
+        }
+    }
+}
+
+// Interrupt exit: interrupts are disabled on entry and on return
+void softirq_irq_exit(void) {
+    if (!softirq_pending || softirq_running) {
+        return;
+    }
+    
+    // Leave deferred work to ksoftirqd unless it has not been scheduled
+    // (the current task is busy or halting in place)
+    if (softirq_deferred && hal_timer_get_ns() - softirq_deferred_at < SOFTIRQ_DEFER_TIMEOUT_NS) {
+        return;
+    }
+    
+    softirq_running = 1;
+    asm volatile("sti" : : : "memory");
+    int overloaded = softirq_run(SOFTIRQ_EXIT_BUDGET_NS);
+    asm volatile("cli" : : : "memory");
+    softirq_running = 0;
+    
+    if (overloaded) {
+        if (!softirq_deferred) {
+            softirq_deferrals++;
+        }
+        softirq_deferred = 1;
+        softirq_deferred_at = hal_timer_get_ns();
+        wait_queue_wake_all(&ksoftirqd_wq);
+    }
+}
+
+// ksoftirqd: drain softirqs deferred by an overloaded interrupt exit,
+// one budgeted pass per scheduling round
+static int ksoftirqd_func(task_t* task) {
+    TASK_BEGIN(task);
+    while (1) {
+        TASK_WAIT_EVENT(task, &ksoftirqd_wq, softirq_deferred);
+        
+        while (softirq_pending) {
+            softirq_running = 1;
+            softirq_run(SOFTIRQ_EXIT_BUDGET_NS);
+            softirq_running = 0;
+            TASK_YIELD(task);
+        }
+        softirq_deferred = 0;
+    }
+    TASK_END(task);
+}
+
+// SOFTIRQ_TASKLET action
+static void tasklet_action(void) {
+    uint32_t flags = irq_save();
+    tasklet_t* list = tasklet_head;
+    tasklet_head = NULL;
+    tasklet_tail = NULL;
+    irq_restore(flags);
+    
+    while (list) {
+        tasklet_t* tasklet = list;
+        list = list->next;
+        
+        // Cleared first so the tasklet can be rescheduled while it runs
+        tasklet->next = NULL;
+        tasklet->scheduled = 0;
+        tasklet->func(tasklet->data);
+    }
+}
+
+void softirq_init(void) {
+    wait_queue_init(&ksoftirqd_wq);
+    open_softirq(SOFTIRQ_TASKLET, "tasklet", tasklet_action, 500000);
+    
+    task_init(&ksoftirqd_task, "ksoftirqd", ksoftirqd_func, NULL);
+    task_start(&ksoftirqd_task);
+}
+
+void open_softirq(uint32_t nr, const char* name, softirq_action_t action, uint32_t budget_ns) {
+    if (nr >= SOFTIRQ_NR) {
+        return;
+    }
+    
+    softirq_stats[nr].name = name;
+    softirq_stats[nr].budget_ns = budget_ns;
+    softirq_vec[nr] = action;
+}
+
+void raise_softirq(uint32_t nr) {
+    if (nr >= SOFTIRQ_NR) {
+        return;
+    }
+    
+    uint32_t flags = irq_save();
+    softirq_pending |= 1u << nr;
+    irq_restore(flags);
+}
+
+int softirq_get_stat(uint32_t nr, softirq_stat_t* stat) {
+    if (nr >= SOFTIRQ_NR || !stat) {
+        return -1;
+    }
+    
+    uint32_t flags = irq_save();
+    *stat = softirq_stats[nr];
+    irq_restore(flags);
+    return 0;
+}
+
+void softirq_print_stats(void) {
+    terminal_writestring("Softirq   Runs        Avg us  Max us  Budget us  Overruns\n");
+    terminal_writestring("--------  ----------  ------  ------  ---------  --------\n");
+    
+    for (uint32_t nr = 0; nr < SOFTIRQ_NR; nr++) {
+        softirq_stat_t stat;
+        softirq_get_stat(nr, &stat);
+        if (!stat.name) {
+            continue;
+        }
+        
+        uint32_t avg = stat.runs ? (uint32_t)cpu_div64_32(stat.total_ns, stat.runs, NULL) : 0;
+        terminal_printf("%s", stat.name);
+        int len = 0;
+        while (stat.name[len]) {
+            len++;
+        }
+        while (len++ < 10) {
+            terminal_putchar(' ');
+        }
+        terminal_printf("%10d  %6d  %6d  %9d  %8d\n", stat.runs, avg / 1000,
+                        stat.max_ns / 1000, stat.budget_ns / 1000, stat.overruns);
+    }
+    
+    terminal_printf("Pending: 0x%x, deferred to ksoftirqd: %d times%s\n",
+                    softirq_pending, softirq_deferrals,
+                    softirq_deferred ? " (active)" : "");
+}
+
+void tasklet_init(tasklet_t* tasklet, void (*func)(void* data), void* data) {
+    tasklet->next = NULL;
+    tasklet->scheduled = 0;
+    tasklet->func = func;
+    tasklet->data = data;
+}
+
+void tasklet_schedule(tasklet_t* tasklet) {
+    uint32_t flags = irq_save();
+    
+    if (!tasklet->scheduled) {
+        tasklet->scheduled = 1;
+        tasklet->next = NULL;
+        if (tasklet_tail) {
+            tasklet_tail->next = tasklet;
+        } else {
+            tasklet_head = tasklet;
+        }
+        tasklet_tail = tasklet;
+        softirq_pending |= 1u << SOFTIRQ_TASKLET;
+    }
+    
+    irq_restore(flags);
+}
@@ -309,10 +309,35 @@ int sscanf(const char* str, const char* format, ...) {
     return count;
 }
 
+// terminal_printf() output is staged here and handed to terminal_write()
+// in batches instead of one character at a time
+#define PRINTF_BUFFER_SIZE 128
+
+typedef struct {
+    char buf[PRINTF_BUFFER_SIZE];
+    size_t len;
+} printf_out_t;
+
+static void printf_flush(printf_out_t* out) {
+    if (out->len) {
+        terminal_write(out->buf, out->len);
+        out->len = 0;
+    }
+}
+
+static void printf_putc(printf_out_t* out, char c) {
+    if (out->len == PRINTF_BUFFER_SIZE) {
+        printf_flush(out);
+    }
+    out->buf[out->len++] = c;
+}
+
 // Terminal printf implementation
 void terminal_printf(const char* format, ...) {
     va_list args;
     va_start(args, format);
+    printf_out_t out;
+    out.len = 0;
     
     for (int i = 0; format[i] != '\0'; i++) {
         if (format[i] == '%') {
@@ -349,7 +374,7 @@ void terminal_printf(const char* format, ...) {
                     
                     // Handle negative numbers
                     if (val < 0) {
-                        terminal_putchar('-');
+                        printf_putc(&out, '-');
                         val = -val;
                         if (width > 0) width--; // Adjust width for minus sign
                     }
@@ -358,10 +383,10 @@ void terminal_printf(const char* format, ...) {
                     if (val == 0) {
                         if (width > 0) {
                             for (int j = 0; j < width - 1; j++) {
-                                terminal_putchar(padding_char);
+                                printf_putc(&out, padding_char);
                             }
                         }
-                        terminal_putchar('0');
+                        printf_putc(&out, '0');
                         break;
                     }
                     
@@ -376,7 +401,7 @@ void terminal_printf(const char* format, ...) {
                     // Add padding if needed
                     if (width > digits) {
                         for (int j = 0; j < width - digits; j++) {
-                            terminal_putchar(padding_char);
+                            printf_putc(&out, padding_char);
                         }
                     }
                     
@@ -390,7 +415,7 @@ void terminal_printf(const char* format, ...) {
                     
                     // Print in correct order
                     for (int j = index - 1; j >= 0; j--) {
-                        terminal_putchar(buffer[j]);
+                        printf_putc(&out, buffer[j]);
                     }
                     break;
                 }
@@ -407,18 +432,20 @@ void terminal_printf(const char* format, ...) {
                             // Add padding if needed
                             if (width > len) {
                                 for (int j = 0; j < width - len; j++) {
-                                    terminal_putchar(padding_char);
+                                    printf_putc(&out, padding_char);
                                 }
                             }
                         }
                         
                         // Output the string
                         while (*str) {
-                            terminal_putchar(*str++);
+                            printf_putc(&out, *str++);
                         }
                     } else {
                         // Handle NULL string
-                        terminal_writestring("(null)");
+                        for (const char* n = "(null)"; *n; n++) {
+                            printf_putc(&out, *n);
+                        }
                     }
                     break;
                 }
@@ -426,7 +453,7 @@ void terminal_printf(const char* format, ...) {
                 case 'c': {
                     // Character (char is promoted to int when passed through ...)
                     char c = (char)va_arg(args, int);
-                    terminal_putchar(c);
+                    printf_putc(&out, c);
                     break;
                 }
                 
@@ -438,10 +465,10 @@ void terminal_printf(const char* format, ...) {
                     if (val == 0) {
                         if (width > 0) {
                             for (int j = 0; j < width - 1; j++) {
-                                terminal_putchar(padding_char);
+                                printf_putc(&out, padding_char);
                             }
                         }
-                        terminal_putchar('0');
+                        printf_putc(&out, '0');
                         break;
                     }
                     
@@ -456,7 +483,7 @@ void terminal_printf(const char* format, ...) {
                     // Add padding if needed
                     if (width > digits) {
                         for (int j = 0; j < width - digits; j++) {
-                            terminal_putchar(padding_char);
+                            printf_putc(&out, padding_char);
                         }
                     }
                     
@@ -475,7 +502,7 @@ void terminal_printf(const char* format, ...) {
                     
                     // Print in correct order
                     for (int j = index - 1; j >= 0; j--) {
-                        terminal_putchar(buffer[j]);
+                        printf_putc(&out, buffer[j]);
                     }
                     break;
                 }
@@ -490,20 +517,21 @@ void terminal_printf(const char* format, ...) {
                 
                 case '%':
                     // Literal %
-                    terminal_putchar('%');
+                    printf_putc(&out, '%');
                     break;
                     
                 default:
                     // Unknown format, just output it
-                    terminal_putchar('%');
-                    terminal_putchar(format[i]);
+                    printf_putc(&out, '%');
+                    printf_putc(&out, format[i]);
                     break;
             }
         } else {
             // Regular character
-            terminal_putchar(format[i]);
+            printf_putc(&out, format[i]);
         }
     }
     
     va_end(args);
-}
\ No newline at end of file
+    printf_flush(&out);
+}
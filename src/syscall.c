@@ -8,6 +8,31 @@
 #include "kmalloc.h"
 #include "string.h"
 #include "hal.h"
+#include "trace.h"
+#include "hal_timer.h"
+#include "interrupts.h"
+#include "cpu.h"
+#include "gdt.h"
+#include "vdso.h"
+#include "file.h"
+#include "ioring.h"
+#include "uaccess.h"
+#include "elf.h"
+#include "channel.h"
+#include "pollset.h"
+#include <stddef.h>
+
+// Bounce buffer size for read and write
+#define SYSCALL_COPY_CHUNK 512
+
+// SYSENTER model-specific registers
+#define IA32_SYSENTER_CS  0x174
+#define IA32_SYSENTER_ESP 0x175
+#define IA32_SYSENTER_EIP 0x176
+
+// Entry points in syscall_entry.asm
+extern void sysenter_entry(void);
+extern void user_mode_resume(void);
 
 // Array of system call handlers
 static syscall_handler_t syscall_handlers[256] = {0};
@@ -15,6 +40,21 @@ static syscall_handler_t syscall_handlers[256] = {0};
 // Last error code
 static int last_error = SYSCALL_SUCCESS;
 
+// IA32_SYSENTER_* are programmed
+static int sysenter_enabled = 0;
+
+// System-wide per-call counters
+static syscall_stat_t syscall_stats[SYSCALL_STATS_MAX];
+
+// Names for the profile, indexed by call number
+static const char* const syscall_names[] = {
+    "null", "exit", "write", "read", "open", "close", "getpid", "fork",
+    "exec", "sleep", "time", "allocate", "free", "stat", "seek", "mkdir",
+    "rmdir", "chdir", "getcwd", "delete", "process_info", "ioring_setup",
+    "ioring_enter", "channel_open", "channel_notify", "channel_wait",
+    "channel_pages", "pollset_create", "pollset_ctl", "pollset_wait"
+};
+
 // Get the last error code
 int syscall_get_error(void) {
     return last_error;
@@ -25,8 +65,16 @@ void syscall_set_error(int error) {
     last_error = error;
 }
 
+// System call handler for the null call
+static int handle_sys_null(uint32_t unused1, uint32_t unused2, uint32_t unused3, uint32_t unused4) {
+    return 0;
+}
+
 // System call handler for exit
 static int handle_sys_exit(uint32_t status, uint32_t unused1, uint32_t unused2, uint32_t unused3) {
+    // A program started by SYS_EXEC never comes back from here
+    elf_exec_exit(status);
+    
     process_t* current = process_get_current();
     if (current) {
         // Set exit code and terminate
@@ -36,136 +84,133 @@ static int handle_sys_exit(uint32_t status, uint32_t unused1, uint32_t unused2,
     return 0;
 }
 
+// Turn a negative SYSCALL_E* result into -1 with the error recorded
+static int syscall_result(int result) {
+    if (result < 0) {
+        syscall_set_error(result);
+        return -1;
+    }
+    return result;
+}
+
+// Copy a path argument into a FS_MAX_PATH buffer; returns 0 or SYSCALL_E*
+static int syscall_get_path(uint32_t pathname, char* path) {
+    int len = strncpy_from_user(path, (const char*)pathname, FS_MAX_PATH);
+    return len < 0 ? len : 0;
+}
+
+// Result of a transfer that stopped early: the bytes moved so far, or the
+// error if nothing was
+static int syscall_partial(uint32_t done, int error) {
+    return syscall_result(done ? (int)done : error);
+}
+
 // System call handler for write
 static int handle_sys_write(uint32_t fd, uint32_t buf, uint32_t count, uint32_t unused) {
-    // Check if buffer is valid
-    if (!is_valid_access(buf, MEM_PROT_READ)) {
+    if (!access_ok(buf, count)) {
         syscall_set_error(SYSCALL_EFAULT);
         return -1;
     }
     
-    // Simplified file descriptor handling:
-    // fd 0 = stdin, fd 1 = stdout, fd 2 = stderr
-    if (fd == 1 || fd == 2) {
-        // Write to terminal
-        for (uint32_t i = 0; i < count; i++) {
-            terminal_putchar(((char*)buf)[i]);
-        }
-        return count;
-    } else {
-        // For now, just stub other file writes
-        // In a real implementation, we would use fs_write
-        syscall_set_error(SYSCALL_ENOSYS);
+    file_t* file = fd_get(fd);
+    if (!file) {
+        syscall_set_error(SYSCALL_EINVAL);
         return -1;
     }
+    
+    // Bounce through the kernel so a bad user page fails the copy, not the file code
+    char chunk[SYSCALL_COPY_CHUNK];
+    uint32_t done = 0;
+    while (done < count) {
+        uint32_t n = count - done < SYSCALL_COPY_CHUNK ? count - done : SYSCALL_COPY_CHUNK;
+        int error = copy_from_user(chunk, (const char*)buf + done, n);
+        if (error < 0) {
+            return syscall_partial(done, error);
+        }
+        
+        int written = file_write(file, chunk, n);
+        if (written < 0) {
+            return syscall_partial(done, written);
+        }
+        done += written;
+        if ((uint32_t)written < n) {
+            break;
+        }
+    }
+    return done;
 }
 
 // System call handler for read
 static int handle_sys_read(uint32_t fd, uint32_t buf, uint32_t count, uint32_t unused) {
-    // Check if buffer is valid
-    if (!is_valid_access(buf, MEM_PROT_WRITE)) {
+    if (!access_ok(buf, count)) {
         syscall_set_error(SYSCALL_EFAULT);
         return -1;
     }
     
-    // Simplified file descriptor handling
-    if (fd == 0) {
-        // Read from keyboard
-        uint32_t bytes_read = 0;
-        char* buffer = (char*)buf;
+    file_t* file = fd_get(fd);
+    if (!file) {
+        syscall_set_error(SYSCALL_EINVAL);
+        return -1;
+    }
+    
+    char chunk[SYSCALL_COPY_CHUNK];
+    uint32_t done = 0;
+    while (done < count) {
+        uint32_t n = count - done < SYSCALL_COPY_CHUNK ? count - done : SYSCALL_COPY_CHUNK;
+        int got = file_read(file, chunk, n);
+        if (got < 0) {
+            return syscall_partial(done, got);
+        }
         
-        while (bytes_read < count) {
-            // Use HAL keyboard functions for input
-            if (hal_keyboard_is_key_available()) {
-                int scancode = hal_keyboard_read();
-                
-                // Convert scancode to ASCII (simplified)
-                if (scancode >= 0 && scancode < 128) {
-                    // Very simple conversion - would need proper mapping table
-                    char c = 0;
-                    if (scancode >= 2 && scancode <= 11) {
-                        // Digits 1-0
-                        c = '0' + (scancode - 1) % 10;
-                    } else if (scancode >= 16 && scancode <= 25) {
-                        // Letters Q-P
-                        c = 'q' + (scancode - 16);
-                    } else if (scancode >= 30 && scancode <= 38) {
-                        // Letters A-L
-                        c = 'a' + (scancode - 30);
-                    } else if (scancode >= 44 && scancode <= 50) {
-                        // Letters Z-M
-                        c = 'z' + (scancode - 44);
-                    } else if (scancode == 57) {
-                        // Space
-                        c = ' ';
-                    } else if (scancode == 28) {
-                        // Enter
-                        c = '\n';
-                    }
-                    
-                    if (c) {
-                        buffer[bytes_read++] = c;
-                        
-                        // Echo to terminal
-                        terminal_putchar(c);
-                        
-                        // If newline or buffer full, we're done
-                        if (c == '\n' || bytes_read >= count) {
-                            break;
-                        }
-                    }
-                }
-            } else {
-                // No key available, yield to other processes
-                process_yield();
-            }
+        int error = copy_to_user((char*)buf + done, chunk, got);
+        if (error < 0) {
+            return syscall_partial(done, error);
         }
+        done += got;
         
-        return bytes_read;
-    } else {
-        // Read from file
-        // In a real implementation, we would use fs_read
-        syscall_set_error(SYSCALL_ENOSYS);
-        return -1;
+        // Short read: end of file, or the console returned a line
+        if ((uint32_t)got < n) {
+            break;
+        }
     }
+    return done;
 }
 
 // System call handler for open
 static int handle_sys_open(uint32_t pathname, uint32_t flags, uint32_t unused1, uint32_t unused2) {
-    // Check if pathname is valid
-    if (!is_valid_access(pathname, MEM_PROT_READ)) {
-        syscall_set_error(SYSCALL_EFAULT);
-        return -1;
+    char path[FS_MAX_PATH];
+    int error = syscall_get_path(pathname, path);
+    if (error < 0) {
+        return syscall_result(error);
     }
     
-    // Convert pathname to string
-    const char* path = (const char*)pathname;
-    
-    // Check if file exists
-    fs_node_t info;
-    if (fs_stat(path, &info) < 0) {
-        // File doesn't exist, create it if O_CREAT flag is set
-        if (flags & 0x40) { // 0x40 = O_CREAT
-            if (fs_create(path, FS_TYPE_FILE) < 0) {
-                syscall_set_error(SYSCALL_EACCES);
-                return -1;
-            }
-        } else {
-            syscall_set_error(SYSCALL_ENOENT);
-            return -1;
-        }
+    // Resolve the path once; later calls use the node cached in the file
+    file_t* file = file_open(path, flags, &error);
+    if (!file) {
+        return syscall_result(error);
     }
     
-    // For now, return a dummy file descriptor (we don't have proper fd table yet)
-    // In a real implementation, we would allocate a file descriptor
-    return 3; // First available fd after stdin/stdout/stderr
+    int fd = fd_install(file);
+    if (fd < 0) {
+        file_put(file);
+    }
+    return syscall_result(fd);
 }
 
 // System call handler for close
 static int handle_sys_close(uint32_t fd, uint32_t unused1, uint32_t unused2, uint32_t unused3) {
-    // For now, just return success
-    // In a real implementation, we would free the file descriptor
-    return 0;
+    return syscall_result(fd_close(fd));
+}
+
+// System call handler for seek
+static int handle_sys_seek(uint32_t fd, uint32_t offset, uint32_t whence, uint32_t unused) {
+    file_t* file = fd_get(fd);
+    if (!file) {
+        syscall_set_error(SYSCALL_EINVAL);
+        return -1;
+    }
+    
+    return syscall_result(file_seek(file, (int)offset, (int)whence));
 }
 
 // System call handler for getpid
@@ -208,7 +253,7 @@ static int handle_sys_free(uint32_t ptr, uint32_t unused1, uint32_t unused2, uin
     }
     
     // Validate pointer before freeing
-    if (!is_valid_access(ptr, MEM_PROT_READ | MEM_PROT_WRITE)) {
+    if (!access_ok(ptr, 1)) {
         syscall_set_error(SYSCALL_EFAULT);
         return -1;
     }
@@ -219,107 +264,93 @@ static int handle_sys_free(uint32_t ptr, uint32_t unused1, uint32_t unused2, uin
 
 // System call handler for file stat
 static int handle_sys_stat(uint32_t pathname, uint32_t stat_buf, uint32_t unused1, uint32_t unused2) {
-    // Check if pathname and stat_buf are valid
-    if (!is_valid_access(pathname, MEM_PROT_READ) || 
-        !is_valid_access(stat_buf, MEM_PROT_WRITE)) {
-        syscall_set_error(SYSCALL_EFAULT);
-        return -1;
+    char path[FS_MAX_PATH];
+    int error = syscall_get_path(pathname, path);
+    if (error < 0) {
+        return syscall_result(error);
     }
     
-    // Convert pathname to string
-    const char* path = (const char*)pathname;
-    
-    // Get file status
-    return fs_stat(path, (fs_node_t*)stat_buf);
+    // Only the public fields; the node also holds kernel pointers
+    fs_node_t* node = fs_lookup(path);
+    if (!node) {
+        return syscall_result(SYSCALL_ENOENT);
+    }
+    sys_stat_t st;
+    st.type = node->type;
+    st.size = node->size;
+    st.permissions = node->permissions;
+    st.created_time = node->created_time;
+    st.modified_time = node->modified_time;
+    return syscall_result(copy_to_user((void*)stat_buf, &st, sizeof(st)));
 }
 
 // System call handler for mkdir
 static int handle_sys_mkdir(uint32_t pathname, uint32_t unused1, uint32_t unused2, uint32_t unused3) {
-    // Check if pathname is valid
-    if (!is_valid_access(pathname, MEM_PROT_READ)) {
-        syscall_set_error(SYSCALL_EFAULT);
-        return -1;
+    char path[FS_MAX_PATH];
+    int error = syscall_get_path(pathname, path);
+    if (error < 0) {
+        return syscall_result(error);
     }
     
-    // Convert pathname to string
-    const char* path = (const char*)pathname;
-    
     // Create directory
-    return fs_mkdir(path);
+    return syscall_result(fs_mkdir(path) < 0 ? SYSCALL_ENOENT : 0);
 }
 
 // System call handler for rmdir (uses fs_delete for now)
 static int handle_sys_rmdir(uint32_t pathname, uint32_t unused1, uint32_t unused2, uint32_t unused3) {
-    // Check if pathname is valid
-    if (!is_valid_access(pathname, MEM_PROT_READ)) {
-        syscall_set_error(SYSCALL_EFAULT);
-        return -1;
+    char path[FS_MAX_PATH];
+    int error = syscall_get_path(pathname, path);
+    if (error < 0) {
+        return syscall_result(error);
     }
     
-    // Convert pathname to string
-    const char* path = (const char*)pathname;
-    
     // Delete directory (fs_delete handles both files and directories)
-    return fs_delete(path);
+    return syscall_result(fs_delete(path) < 0 ? SYSCALL_ENOENT : 0);
 }
 
 // System call handler for chdir
 static int handle_sys_chdir(uint32_t pathname, uint32_t unused1, uint32_t unused2, uint32_t unused3) {
-    // Check if pathname is valid
-    if (!is_valid_access(pathname, MEM_PROT_READ)) {
-        syscall_set_error(SYSCALL_EFAULT);
-        return -1;
+    char path[FS_MAX_PATH];
+    int error = syscall_get_path(pathname, path);
+    if (error < 0) {
+        return syscall_result(error);
     }
     
-    // Convert pathname to string
-    const char* path = (const char*)pathname;
-    
     // Change directory
-    return fs_chdir(path);
+    return syscall_result(fs_chdir(path) < 0 ? SYSCALL_ENOENT : 0);
 }
 
 // System call handler for getcwd
 static int handle_sys_getcwd(uint32_t buf, uint32_t size, uint32_t unused1, uint32_t unused2) {
-    // Check if buf is valid
-    if (!is_valid_access(buf, MEM_PROT_WRITE)) {
-        syscall_set_error(SYSCALL_EFAULT);
-        return 0;
-    }
-    
     // Get current directory
     const char* cwd = fs_getcwd();
     if (!cwd) {
         return 0;
     }
     
-    // Copy cwd to buf
-    strncpy((char*)buf, cwd, size);
+    // Copy cwd to buf, truncated like strncpy
+    uint32_t len = strlen(cwd) + 1;
+    if (copy_to_user((void*)buf, cwd, len < size ? len : size) < 0) {
+        syscall_set_error(SYSCALL_EFAULT);
+        return 0;
+    }
     return (uint32_t)buf;
 }
 
 // System call handler for file deletion
 static int handle_sys_delete(uint32_t pathname, uint32_t unused1, uint32_t unused2, uint32_t unused3) {
-    // Check if pathname is valid
-    if (!is_valid_access(pathname, MEM_PROT_READ)) {
-        syscall_set_error(SYSCALL_EFAULT);
-        return -1;
+    char path[FS_MAX_PATH];
+    int error = syscall_get_path(pathname, path);
+    if (error < 0) {
+        return syscall_result(error);
     }
     
-    // Convert pathname to string
-    const char* path = (const char*)pathname;
-    
     // Delete file
-    return fs_delete(path);
+    return syscall_result(fs_delete(path) < 0 ? SYSCALL_ENOENT : 0);
 }
 
 // System call handler for process info
 static int handle_sys_process_info(uint32_t pid, uint32_t info_buf, uint32_t unused1, uint32_t unused2) {
-    // Check if info_buf is valid
-    if (!is_valid_access(info_buf, MEM_PROT_WRITE)) {
-        syscall_set_error(SYSCALL_EFAULT);
-        return -1;
-    }
-    
     // Get process
     process_t* proc = process_get_by_pid(pid);
     if (!proc) {
@@ -327,8 +358,10 @@ static int handle_sys_process_info(uint32_t pid, uint32_t info_buf, uint32_t unu
         return -1;
     }
     
-    // Copy process info to buffer (simplified for now)
-    process_t* dest = (process_t*)info_buf;
+    // Build the public fields, then copy them out in one go
+    process_t info;
+    process_t* dest = &info;
+    memset(dest, 0, sizeof(info));
     dest->pid = proc->pid;
     dest->state = proc->state;
     dest->priority = proc->priority;
@@ -337,8 +370,158 @@ static int handle_sys_process_info(uint32_t pid, uint32_t info_buf, uint32_t unu
     dest->parent_pid = proc->parent_pid;
     dest->exit_code = proc->exit_code;
     strncpy(dest->name, proc->name, sizeof(dest->name));
+    memcpy(dest->syscalls, proc->syscalls, sizeof(dest->syscalls));
     
-    return 0;
+    return syscall_result(copy_to_user((void*)info_buf, dest, sizeof(info)));
+}
+
+// System call handler for exec: run a program and return its exit status
+static int handle_sys_exec(uint32_t pathname, uint32_t argv, uint32_t unused1, uint32_t unused2) {
+    char path[FS_MAX_PATH];
+    int error = syscall_get_path(pathname, path);
+    if (error < 0) {
+        return syscall_result(error);
+    }
+    
+    // Bring the argument strings into the kernel before the user window
+    // is replaced
+    char args[EXEC_MAX_ARGS][EXEC_MAX_ARGLEN];
+    char* kargv[EXEC_MAX_ARGS + 1];
+    uint32_t argc = 0;
+    while (argv && argc < EXEC_MAX_ARGS) {
+        uint32_t arg;
+        error = copy_from_user(&arg, (const void*)(argv + argc * sizeof(uint32_t)), sizeof(arg));
+        if (error < 0) {
+            return syscall_result(error);
+        }
+        if (!arg) {
+            break;
+        }
+        
+        error = strncpy_from_user(args[argc], (const char*)arg, EXEC_MAX_ARGLEN);
+        if (error < 0) {
+            return syscall_result(error);
+        }
+        kargv[argc] = args[argc];
+        argc++;
+    }
+    kargv[argc] = NULL;
+    
+    return syscall_result(elf_exec(path, kargv));
+}
+
+// System call handler for ring setup
+static int handle_sys_ioring_setup(uint32_t entries, uint32_t shared_out, uint32_t unused1, uint32_t unused2) {
+    if (!access_ok(shared_out, sizeof(ioring_shared_t*))) {
+        syscall_set_error(SYSCALL_EFAULT);
+        return -1;
+    }
+    
+    ioring_shared_t* shared;
+    int fd = ioring_setup(entries, &shared);
+    if (fd < 0) {
+        return syscall_result(fd);
+    }
+    
+    int error = copy_to_user((void*)shared_out, &shared, sizeof(shared));
+    if (error < 0) {
+        fd_close(fd);
+        return syscall_result(error);
+    }
+    return fd;
+}
+
+// System call handler for the ring doorbell
+static int handle_sys_ioring_enter(uint32_t fd, uint32_t to_submit, uint32_t min_complete, uint32_t unused) {
+    return syscall_result(ioring_enter(fd, to_submit, min_complete));
+}
+
+// System call handler for creating (slots > 0) or opening a channel
+static int handle_sys_channel_open(uint32_t name, uint32_t slots, uint32_t shared_out, uint32_t unused) {
+    char kname[CHANNEL_NAME_MAX];
+    int error = strncpy_from_user(kname, (const char*)name, sizeof(kname));
+    if (error < 0) {
+        return syscall_result(error);
+    }
+    if (!access_ok(shared_out, sizeof(channel_shared_t*))) {
+        return syscall_result(SYSCALL_EFAULT);
+    }
+    
+    channel_shared_t* shared;
+    int fd = channel_open(kname, slots, &shared);
+    if (fd < 0) {
+        return syscall_result(fd);
+    }
+    
+    error = copy_to_user((void*)shared_out, &shared, sizeof(shared));
+    if (error < 0) {
+        fd_close(fd);
+        return syscall_result(error);
+    }
+    return fd;
+}
+
+// System call handler for the channel doorbell
+static int handle_sys_channel_notify(uint32_t fd, uint32_t unused1, uint32_t unused2, uint32_t unused3) {
+    return syscall_result(channel_notify(fd));
+}
+
+// System call handler for waiting on a channel
+static int handle_sys_channel_wait(uint32_t fd, uint32_t condition, uint32_t timeout_ms, uint32_t unused) {
+    return syscall_result(channel_wait(fd, condition, timeout_ms));
+}
+
+// System call handler for moving pages through a channel
+static int handle_sys_channel_pages(uint32_t fd, uint32_t op, uint32_t addr, uint32_t len) {
+    return syscall_result(channel_pages(fd, op, addr, len));
+}
+
+// System call handler for creating a readiness set
+static int handle_sys_pollset_create(uint32_t unused1, uint32_t unused2, uint32_t unused3, uint32_t unused4) {
+    return syscall_result(pollset_create_fd());
+}
+
+// System call handler for adding, changing or removing a watch
+static int handle_sys_pollset_ctl(uint32_t fd, uint32_t op, uint32_t watch, uint32_t unused) {
+    poll_watch_t kwatch;
+    int error = copy_from_user(&kwatch, (const void*)watch, sizeof(kwatch));
+    if (error < 0) {
+        return syscall_result(error);
+    }
+    return syscall_result(pollset_ctl_fd(fd, op, &kwatch));
+}
+
+// System call handler for waiting on a readiness set
+static int handle_sys_pollset_wait(uint32_t fd, uint32_t events, uint32_t max, uint32_t timeout_ms) {
+    // Each watch reports at most once per wait
+    poll_event_t kevents[POLLSET_MAX_WATCHES];
+    if (max > POLLSET_MAX_WATCHES) {
+        max = POLLSET_MAX_WATCHES;
+    }
+    if (!access_ok(events, max * sizeof(poll_event_t))) {
+        return syscall_result(SYSCALL_EFAULT);
+    }
+    
+    int count = pollset_wait_fd(fd, kevents, max, timeout_ms);
+    if (count > 0) {
+        int error = copy_to_user((void*)events, kevents, count * sizeof(poll_event_t));
+        if (error < 0) {
+            return syscall_result(error);
+        }
+    }
+    return syscall_result(count);
+}
+
+// Charge one call to the system-wide and per-process counters
+static void syscall_account(syscall_stat_t* stat, int result, uint64_t cycles) {
+    stat->count++;
+    if (result < 0) {
+        stat->errors++;
+    }
+    stat->cycles += cycles;
+    if (cycles > stat->max_cycles) {
+        stat->max_cycles = cycles;
+    }
 }
 
 // System call dispatcher
@@ -352,8 +535,60 @@ int syscall_dispatch(uint32_t num, uint32_t param1, uint32_t param2, uint32_t pa
         return -1;
     }
     
+    // Charge the process that made the call, even if it exits or blocks
+    process_t* proc = process_get_current();
+    uint64_t start = interrupt_have_tsc ? cpu_read_tsc() : 0;
+    
     // Call system call handler
-    return syscall_handlers[num](param1, param2, param3, param4);
+    trace_event(TRACE_EV_SYSCALL_ENTRY, num, param1);
+    int result = syscall_handlers[num](param1, param2, param3, param4);
+    trace_event(TRACE_EV_SYSCALL_EXIT, num, (uint32_t)result);
+    
+    if (num < SYSCALL_STATS_MAX) {
+        // 64 bits: a blocking read can outlast 2^32 cycles
+        uint64_t cycles = interrupt_have_tsc ? cpu_read_tsc() - start : 0;
+        uint32_t flags = irq_save();
+        syscall_account(&syscall_stats[num], result, cycles);
+        if (proc) {
+            syscall_account(&proc->syscalls[num], result, cycles);
+        }
+        irq_restore(flags);
+    }
+    
+    return result;
+}
+
+int syscall_get_stat(uint32_t num, syscall_stat_t* stat) {
+    if (num >= SYSCALL_STATS_MAX) {
+        return -1;
+    }
+    
+    uint32_t flags = irq_save();
+    *stat = syscall_stats[num];
+    irq_restore(flags);
+    return 0;
+}
+
+void syscall_reset_stats(void) {
+    uint32_t flags = irq_save();
+    memset(syscall_stats, 0, sizeof(syscall_stats));
+    irq_restore(flags);
+}
+
+const char* syscall_name(uint32_t num) {
+    if (num < sizeof(syscall_names) / sizeof(syscall_names[0])) {
+        return syscall_names[num];
+    }
+    return "?";
+}
+
+// Entry from CPL 3: pointer arguments must name the user window
+int syscall_dispatch_user(uint32_t num, uint32_t param1, uint32_t param2, uint32_t param3, uint32_t param4) {
+    uint32_t saved = uaccess_user_origin;
+    uaccess_user_origin = 1;
+    int result = syscall_dispatch(num, param1, param2, param3, param4);
+    uaccess_user_origin = saved;
+    return result;
 }
 
 // Register a system call handler
@@ -363,16 +598,80 @@ void register_syscall(uint32_t num, syscall_handler_t handler) {
     }
 }
 
+// int 0x80: arguments and result travel in the saved registers
+static void syscall_interrupt(struct regs* r) {
+    // Calls may block; let interrupts in while they run
+    asm volatile("sti");
+    if ((r->cs & 3) == 3) {
+        r->eax = syscall_dispatch_user(r->eax, r->ebx, r->ecx, r->edx, r->esi);
+    } else {
+        r->eax = syscall_dispatch(r->eax, r->ebx, r->ecx, r->edx, r->esi);
+    }
+    asm volatile("cli");
+}
+
+// USER_RETURN_VECTOR: leave user_mode_call() by resuming at CPL 0
+static void user_return_interrupt(struct regs* r) {
+    if ((r->cs & 3) != 3) {
+        return;
+    }
+    
+    // Same-privilege IRET to user_mode_resume, which restores the stack
+    r->eip = (uint32_t)user_mode_resume;
+    r->cs = GDT_KERNEL_CODE;
+    r->ds = GDT_KERNEL_DATA;
+    r->es = GDT_KERNEL_DATA;
+    r->fs = GDT_KERNEL_DATA;
+    r->gs = GDT_KERNEL_DATA;
+    r->eflags &= ~0x200;
+}
+
+// Program the SYSENTER MSRs if the CPU really has the instruction
+static int syscall_sysenter_init(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpu_cpuid(1, &eax, &ebx, &ecx, &edx);
+    
+    if (!(edx & CPU_FEATURE_SEP) || !(edx & CPU_FEATURE_MSR)) {
+        return -1;
+    }
+    
+    // Early Pentium Pro parts report SEP without implementing it
+    uint32_t family = (eax >> 8) & 0xF;
+    uint32_t model = (eax >> 4) & 0xF;
+    uint32_t stepping = eax & 0xF;
+    if (family == 6 && model < 3 && stepping < 3) {
+        return -1;
+    }
+    
+    // The entry path only takes argument stacks in the user window,
+    // which needs paging
+    if (!paging_enabled()) {
+        return -1;
+    }
+    
+    cpu_write_msr(IA32_SYSENTER_CS, GDT_KERNEL_CODE);
+    cpu_write_msr(IA32_SYSENTER_ESP, gdt_trap_stack_top());
+    cpu_write_msr(IA32_SYSENTER_EIP, (uint32_t)sysenter_entry);
+    return 0;
+}
+
+int syscall_sysenter_available(void) {
+    return sysenter_enabled;
+}
+
 // Initialize system call interface
 void syscall_init(void) {
     terminal_writestring("Initializing system call interface\n");
     
     // Register system call handlers
+    register_syscall(SYS_NULL, handle_sys_null);
     register_syscall(SYS_EXIT, handle_sys_exit);
+    register_syscall(SYS_EXEC, handle_sys_exec);
     register_syscall(SYS_WRITE, handle_sys_write);
     register_syscall(SYS_READ, handle_sys_read);
     register_syscall(SYS_OPEN, handle_sys_open);
     register_syscall(SYS_CLOSE, handle_sys_close);
+    register_syscall(SYS_SEEK, handle_sys_seek);
     register_syscall(SYS_GETPID, handle_sys_getpid);
     register_syscall(SYS_SLEEP, handle_sys_sleep);
     register_syscall(SYS_TIME, handle_sys_time);
@@ -385,10 +684,135 @@ void syscall_init(void) {
     register_syscall(SYS_GETCWD, handle_sys_getcwd);
     register_syscall(SYS_DELETE, handle_sys_delete);
     register_syscall(SYS_PROCESS_INFO, handle_sys_process_info);
+    register_syscall(SYS_IORING_SETUP, handle_sys_ioring_setup);
+    register_syscall(SYS_IORING_ENTER, handle_sys_ioring_enter);
+    register_syscall(SYS_CHANNEL_OPEN, handle_sys_channel_open);
+    register_syscall(SYS_CHANNEL_NOTIFY, handle_sys_channel_notify);
+    register_syscall(SYS_CHANNEL_WAIT, handle_sys_channel_wait);
+    register_syscall(SYS_CHANNEL_PAGES, handle_sys_channel_pages);
+    register_syscall(SYS_POLLSET_CREATE, handle_sys_pollset_create);
+    register_syscall(SYS_POLLSET_CTL, handle_sys_pollset_ctl);
+    register_syscall(SYS_POLLSET_WAIT, handle_sys_pollset_wait);
+    
+    // Entry gates user mode may use
+    interrupt_register_handler(SYSCALL_VECTOR, syscall_interrupt);
+    interrupt_set_user_gate(SYSCALL_VECTOR);
+    interrupt_register_handler(USER_RETURN_VECTOR, user_return_interrupt);
+    interrupt_set_user_gate(USER_RETURN_VECTOR);
+    
+    sysenter_enabled = syscall_sysenter_init() == 0;
+    terminal_printf("System call entry: int 0x%x%s\n", SYSCALL_VECTOR,
+                    sysenter_enabled ? ", sysenter" : "");
     
     terminal_writestring("System call interface initialized\n");
 }
 
+// Benchmark state shared with the CPL 3 side
+typedef struct {
+    uint32_t iterations;
+    uint32_t sysenter;
+    uint32_t vdso;
+    uint64_t int80_cycles;
+    uint64_t sysenter_cycles;
+    uint64_t vdso_cycles;
+} bench_shared_t;
+
+// One page the CPL 3 side may touch: the shared state, then its stack.
+// With paging it is also mapped here, so the stack SYSENTER sees lies in
+// the user window; nothing else is there while the shell runs.
+#define BENCH_USER_ADDR USER_BASE
+
+static union {
+    bench_shared_t shared;
+    uint8_t raw[PAGE_SIZE];
+} bench_page __attribute__((aligned(PAGE_SIZE)));
+
+// Runs at CPL 3: time each entry path over the same number of calls
+static USER_TEXT int syscall_bench_user(void* arg) {
+    bench_shared_t* shared = (bench_shared_t*)arg;
+    
+    uint64_t start = cpu_read_tsc();
+    for (uint32_t i = 0; i < shared->iterations; i++) {
+        syscall_int80(SYS_NULL, 0, 0, 0, 0);
+    }
+    shared->int80_cycles = cpu_read_tsc() - start;
+    
+    if (shared->sysenter) {
+        start = cpu_read_tsc();
+        for (uint32_t i = 0; i < shared->iterations; i++) {
+            syscall_fast(SYS_NULL, 0, 0, 0, 0);
+        }
+        shared->sysenter_cycles = cpu_read_tsc() - start;
+    }
+    
+    // Trap-free clock read from the shared page, for comparison
+    if (shared->vdso) {
+        start = cpu_read_tsc();
+        for (uint32_t i = 0; i < shared->iterations; i++) {
+            vdso_clock_ns();
+        }
+        shared->vdso_cycles = cpu_read_tsc() - start;
+    }
+    return 0;
+}
+
+// Print one benchmark line as cycles and nanoseconds per call
+static void syscall_bench_report(const char* name, uint64_t cycles, uint32_t iterations) {
+    uint32_t tsc_khz = hal_timer_tsc_khz();
+    uint32_t per_call = (uint32_t)cpu_div64_32(cycles, iterations, NULL);
+    
+    terminal_printf("  %s %d cycles/call", name, per_call);
+    if (tsc_khz) {
+        terminal_printf(" (%d ns)", (uint32_t)cpu_div64_32((uint64_t)per_call * 1000000, tsc_khz, NULL));
+    }
+    terminal_writestring("\n");
+}
+
+int syscall_benchmark(uint32_t iterations) {
+    if (!(cpu_features() & CPU_FEATURE_TSC) || iterations == 0) {
+        return -1;
+    }
+    
+    // Baseline: the dispatcher called directly from the kernel
+    uint64_t start = cpu_read_tsc();
+    for (uint32_t i = 0; i < iterations; i++) {
+        syscall_dispatch(SYS_NULL, 0, 0, 0, 0);
+    }
+    uint64_t direct_cycles = cpu_read_tsc() - start;
+    
+    bench_shared_t* shared = &bench_page.shared;
+    memset(shared, 0, sizeof(*shared));
+    shared->iterations = iterations;
+    shared->sysenter = sysenter_enabled;
+    shared->vdso = paging_enabled();  // The page is only mapped with paging
+    
+    // Open the page to CPL 3 only for the run
+    uint32_t page = (uint32_t)&bench_page;
+    uint32_t user = paging_enabled() ? BENCH_USER_ADDR : page;
+    if (map_page(page, user, MEM_PROT_READ | MEM_PROT_WRITE | MEM_PROT_USER) != 0) {
+        return -1;
+    }
+    user_mode_call(syscall_bench_user, (void*)user, (void*)(user + PAGE_SIZE));
+    if (user != page) {
+        unmap_page(user);
+    } else {
+        map_page(page, page, MEM_PROT_READ | MEM_PROT_WRITE);
+    }
+    
+    terminal_printf("Null system call, %d calls:\n", iterations);
+    syscall_bench_report("direct    ", direct_cycles, iterations);
+    syscall_bench_report("int 0x80  ", shared->int80_cycles, iterations);
+    if (sysenter_enabled) {
+        syscall_bench_report("sysenter  ", shared->sysenter_cycles, iterations);
+    } else {
+        terminal_writestring("  sysenter   not supported by this CPU\n");
+    }
+    if (shared->vdso) {
+        syscall_bench_report("vdso clock", shared->vdso_cycles, iterations);
+    }
+    return 0;
+}
+
 // The following are wrapper functions that can be called by kernel code
 
 int sys_exit(int status) {
@@ -431,10 +855,14 @@ int sys_free(void* ptr) {
     return syscall_dispatch(SYS_FREE, (uint32_t)ptr, 0, 0, 0);
 }
 
-int sys_stat(const char* pathname, void* stat_buf) {
+int sys_stat(const char* pathname, sys_stat_t* stat_buf) {
     return syscall_dispatch(SYS_STAT, (uint32_t)pathname, (uint32_t)stat_buf, 0, 0);
 }
 
+int sys_seek(int fd, int offset, int whence) {
+    return syscall_dispatch(SYS_SEEK, fd, offset, whence, 0);
+}
+
 int sys_mkdir(const char* pathname) {
     return syscall_dispatch(SYS_MKDIR, (uint32_t)pathname, 0, 0, 0);
 }
@@ -457,4 +885,44 @@ int sys_delete(const char* pathname) {
 
 int sys_process_info(int pid, void* info_buf) {
     return syscall_dispatch(SYS_PROCESS_INFO, pid, (uint32_t)info_buf, 0, 0);
+}
+
+int sys_ioring_setup(uint32_t entries, void** shared_out) {
+    return syscall_dispatch(SYS_IORING_SETUP, entries, (uint32_t)shared_out, 0, 0);
+}
+
+int sys_ioring_enter(int fd, uint32_t to_submit, uint32_t min_complete) {
+    return syscall_dispatch(SYS_IORING_ENTER, fd, to_submit, min_complete, 0);
+}
+
+int sys_channel_open(const char* name, uint32_t slots, void** shared_out) {
+    return syscall_dispatch(SYS_CHANNEL_OPEN, (uint32_t)name, slots, (uint32_t)shared_out, 0);
+}
+
+int sys_channel_notify(int fd) {
+    return syscall_dispatch(SYS_CHANNEL_NOTIFY, fd, 0, 0, 0);
+}
+
+int sys_channel_wait(int fd, uint32_t condition, uint32_t timeout_ms) {
+    return syscall_dispatch(SYS_CHANNEL_WAIT, fd, condition, timeout_ms, 0);
+}
+
+int sys_channel_pages(int fd, uint32_t op, void* addr, uint32_t len) {
+    return syscall_dispatch(SYS_CHANNEL_PAGES, fd, op, (uint32_t)addr, len);
+}
+
+int sys_pollset_create(void) {
+    return syscall_dispatch(SYS_POLLSET_CREATE, 0, 0, 0, 0);
+}
+
+int sys_pollset_ctl(int fd, uint32_t op, const void* watch) {
+    return syscall_dispatch(SYS_POLLSET_CTL, fd, op, (uint32_t)watch, 0);
+}
+
+int sys_pollset_wait(int fd, void* events, uint32_t max, uint32_t timeout_ms) {
+    return syscall_dispatch(SYS_POLLSET_WAIT, fd, (uint32_t)events, max, timeout_ms);
+}
+
+int sys_exec(const char* pathname, char* const argv[]) {
+    return syscall_dispatch(SYS_EXEC, (uint32_t)pathname, (uint32_t)argv, 0, 0);
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+; src/syscall_entry.asm
+; SYSENTER fast system call path and the ring 3 trampoline
+
+[BITS 32]
+
+; Exports
+global sysenter_entry
+global syscall_sysenter
+global user_mode_call
+global user_mode_resume
+global user_mode_abort
+extern syscall_dispatch_user
+
+; Selectors (gdt.h)
+KERNEL_DATA_SEL     equ 0x10
+USER_CODE_SEL       equ 0x1B
+USER_DATA_SEL       equ 0x23
+
+; Gate that leaves user_mode_call() (syscall.h)
+USER_RETURN_VECTOR  equ 0x81
+
+; User window (memory.h) and the error for a bad user stack (syscall.h)
+USER_BASE           equ 0x40000000
+USER_TOP            equ 0x80000000
+SYSCALL_EFAULT      equ -6
+
+; Code that runs at CPL 3 goes on the user text page (linker.ld), the
+; only kernel image page user mode may execute
+section .user_text progbits alloc exec nowrite align=16
+
+; User side of the fast path. Same registers as int 0x80: EAX = number,
+; EBX/ECX/EDX/ESI = arguments, result in EAX. SYSEXIT returns through
+; EDX/ECX, so both are saved on the user stack and EBP points at them.
+syscall_sysenter:
+    push ecx
+    push edx
+    push ebp
+    mov ebp, esp
+    sysenter
+sysenter_return:
+    pop ebp
+    pop edx
+    pop ecx
+    ret
+
+; CPL 3: func returned with its result in EAX
+user_mode_exit:
+    int USER_RETURN_VECTOR
+    jmp user_mode_exit
+
+section .text
+
+; Kernel side: CS/SS from IA32_SYSENTER_CS, ESP from IA32_SYSENTER_ESP,
+; interrupts disabled. User ESP is in EBP.
+sysenter_entry:
+    push ebp
+    mov cx, KERNEL_DATA_SEL
+    mov ds, cx
+    mov es, cx
+
+    ; The saved EDX/ECX at [ebp+4, ebp+12) must lie in the user window
+    cmp ebp, USER_BASE
+    jb sysenter_bad_stack
+    cmp ebp, USER_TOP - 12
+    ja sysenter_bad_stack
+    sti
+
+    ; syscall_dispatch_user(num, arg1, arg2, arg3, arg4). The two loads
+    ; may fault on an unmapped user page; __ex_table sends them to
+    ; sysenter_fault_edx/ecx.
+    push esi
+sysenter_load_edx:
+    push dword [ebp+4]  ; Saved EDX
+sysenter_load_ecx:
+    push dword [ebp+8]  ; Saved ECX
+    push ebx
+    push eax
+    call syscall_dispatch_user
+    add esp, 20
+
+sysenter_exit:
+    cli
+    pop ebp
+    mov cx, USER_DATA_SEL
+    mov ds, cx
+    mov es, cx
+    mov edx, sysenter_return
+    mov ecx, ebp
+    ; The STI shadow covers SYSEXIT, so no interrupt arrives in between
+    sti
+    sysexit
+
+sysenter_bad_stack:
+    mov eax, SYSCALL_EFAULT
+    jmp sysenter_exit
+
+section .fixup progbits alloc exec nowrite align=1
+
+; Drop what was pushed before the faulting load and fail the call
+sysenter_fault_edx:
+    add esp, 4
+    mov eax, SYSCALL_EFAULT
+    jmp sysenter_exit
+sysenter_fault_ecx:
+    add esp, 8
+    mov eax, SYSCALL_EFAULT
+    jmp sysenter_exit
+
+section __ex_table progbits alloc noexec nowrite align=4
+    dd sysenter_load_edx, sysenter_fault_edx
+    dd sysenter_load_ecx, sysenter_fault_ecx
+
+; int user_mode_call(int (*func)(void*), void* arg, void* stack_top)
+; Run func(arg) at CPL 3 on the given stack and return its result
+section .data
+align 4
+user_mode_saved_esp: dd 0
+
+section .text
+user_mode_call:
+    push ebp
+    push ebx
+    push esi
+    push edi
+    pushfd
+    mov [user_mode_saved_esp], esp
+
+    mov eax, [esp+24]   ; func
+    mov ecx, [esp+28]   ; arg
+    mov edx, [esp+32]   ; stack_top
+
+    ; User stack: argument and a return address into user_mode_exit
+    sub edx, 8
+    mov [edx+4], ecx
+    mov dword [edx], user_mode_exit
+
+    ; IRET frame for CPL 3 with interrupts enabled
+    cli
+    push USER_DATA_SEL
+    push edx
+    pushfd
+    or dword [esp], 0x200
+    push USER_CODE_SEL
+    push eax
+
+    mov ax, USER_DATA_SEL
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    iret
+
+; CPL 0: the USER_RETURN_VECTOR handler points the interrupt frame here
+; with kernel segments loaded and EAX intact
+user_mode_resume:
+    mov esp, [user_mode_saved_esp]
+    popfd
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
+
+; void user_mode_abort(int result)
+; CPL 0, in a system call or exception taken from the CPL 3 side: drop
+; that context and return result from user_mode_call()
+user_mode_abort:
+    mov eax, [esp+4]
+    mov cx, KERNEL_DATA_SEL
+    mov ds, cx
+    mov es, cx
+    mov fs, cx
+    mov gs, cx
+    jmp user_mode_resume
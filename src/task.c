@@ -0,0 +1,384 @@
+// src/task.c
+#include "task.h"
+#include "kmalloc.h"
+#include "stdio.h"
+#include "terminal.h"
+#include "interrupts.h"
+#include "hal_timer.h"
+#include "trace.h"
+#include <stddef.h>
+
+// Maximum tasks tracked for task_list()
+#define TASK_MAX_TRACKED 256
+
+// Run queue (FIFO)
+static task_t* run_head = NULL;
+static task_t* run_tail = NULL;
+
+// Task whose body is currently executing
+static task_t* running_task = NULL;
+
+// Tasks known to the runtime, for diagnostics
+static task_t* task_registry[TASK_MAX_TRACKED];
+static uint32_t task_count = 0;
+
+// Runtime statistics
+static uint32_t total_resumes = 0;
+static uint32_t idle_passes = 0;
+
+// Append a task to the run queue (interrupts must be disabled)
+static void task_enqueue(task_t* task) {
+    task->next = NULL;
+    if (run_tail) {
+        run_tail->next = task;
+    } else {
+        run_head = task;
+    }
+    run_tail = task;
+}
+
+// Take the first task off the run queue
+static task_t* task_dequeue(void) {
+    uint32_t flags = irq_save();
+    task_t* task = run_head;
+    
+    if (task) {
+        run_head = task->next;
+        if (!run_head) {
+            run_tail = NULL;
+        }
+        task->next = NULL;
+    }
+    
+    irq_restore(flags);
+    return task;
+}
+
+// Unlink a task from the run queue (interrupts must be disabled)
+static void task_unlink_runnable(task_t* task) {
+    task_t* prev = NULL;
+    task_t* cur = run_head;
+    
+    while (cur && cur != task) {
+        prev = cur;
+        cur = cur->next;
+    }
+    
+    if (!cur) {
+        return;
+    }
+    
+    if (prev) {
+        prev->next = cur->next;
+    } else {
+        run_head = cur->next;
+    }
+    if (run_tail == cur) {
+        run_tail = prev;
+    }
+    cur->next = NULL;
+}
+
+// Disarm a task's sleep timer (interrupts must be disabled)
+static void task_unlink_sleeper(task_t* task) {
+    if (!(task->flags & TASK_FLAG_SLEEPING)) {
+        return;
+    }
+    
+    hrtimer_cancel(&task->timer);
+    task->flags &= ~TASK_FLAG_SLEEPING;
+}
+
+// Sleep timer callback (interrupt context): make the task runnable
+static void task_timer_expired(hrtimer_t* timer) {
+    task_t* task = (task_t*)timer->data;
+    
+    task->flags &= ~TASK_FLAG_SLEEPING;
+    task_wake(task);
+}
+
+// Wait queue callback: make the owning task runnable
+static void task_wait_wake(wait_queue_entry_t* entry) {
+    task_wake((task_t*)entry->owner);
+}
+
+// Remember a task for task_list()
+static void task_register(task_t* task) {
+    for (uint32_t i = 0; i < task_count; i++) {
+        if (task_registry[i] == task) {
+            return;
+        }
+    }
+    if (task_count < TASK_MAX_TRACKED) {
+        task_registry[task_count++] = task;
+    }
+}
+
+// Forget a task
+static void task_unregister(task_t* task) {
+    for (uint32_t i = 0; i < task_count; i++) {
+        if (task_registry[i] == task) {
+            task_registry[i] = task_registry[--task_count];
+            return;
+        }
+    }
+}
+
+// Initialize the task runtime
+void task_runtime_init(void) {
+    run_head = NULL;
+    run_tail = NULL;
+    running_task = NULL;
+    task_count = 0;
+    total_resumes = 0;
+    idle_passes = 0;
+}
+
+// Initialize a caller-owned task
+void task_init(task_t* task, const char* name, task_func_t func, void* arg) {
+    task->lc = 0;
+    task->state = TASK_STATE_DONE;
+    task->flags = 0;
+    task->name = name;
+    task->func = func;
+    task->arg = arg;
+    task->resumes = 0;
+    task->next = NULL;
+    task->waiting_on = NULL;
+    hrtimer_init(&task->timer, task_timer_expired, task);
+    wait_queue_entry_init(&task->wait, task_wait_wake, task);
+}
+
+// Put an initialized task on the run queue
+int task_start(task_t* task) {
+    if (!task || !task->func || task->state != TASK_STATE_DONE) {
+        return -1;
+    }
+    
+    uint32_t flags = irq_save();
+    task->lc = 0;
+    task->state = TASK_STATE_READY;
+    task_enqueue(task);
+    irq_restore(flags);
+    
+    task_register(task);
+    return 0;
+}
+
+// Allocate, initialize and start a task
+task_t* task_spawn(const char* name, task_func_t func, void* arg) {
+    task_t* task = (task_t*)kmalloc(sizeof(task_t));
+    if (!task) {
+        return NULL;
+    }
+    
+    task_init(task, name, func, arg);
+    task->flags |= TASK_FLAG_ALLOCATED;
+    
+    if (task_start(task) != 0) {
+        kfree(task);
+        return NULL;
+    }
+    return task;
+}
+
+// Make a waiting task runnable
+void task_wake(task_t* task) {
+    uint32_t flags = irq_save();
+    
+    if (task->state == TASK_STATE_WAITING) {
+        task->state = TASK_STATE_READY;
+        trace_event(TRACE_EV_TASK_WAKEUP, (uint32_t)task, (uint32_t)task->name);
+        // A task woken from inside its own body is requeued by the
+        // runtime when the body returns
+        if (task != running_task) {
+            task_enqueue(task);
+        }
+    }
+    
+    irq_restore(flags);
+}
+
+// Detach a task from everything it may be linked on and mark it done
+static void task_retire(task_t* task) {
+    uint32_t flags = irq_save();
+    task_unlink_runnable(task);
+    task_unlink_sleeper(task);
+    task->state = TASK_STATE_DONE;
+    irq_restore(flags);
+    
+    if (task->waiting_on) {
+        wait_queue_remove(task->waiting_on, &task->wait);
+        task->waiting_on = NULL;
+    }
+    
+    task_unregister(task);
+    if (task->flags & TASK_FLAG_ALLOCATED) {
+        kfree(task);
+    }
+}
+
+// Stop a task and detach it from the runtime
+void task_kill(task_t* task) {
+    if (!task || task->state == TASK_STATE_DONE) {
+        return;
+    }
+    
+    if (task == running_task) {
+        // Retired by the runtime once the body returns
+        task->lc = 0;
+        task->func = NULL;
+        return;
+    }
+    
+    task_retire(task);
+}
+
+// Get the task whose body is currently executing
+task_t* task_current(void) {
+    return running_task;
+}
+
+// Arm the task's timer (suspension helper)
+void task_sleep_prepare_ns(task_t* task, uint64_t ns) {
+    uint32_t flags = irq_save();
+    
+    task->state = TASK_STATE_WAITING;
+    if (hrtimer_start_relative(&task->timer, ns) == 0) {
+        task->flags |= TASK_FLAG_SLEEPING;
+    } else {
+        // No timer slot: degrade to a yield rather than sleep forever
+        task->flags &= ~TASK_FLAG_SLEEPING;
+        task->state = TASK_STATE_READY;
+    }
+    
+    irq_restore(flags);
+}
+
+void task_sleep_prepare(task_t* task, uint32_t ms) {
+    task_sleep_prepare_ns(task, ms * NSEC_PER_MSEC);
+}
+
+// Park the task on a wait queue (suspension helper)
+void task_wait_prepare(task_t* task, wait_queue_t* wq) {
+    uint32_t flags = irq_save();
+    task->state = TASK_STATE_WAITING;
+    irq_restore(flags);
+    
+    task->waiting_on = wq;
+    wait_queue_add(wq, &task->wait);
+}
+
+// Undo task_wait_prepare() once the condition holds (suspension helper)
+void task_wait_finish(task_t* task, wait_queue_t* wq) {
+    wait_queue_remove(wq, &task->wait);
+    task->waiting_on = NULL;
+    
+    uint32_t flags = irq_save();
+    task_unlink_sleeper(task);
+    task->state = TASK_STATE_RUNNING;
+    irq_restore(flags);
+}
+
+// Run every runnable task once
+int task_run_pending(void) {
+    // Bound the pass by the tasks queued now so a yielding task
+    // cannot starve the others
+    uint32_t budget = 0;
+    uint32_t flags = irq_save();
+    for (task_t* t = run_head; t; t = t->next) {
+        budget++;
+    }
+    irq_restore(flags);
+    
+    int ran = 0;
+    while (budget-- > 0) {
+        task_t* task = task_dequeue();
+        if (!task) {
+            break;
+        }
+        
+        if (!task->func) {
+            task_retire(task);
+            continue;
+        }
+        
+        task->state = TASK_STATE_RUNNING;
+        running_task = task;
+        trace_event(TRACE_EV_TASK_BEGIN, (uint32_t)task, (uint32_t)task->name);
+        int result = task->func(task);
+        trace_event(TRACE_EV_TASK_END, (uint32_t)task, result);
+        running_task = NULL;
+        
+        task->resumes++;
+        total_resumes++;
+        ran++;
+        
+        if (result == TASK_EXITED || !task->func) {
+            task_retire(task);
+            continue;
+        }
+        
+        flags = irq_save();
+        if (result == TASK_YIELDED) {
+            task->state = TASK_STATE_READY;
+            task_enqueue(task);
+        } else if (task->state == TASK_STATE_READY) {
+            // Woken while it was still running
+            task_enqueue(task);
+        }
+        irq_restore(flags);
+    }
+    
+    return ran;
+}
+
+// Run tasks forever on the calling kernel thread
+void task_run_loop(void) {
+    while (1) {
+        if (task_run_pending() > 0) {
+            continue;
+        }
+        
+        // Nothing ran: sleep until the next interrupt. The run queue is
+        // checked with interrupts off and "sti; hlt" cannot be split, so
+        // a wakeup arriving in between is not slept through.
+        idle_passes++;
+        uint32_t flags = irq_save();
+        if (!run_head) {
+            irq_enable_and_halt();
+        }
+        irq_restore(flags);
+    }
+}
+
+// Print the task list
+void task_list(void) {
+    static const char* state_names[] = { "READY", "RUN", "WAIT", "DONE" };
+    
+    terminal_printf("Tasks: %d, resumes: %d, idle passes: %d\n",
+                    task_count, total_resumes, idle_passes);
+    terminal_writestring("NAME                STATE  RESUMES   WAKE\n");
+    
+    for (uint32_t i = 0; i < task_count; i++) {
+        task_t* task = task_registry[i];
+        terminal_printf("%s", task->name ? task->name : "?");
+        
+        int len = 0;
+        for (const char* p = task->name; p && *p; p++) {
+            len++;
+        }
+        while (len++ < 20) {
+            terminal_putchar(' ');
+        }
+        
+        terminal_printf("%s", state_names[task->state & 3]);
+        terminal_printf("   %d", task->resumes);
+        if (task->flags & TASK_FLAG_SLEEPING) {
+            uint64_t now = hal_timer_get_ns();
+            uint64_t left = task->timer.expires > now ? task->timer.expires - now : 0;
+            terminal_printf("   %d us", (uint32_t)cpu_div64_32(left, 1000, NULL));
+        }
+        terminal_putchar('\n');
+    }
+}
@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include "terminal.h"
+#include "io.h"
 
 enum vga_color {
     VGA_COLOR_BLACK = 0,
@@ -22,6 +23,8 @@ static size_t terminal_column;
 static uint8_t terminal_color;
 static uint16_t* terminal_buffer;
 
+static void terminal_update_cursor(void);
+
 void terminal_initialize(void) {
     terminal_row = 0;
     terminal_column = 0;
@@ -47,59 +50,145 @@ void terminal_clear(void) {
     terminal_column = 0;
 }
 
-void terminal_putchar(char c) {
-    unsigned char uc = c;
+// Hardware cursor registers (CRT controller)
+#define VGA_CRTC_INDEX 0x3D4
+#define VGA_CRTC_DATA  0x3D5
+
+// Move the blinking hardware cursor to the current position
+static void terminal_update_cursor(void) {
+    uint16_t pos = terminal_row * VGA_WIDTH + terminal_column;
+    outb(VGA_CRTC_INDEX, 0x0F);
+    outb(VGA_CRTC_DATA, pos & 0xFF);
+    outb(VGA_CRTC_INDEX, 0x0E);
+    outb(VGA_CRTC_DATA, pos >> 8);
+}
+
+// Move the screen up by lines rows in one pass and blank the rows exposed
+static void terminal_scroll_lines(size_t lines) {
+    if (lines > VGA_HEIGHT) {
+        lines = VGA_HEIGHT;
+    }
     
-    // Handle special characters
-    if (c == '\n') {
-        terminal_column = 0;
-        if (++terminal_row == VGA_HEIGHT) {
-            terminal_scroll();
-        }
+    const size_t keep = (VGA_HEIGHT - lines) * VGA_WIDTH;
+    const size_t shift = lines * VGA_WIDTH;
+    for (size_t i = 0; i < keep; i++) {
+        terminal_buffer[i] = terminal_buffer[i + shift];
+    }
+    
+    const uint16_t blank = vga_entry(' ', terminal_color);
+    for (size_t i = keep; i < VGA_HEIGHT * VGA_WIDTH; i++) {
+        terminal_buffer[i] = blank;
+    }
+}
+
+static void terminal_backspace(void) {
+    if (terminal_column > 0) {
+        terminal_column--;
+    } else if (terminal_row > 0) {
+        terminal_row--;
+        terminal_column = VGA_WIDTH - 1;
+    } else {
         return;
-    } else if (c == '\b') {
-        if (terminal_column > 0) {
-            terminal_column--;
-            terminal_buffer[terminal_row * VGA_WIDTH + terminal_column] = vga_entry(' ', terminal_color);
-        } else if (terminal_row > 0) {
-            terminal_row--;
-            terminal_column = VGA_WIDTH - 1;
-            terminal_buffer[terminal_row * VGA_WIDTH + terminal_column] = vga_entry(' ', terminal_color);
+    }
+    terminal_buffer[terminal_row * VGA_WIDTH + terminal_column] = vga_entry(' ', terminal_color);
+}
+
+// Write a span holding no backspaces. The rows it will push off the
+// screen are counted first and scrolled away at once; text that would
+// land in them is skipped since it would be scrolled out anyway.
+static void terminal_write_span(const char* data, size_t len) {
+    // Row the cursor ends on if the screen had no bottom
+    size_t row = terminal_row;
+    size_t column = terminal_column;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == '\n') {
+            column = 0;
+            row++;
+        } else if (++column == VGA_WIDTH) {
+            column = 0;
+            row++;
         }
-        return;
     }
     
-    terminal_buffer[terminal_row * VGA_WIDTH + terminal_column] = vga_entry(uc, terminal_color);
-    if (++terminal_column == VGA_WIDTH) {
-        terminal_column = 0;
-        if (++terminal_row == VGA_HEIGHT) {
-            terminal_scroll();
+    size_t scroll = row >= VGA_HEIGHT ? row - (VGA_HEIGHT - 1) : 0;
+    if (scroll) {
+        terminal_scroll_lines(scroll);
+    }
+    
+    // Rows above 0 are the ones just scrolled off
+    int vrow = (int)terminal_row - (int)scroll;
+    column = terminal_column;
+    
+    size_t i = 0;
+    while (i < len) {
+        if (data[i] == '\n') {
+            column = 0;
+            vrow++;
+            i++;
+            continue;
+        }
+        
+        // Copy the run up to the next newline or the end of the row
+        size_t run = 0;
+        while (i + run < len && data[i + run] != '\n' && column + run < VGA_WIDTH) {
+            run++;
+        }
+        
+        if (vrow >= 0) {
+            uint16_t* out = &terminal_buffer[vrow * VGA_WIDTH + column];
+            for (size_t j = 0; j < run; j++) {
+                out[j] = vga_entry((unsigned char)data[i + j], terminal_color);
+            }
+        }
+        
+        i += run;
+        column += run;
+        if (column == VGA_WIDTH) {
+            column = 0;
+            vrow++;
         }
     }
+    
+    terminal_row = vrow;
+    terminal_column = column;
 }
 
-// Add scrolling function to terminal.c
-void terminal_scroll(void) {
-    // Move each line up one position
-    for (size_t y = 0; y < VGA_HEIGHT - 1; y++) {
-        for (size_t x = 0; x < VGA_WIDTH; x++) {
-            const size_t dst_index = y * VGA_WIDTH + x;
-            const size_t src_index = (y + 1) * VGA_WIDTH + x;
-            terminal_buffer[dst_index] = terminal_buffer[src_index];
+void terminal_write(const char* data, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        if (data[i] == '\b') {
+            terminal_backspace();
+            i++;
+            continue;
+        }
+        
+        size_t end = i;
+        while (end < len && data[end] != '\b') {
+            end++;
         }
+        terminal_write_span(data + i, end - i);
+        i = end;
     }
     
-    // Clear the last line
-    for (size_t x = 0; x < VGA_WIDTH; x++) {
-        const size_t index = (VGA_HEIGHT - 1) * VGA_WIDTH + x;
-        terminal_buffer[index] = vga_entry(' ', terminal_color);
-    }
+    terminal_update_cursor();
+}
+
+void terminal_putchar(char c) {
+    terminal_write(&c, 1);
+}
+
+// Add scrolling function to terminal.c
+void terminal_scroll(void) {
+    terminal_scroll_lines(1);
     
     // Set cursor to start of last line
     terminal_row = VGA_HEIGHT - 1;
 }
 
 void terminal_writestring(const char* data) {
-    for (size_t i = 0; data[i] != '\0'; i++)
-        terminal_putchar(data[i]);
+    size_t len = 0;
+    while (data[len] != '\0') {
+        len++;
+    }
+    terminal_write(data, len);
 }
\ No newline at end of file
@@ -0,0 +1,308 @@
+// src/trace.c
+#include "trace.h"
+#include "cpu.h"
+#include "hal_timer.h"
+#include "process.h"
+#include "terminal.h"
+#include "stdio.h"
+#include <stddef.h>
+
+// Serial output (kernel.c)
+void serial_print(const char* str);
+
+// Thread ids used for the non-process lanes in the exported trace
+#define TRACE_TID_TASKS 1000
+#define TRACE_TID_IRQ   1001
+#define TRACE_TID_SOFTIRQ 1002
+
+// Runtime switch tested by every trace point
+volatile uint32_t trace_enabled = 0;
+
+// Per-CPU rings
+static trace_ring_t trace_rings[TRACE_NR_CPUS];
+
+// Initialize the trace buffers
+void trace_init(void) {
+    trace_enabled = 0;
+    trace_clear();
+    
+    if (hal_timer_tsc_khz() == 0) {
+        terminal_writestring("Trace: TSC not calibrated, tracing unavailable\n");
+    }
+}
+
+// Record an event
+void trace_record(uint8_t type, uint32_t a, uint32_t b) {
+    uint32_t cpu = 0;
+    trace_ring_t* ring = &trace_rings[cpu];
+    
+    // Reserve a slot; safe against nesting interrupt handlers
+    uint32_t index = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    trace_event_t* ev = &ring->events[index & (TRACE_RING_SIZE - 1)];
+    
+    process_t* current = process_get_current();
+    
+    ev->type = 0;
+    ev->tsc = cpu_read_tsc();
+    ev->a = a;
+    ev->b = b;
+    ev->cpu = cpu;
+    ev->pid = current ? current->pid : 0;
+    __atomic_store_n(&ev->type, type, __ATOMIC_RELEASE);
+}
+
+// Start recording
+void trace_start(void) {
+    if (hal_timer_tsc_khz() == 0) {
+        terminal_writestring("Trace: not available\n");
+        return;
+    }
+    trace_enabled = 1;
+}
+
+// Stop recording
+void trace_stop(void) {
+    trace_enabled = 0;
+}
+
+// Discard recorded events
+void trace_clear(void) {
+    for (int cpu = 0; cpu < TRACE_NR_CPUS; cpu++) {
+        trace_rings[cpu].head = 0;
+        for (uint32_t i = 0; i < TRACE_RING_SIZE; i++) {
+            trace_rings[cpu].events[i].type = 0;
+        }
+    }
+}
+
+// Number of valid records held by a ring
+static uint32_t trace_ring_count(trace_ring_t* ring) {
+    return ring->head < TRACE_RING_SIZE ? ring->head : TRACE_RING_SIZE;
+}
+
+// Get the number of records held across all rings
+uint32_t trace_count(void) {
+    uint32_t total = 0;
+    for (int cpu = 0; cpu < TRACE_NR_CPUS; cpu++) {
+        total += trace_ring_count(&trace_rings[cpu]);
+    }
+    return total;
+}
+
+// Write an unsigned decimal number to the serial port
+static void trace_put_u32(uint32_t value) {
+    char buf[11];
+    int pos = 10;
+    buf[pos] = '\0';
+    
+    do {
+        buf[--pos] = '0' + (value % 10);
+        value /= 10;
+    } while (value);
+    
+    serial_print(&buf[pos]);
+}
+
+// Write a signed decimal number to the serial port
+static void trace_put_i32(int32_t value) {
+    if (value < 0) {
+        serial_print("-");
+        trace_put_u32(-(uint32_t)value);
+    } else {
+        trace_put_u32(value);
+    }
+}
+
+// Write a JSON string body, escaping quotes and backslashes
+static void trace_put_json_string(const char* str) {
+    char buf[2] = { 0, 0 };
+    
+    for (; str && *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            serial_print("\\");
+        }
+        buf[0] = (*str >= ' ') ? *str : '?';
+        serial_print(buf);
+    }
+}
+
+// Write a timestamp in microseconds with nanosecond fraction
+static void trace_put_timestamp(uint64_t cycles) {
+    uint64_t ns = hal_timer_tsc_to_ns(cycles);
+    uint32_t frac;
+    uint32_t us = (uint32_t)cpu_div64_32(ns, 1000, &frac);
+    
+    trace_put_u32(us);
+    serial_print(".");
+    serial_print(frac < 100 ? (frac < 10 ? "00" : "0") : "");
+    trace_put_u32(frac);
+}
+
+// Write the fields shared by every exported event
+static void trace_put_header(const char* name, uint32_t name_arg, const char* phase,
+                             uint64_t cycles, uint32_t cpu, uint32_t tid) {
+    serial_print(",\n{\"name\":\"");
+    trace_put_json_string(name);
+    if (name_arg != 0xFFFFFFFF) {
+        serial_print(" ");
+        trace_put_u32(name_arg);
+    }
+    serial_print("\",\"ph\":\"");
+    serial_print(phase);
+    serial_print("\",\"ts\":");
+    trace_put_timestamp(cycles);
+    serial_print(",\"pid\":");
+    trace_put_u32(cpu);
+    serial_print(",\"tid\":");
+    trace_put_u32(tid);
+}
+
+// Name a lane in the exported trace
+static void trace_put_thread_name(uint32_t cpu, uint32_t tid, const char* name) {
+    serial_print(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":");
+    trace_put_u32(cpu);
+    serial_print(",\"tid\":");
+    trace_put_u32(tid);
+    serial_print(",\"args\":{\"name\":\"");
+    trace_put_json_string(name);
+    serial_print("\"}}");
+}
+
+// Export one record
+static void trace_put_event(trace_event_t* ev, uint64_t cycles) {
+    switch (ev->type) {
+        case TRACE_EV_SCHED_SWITCH:
+            trace_put_header("pid", ev->a, "E", cycles, ev->cpu, ev->a);
+            serial_print("}");
+            trace_put_header("pid", ev->b, "B", cycles, ev->cpu, ev->b);
+            serial_print("}");
+            break;
+            
+        case TRACE_EV_SCHED_WAKEUP:
+            trace_put_header("wakeup", 0xFFFFFFFF, "i", cycles, ev->cpu, ev->a);
+            serial_print(",\"s\":\"t\"}");
+            break;
+            
+        case TRACE_EV_TASK_BEGIN:
+            trace_put_header((const char*)ev->b, 0xFFFFFFFF, "B", cycles, ev->cpu, TRACE_TID_TASKS);
+            serial_print("}");
+            break;
+            
+        case TRACE_EV_TASK_END:
+            trace_put_header("", 0xFFFFFFFF, "E", cycles, ev->cpu, TRACE_TID_TASKS);
+            serial_print(",\"args\":{\"result\":");
+            trace_put_u32(ev->b);
+            serial_print("}}");
+            break;
+            
+        case TRACE_EV_TASK_WAKEUP:
+            trace_put_header("wakeup", 0xFFFFFFFF, "i", cycles, ev->cpu, TRACE_TID_TASKS);
+            serial_print(",\"s\":\"t\",\"args\":{\"task\":\"");
+            trace_put_json_string((const char*)ev->b);
+            serial_print("\"}}");
+            break;
+            
+        case TRACE_EV_IRQ_ENTRY:
+            trace_put_header("vector", ev->a, "B", cycles, ev->cpu, TRACE_TID_IRQ);
+            serial_print("}");
+            break;
+            
+        case TRACE_EV_IRQ_EXIT:
+            trace_put_header("vector", ev->a, "E", cycles, ev->cpu, TRACE_TID_IRQ);
+            serial_print("}");
+            break;
+            
+        case TRACE_EV_SOFTIRQ_ENTRY:
+            trace_put_header("softirq", ev->a, "B", cycles, ev->cpu, TRACE_TID_SOFTIRQ);
+            serial_print("}");
+            break;
+            
+        case TRACE_EV_SOFTIRQ_EXIT:
+            trace_put_header("softirq", ev->a, "E", cycles, ev->cpu, TRACE_TID_SOFTIRQ);
+            serial_print("}");
+            break;
+            
+        case TRACE_EV_SYSCALL_ENTRY:
+            trace_put_header("syscall", ev->a, "B", cycles, ev->cpu, ev->pid);
+            serial_print(",\"args\":{\"arg0\":");
+            trace_put_u32(ev->b);
+            serial_print("}}");
+            break;
+            
+        case TRACE_EV_SYSCALL_EXIT:
+            trace_put_header("syscall", ev->a, "E", cycles, ev->cpu, ev->pid);
+            serial_print(",\"args\":{\"ret\":");
+            trace_put_i32((int32_t)ev->b);  // SYSCALL_E* codes are negative
+            serial_print("}}");
+            break;
+            
+        default:
+            break;
+    }
+}
+
+// Stream the rings over COM1 as Chrome trace-event JSON
+void trace_dump_serial(void) {
+    uint32_t was_enabled = trace_enabled;
+    trace_enabled = 0;
+    
+    // Timestamps are exported relative to the oldest record
+    uint64_t base = 0;
+    int have_base = 0;
+    for (int cpu = 0; cpu < TRACE_NR_CPUS; cpu++) {
+        trace_ring_t* ring = &trace_rings[cpu];
+        uint32_t count = trace_ring_count(ring);
+        if (count == 0) {
+            continue;
+        }
+        trace_event_t* oldest = &ring->events[(ring->head - count) & (TRACE_RING_SIZE - 1)];
+        if (!have_base || oldest->tsc < base) {
+            base = oldest->tsc;
+            have_base = 1;
+        }
+    }
+    
+    serial_print("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    serial_print("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"cpu0\"}}");
+    
+    uint32_t exported = 0;
+    for (int cpu = 0; cpu < TRACE_NR_CPUS; cpu++) {
+        trace_ring_t* ring = &trace_rings[cpu];
+        uint32_t count = trace_ring_count(ring);
+        uint32_t first = ring->head - count;
+        
+        trace_put_thread_name(cpu, TRACE_TID_TASKS, "tasks");
+        trace_put_thread_name(cpu, TRACE_TID_IRQ, "interrupts");
+        trace_put_thread_name(cpu, TRACE_TID_SOFTIRQ, "softirq");
+        
+        for (uint32_t i = 0; i < count; i++) {
+            trace_event_t* ev = &ring->events[(first + i) & (TRACE_RING_SIZE - 1)];
+            if (ev->type == 0) {
+                continue;
+            }
+            trace_put_event(ev, ev->tsc - base);
+            exported++;
+        }
+    }
+    
+    serial_print("\n]}\n");
+    
+    terminal_printf("Trace: %d events written to COM1\n", exported);
+    trace_enabled = was_enabled;
+}
+
+// Print trace status on the terminal
+void trace_status(void) {
+    terminal_printf("Trace: %s, %d events buffered (ring size %d)\n",
+                    trace_enabled ? "recording" : "stopped",
+                    trace_count(), TRACE_RING_SIZE);
+    if (hal_timer_tsc_khz()) {
+        terminal_printf("TSC: %d kHz\n", hal_timer_tsc_khz());
+    }
+    for (int cpu = 0; cpu < TRACE_NR_CPUS; cpu++) {
+        if (trace_rings[cpu].head > TRACE_RING_SIZE) {
+            terminal_printf("CPU%d: %d events overwritten\n", cpu,
+                            trace_rings[cpu].head - TRACE_RING_SIZE);
+        }
+    }
+}
@@ -0,0 +1,114 @@
+// src/uaccess.c
+#include "uaccess.h"
+#include "interrupts.h"
+#include "syscall.h"
+#include <stddef.h>
+
+uint32_t uaccess_user_origin = 0;
+
+// One entry per instruction that may fault on a user address
+typedef struct {
+    uint32_t insn;                   // Faulting instruction
+    uint32_t fixup;                  // Where to resume
+} ex_table_entry_t;
+
+// Bounds of the __ex_table section (linker.ld)
+extern const ex_table_entry_t __start___ex_table[];
+extern const ex_table_entry_t __stop___ex_table[];
+
+// Copy words then the tail; returns the number of bytes left uncopied
+static uint32_t copy_user_raw(void* to, const void* from, uint32_t size) {
+    uint32_t left, d0, d1;
+    
+    asm volatile("1:  rep movsl\n\t"
+                 "    movl %3, %%ecx\n"
+                 "2:  rep movsb\n"
+                 "3:\n\t"
+                 ".section .fixup, \"ax\"\n"
+                 "4:  leal (%3, %%ecx, 4), %%ecx\n\t"
+                 "    jmp 3b\n\t"
+                 ".previous\n\t"
+                 ".section __ex_table, \"a\"\n\t"
+                 ".align 4\n\t"
+                 ".long 1b, 4b\n\t"
+                 ".long 2b, 3b\n\t"
+                 ".previous"
+                 : "=&c"(left), "=&D"(d0), "=&S"(d1)
+                 : "r"(size & 3), "0"(size >> 2), "1"(to), "2"(from)
+                 : "memory");
+    
+    return left;
+}
+
+int copy_from_user(void* to, const void* from, uint32_t size) {
+    if (!access_ok((uint32_t)from, size)) {
+        return SYSCALL_EFAULT;
+    }
+    return copy_user_raw(to, from, size) ? SYSCALL_EFAULT : 0;
+}
+
+int copy_to_user(void* to, const void* from, uint32_t size) {
+    if (!access_ok((uint32_t)to, size)) {
+        return SYSCALL_EFAULT;
+    }
+    return copy_user_raw(to, from, size) ? SYSCALL_EFAULT : 0;
+}
+
+int strncpy_from_user(char* to, const char* from, uint32_t size) {
+    uint32_t addr = (uint32_t)from;
+    if (size == 0 || !access_ok(addr, 1)) {
+        return SYSCALL_EFAULT;
+    }
+    
+    // Never scan past the end of the window
+    uint32_t count = size;
+    if (count > uaccess_limit() - addr) {
+        count = uaccess_limit() - addr;
+    }
+    
+    int res;
+    uint32_t d0, d1, d2, d3;
+    asm volatile("0:  lodsb\n\t"
+                 "    stosb\n\t"
+                 "    testb %%al, %%al\n\t"
+                 "    jz 1f\n\t"
+                 "    decl %1\n\t"
+                 "    jnz 0b\n"
+                 "1:  subl %1, %0\n"
+                 "2:\n\t"
+                 ".section .fixup, \"ax\"\n"
+                 "3:  movl %5, %0\n\t"
+                 "    jmp 2b\n\t"
+                 ".previous\n\t"
+                 ".section __ex_table, \"a\"\n\t"
+                 ".align 4\n\t"
+                 ".long 0b, 3b\n\t"
+                 ".previous"
+                 : "=&d"(res), "=&c"(d0), "=&a"(d1), "=&S"(d2), "=&D"(d3)
+                 : "i"(SYSCALL_EFAULT), "0"(count), "1"(count), "3"(from), "4"(to)
+                 : "memory");
+    
+    if (res < 0) {
+        return res;
+    }
+    if ((uint32_t)res == count) {
+        // No terminator: too long, or the string runs off user space
+        return count < size ? SYSCALL_EFAULT : SYSCALL_EINVAL;
+    }
+    return res;
+}
+
+int uaccess_fixup(struct regs* r) {
+    // Kernel code only; the table is small enough for a linear search
+    if ((r->cs & 3) != 0) {
+        return 0;
+    }
+    
+    for (const ex_table_entry_t* e = __start___ex_table; e < __stop___ex_table; e++) {
+        if (e->insn == r->eip) {
+            r->eip = e->fixup;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+// src/vdso.c
+#include "vdso.h"
+#include "interrupts.h"
+#include "memory.h"
+#include "terminal.h"
+#include "stdio.h"
+
+vdso_page_t vdso_page __attribute__((aligned(VDSO_PAGE_SIZE)));
+
+// Writer side of the sequence lock; interrupts stay off so the tick
+// cannot nest inside another update
+static inline uint32_t vdso_write_begin(void) {
+    uint32_t flags = irq_save();
+    vdso_page.data.seq++;
+    asm volatile("" : : : "memory");
+    return flags;
+}
+
+static inline void vdso_write_end(uint32_t flags) {
+    asm volatile("" : : : "memory");
+    vdso_page.data.seq++;
+    irq_restore(flags);
+}
+
+void vdso_init(void) {
+    uint32_t flags = vdso_write_begin();
+    vdso_page.data.version = VDSO_VERSION;
+    vdso_write_end(flags);
+    
+    if (!paging_enabled()) {
+        terminal_writestring("vDSO: no paging, page not mapped\n");
+        return;
+    }
+    
+    // Read-only for user mode; the kernel keeps writing through its own mapping
+    if (map_page((uint32_t)&vdso_page, VDSO_USER_ADDR, MEM_PROT_READ | MEM_PROT_USER) != 0) {
+        terminal_writestring("vDSO: could not map the data page\n");
+        return;
+    }
+    
+    terminal_printf("vDSO data page at 0x%x\n", VDSO_USER_ADDR);
+}
+
+void vdso_set_clock(uint32_t tsc_khz, uint32_t ns_mult, uint32_t ns_shift, uint64_t tsc_base, uint32_t hz) {
+    uint32_t flags = vdso_write_begin();
+    vdso_page.data.tsc_khz = tsc_khz;
+    vdso_page.data.ns_mult = ns_mult;
+    vdso_page.data.ns_shift = ns_shift;
+    vdso_page.data.tsc_base = tsc_base;
+    vdso_page.data.hz = hz;
+    vdso_write_end(flags);
+}
+
+void vdso_tick(uint32_t ticks, uint64_t now_ns) {
+    uint32_t flags = vdso_write_begin();
+    vdso_page.data.ticks = ticks;
+    vdso_page.data.tick_ns = now_ns;
+    vdso_write_end(flags);
+}
+
+void vdso_set_pid(uint32_t pid) {
+    uint32_t flags = vdso_write_begin();
+    vdso_page.data.pid = pid;
+    vdso_write_end(flags);
+}
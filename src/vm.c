@@ -0,0 +1,165 @@
+// src/vm.c
+#include "vm.h"
+#include "memory.h"
+#include "interrupts.h"
+#include "string.h"
+#include "syscall.h"
+#include <stddef.h>
+
+// Page fault error code bits
+#define PF_PRESENT 0x01              // Protection violation, not a missing page
+#define PF_WRITE   0x02
+
+typedef struct {
+    uint32_t start;                  // Page-aligned bounds
+    uint32_t end;
+    uint32_t prot;                   // MEM_PROT_*
+    file_t* file;                    // Backing file, NULL for anonymous memory
+    uint32_t file_start;             // Addresses backed by the file
+    uint32_t file_end;
+    uint32_t offset;                 // File offset of file_start
+} vm_region_t;
+
+static vm_region_t regions[VM_MAX_REGIONS];
+static uint32_t region_count = 0;
+static vm_stats_t vm_stats;
+
+int vm_map(uint32_t start, uint32_t size, uint32_t prot, file_t* file, uint32_t offset, uint32_t file_size) {
+    if (size == 0 || file_size > size || start < USER_BASE || start > USER_TOP ||
+        size > USER_TOP - start) {
+        return SYSCALL_EINVAL;
+    }
+    if (region_count == VM_MAX_REGIONS) {
+        return SYSCALL_ENOMEM;
+    }
+    
+    uint32_t page_start = start & ~(PAGE_SIZE - 1);
+    uint32_t page_end = (start + size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    
+    // Every page must belong to exactly one region
+    for (uint32_t i = 0; i < region_count; i++) {
+        if (page_start < regions[i].end && regions[i].start < page_end) {
+            return SYSCALL_EINVAL;
+        }
+    }
+    
+    vm_region_t* region = &regions[region_count++];
+    region->start = page_start;
+    region->end = page_end;
+    region->prot = prot;
+    region->file = file_size ? file : NULL;
+    region->file_start = start;
+    region->file_end = start + file_size;
+    region->offset = offset;
+    if (region->file) {
+        file_get(region->file);
+    }
+    return 0;
+}
+
+static vm_region_t* vm_find_region(uint32_t addr) {
+    for (uint32_t i = 0; i < region_count; i++) {
+        if (addr >= regions[i].start && addr < regions[i].end) {
+            return &regions[i];
+        }
+    }
+    return NULL;
+}
+
+int vm_fault(uint32_t addr, uint32_t error_code) {
+    vm_region_t* region = vm_find_region(addr);
+    if (!region || (error_code & PF_PRESENT) ||
+        ((error_code & PF_WRITE) && !(region->prot & MEM_PROT_WRITE))) {
+        vm_stats.failed++;
+        return 0;
+    }
+    
+    uint32_t frame = page_frame_alloc();
+    if (!frame) {
+        vm_stats.failed++;
+        return 0;
+    }
+    
+    // Pool frames are identity mapped: fill the frame before it is visible
+    uint32_t page = addr & ~(PAGE_SIZE - 1);
+    memset((void*)frame, 0, PAGE_SIZE);
+    
+    uint32_t lo = page > region->file_start ? page : region->file_start;
+    uint32_t hi = page + PAGE_SIZE < region->file_end ? page + PAGE_SIZE : region->file_end;
+    if (region->file && lo < hi) {
+        // A short read leaves the rest zero, like BSS
+        file_pread(region->file, (void*)(frame + (lo - page)), hi - lo,
+                   region->offset + (lo - region->file_start));
+        vm_stats.file_pages++;
+    } else {
+        vm_stats.zero_pages++;
+    }
+    
+    if (map_page(frame, page, region->prot | MEM_PROT_USER) != 0) {
+        page_frame_free(frame);
+        vm_stats.failed++;
+        return 0;
+    }
+    
+    vm_stats.faults++;
+    vm_stats.resident++;
+    return 1;
+}
+
+uint32_t vm_detach_page(uint32_t addr) {
+    uint32_t page = addr & ~(PAGE_SIZE - 1);
+    uint32_t frame = get_physical_address(page);
+    if (!frame) {
+        if (!vm_fault(page, 0)) {
+            return 0;
+        }
+        frame = get_physical_address(page);
+    }
+    
+    unmap_page(page);
+    vm_stats.resident--;
+    return frame & ~(PAGE_SIZE - 1);
+}
+
+int vm_attach_page(uint32_t addr, uint32_t frame) {
+    vm_region_t* region = vm_find_region(addr);
+    if (!region || !(region->prot & MEM_PROT_WRITE)) {
+        return SYSCALL_EFAULT;
+    }
+    
+    uint32_t page = addr & ~(PAGE_SIZE - 1);
+    uint32_t old = get_physical_address(page);
+    if (map_page(frame, page, region->prot | MEM_PROT_USER) != 0) {
+        return SYSCALL_ENOMEM;
+    }
+    if (old) {
+        page_frame_free(old & ~(PAGE_SIZE - 1));
+    } else {
+        vm_stats.resident++;
+    }
+    return 0;
+}
+
+void vm_unmap_all(void) {
+    for (uint32_t i = 0; i < region_count; i++) {
+        vm_region_t* region = &regions[i];
+        for (uint32_t page = region->start; page < region->end; page += PAGE_SIZE) {
+            uint32_t frame = get_physical_address(page);
+            if (frame) {
+                unmap_page(page);
+                page_frame_free(frame & ~(PAGE_SIZE - 1));
+                vm_stats.resident--;
+            }
+        }
+        if (region->file) {
+            file_put(region->file);
+        }
+    }
+    region_count = 0;
+}
+
+void vm_get_stats(vm_stats_t* stats) {
+    uint32_t flags = irq_save();
+    *stats = vm_stats;
+    irq_restore(flags);
+}
@@ -0,0 +1,121 @@
+// src/wait_queue.c
+#include "wait_queue.h"
+#include "interrupts.h"
+#include <stddef.h>
+
+// Initialize a wait queue
+void wait_queue_init(wait_queue_t* wq) {
+    wq->head = NULL;
+    wq->tail = NULL;
+}
+
+// Initialize a wait queue entry with its wake callback
+void wait_queue_entry_init(wait_queue_entry_t* entry, void (*wake)(wait_queue_entry_t*), void* owner) {
+    entry->next = NULL;
+    entry->wake = wake;
+    entry->owner = owner;
+    entry->queued = 0;
+}
+
+// Add an entry to the tail of the queue
+void wait_queue_add(wait_queue_t* wq, wait_queue_entry_t* entry) {
+    uint32_t flags = irq_save();
+    
+    if (!entry->queued) {
+        entry->next = NULL;
+        if (wq->tail) {
+            wq->tail->next = entry;
+        } else {
+            wq->head = entry;
+        }
+        wq->tail = entry;
+        entry->queued = 1;
+    }
+    
+    irq_restore(flags);
+}
+
+// Remove an entry from the queue
+void wait_queue_remove(wait_queue_t* wq, wait_queue_entry_t* entry) {
+    uint32_t flags = irq_save();
+    
+    if (entry->queued) {
+        wait_queue_entry_t* prev = NULL;
+        wait_queue_entry_t* cur = wq->head;
+        
+        while (cur && cur != entry) {
+            prev = cur;
+            cur = cur->next;
+        }
+        
+        if (cur) {
+            if (prev) {
+                prev->next = cur->next;
+            } else {
+                wq->head = cur->next;
+            }
+            if (wq->tail == cur) {
+                wq->tail = prev;
+            }
+        }
+        
+        entry->next = NULL;
+        entry->queued = 0;
+    }
+    
+    irq_restore(flags);
+}
+
+// Detach the first waiter, or NULL if the queue is empty
+static wait_queue_entry_t* wait_queue_pop(wait_queue_t* wq) {
+    uint32_t flags = irq_save();
+    wait_queue_entry_t* entry = wq->head;
+    
+    if (entry) {
+        wq->head = entry->next;
+        if (!wq->head) {
+            wq->tail = NULL;
+        }
+        entry->next = NULL;
+        entry->queued = 0;
+    }
+    
+    irq_restore(flags);
+    return entry;
+}
+
+// Wake the first waiter
+int wait_queue_wake_one(wait_queue_t* wq) {
+    wait_queue_entry_t* entry = wait_queue_pop(wq);
+    
+    if (!entry) {
+        return 0;
+    }
+    
+    if (entry->wake) {
+        entry->wake(entry);
+    }
+    return 1;
+}
+
+// Wake every waiter
+int wait_queue_wake_all(wait_queue_t* wq) {
+    int woken = 0;
+    
+    // Waiters re-added by their wake callback go to the tail; bound the
+    // loop by what was queued on entry so they are not woken twice
+    wait_queue_entry_t* last = wq->tail;
+    wait_queue_entry_t* entry;
+    
+    while ((entry = wait_queue_pop(wq)) != NULL) {
+        if (entry->wake) {
+            entry->wake(entry);
+        }
+        woken++;
+        if (entry == last) {
+            break;
+        }
+    }
+    
+    return woken;
+}